@@ -0,0 +1,759 @@
+#include "EmulatorBackend.h"
+#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// I corpi JSON possono essere valori scalari, che QJsonDocument non accetta da soli
+QJsonValue parseValue(const QByteArray& text, bool* ok)
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson('[' + text + ']', &parseError);
+    *ok = parseError.error == QJsonParseError::NoError && doc.array().size() == 1;
+    return *ok ? doc.array().first() : QJsonValue();
+}
+
+// Ordinamento di Firebase: null < false < true < numeri < stringhe < oggetti
+int typeRank(const QJsonValue& value)
+{
+    switch (value.type()) {
+    case QJsonValue::Null:
+    case QJsonValue::Undefined:
+        return 0;
+    case QJsonValue::Bool:
+        return value.toBool() ? 2 : 1;
+    case QJsonValue::Double:
+        return 3;
+    case QJsonValue::String:
+        return 4;
+    default:
+        return 5;
+    }
+}
+
+int compareValues(const QJsonValue& a, const QJsonValue& b)
+{
+    const int rankA = typeRank(a);
+    const int rankB = typeRank(b);
+    if (rankA != rankB) {
+        return rankA < rankB ? -1 : 1;
+    }
+    if (a.isDouble()) {
+        return a.toDouble() < b.toDouble() ? -1 : (a.toDouble() > b.toDouble() ? 1 : 0);
+    }
+    if (a.isString()) {
+        return a.toString().compare(b.toString());
+    }
+    return 0;
+}
+
+} // namespace
+
+EmulatorBackend::EmulatorBackend()
+    : m_root(new Node)
+    , m_requireAuth(true)
+    , m_tokenLifetime(3600)
+    , m_requestCount(0)
+    , m_tokenSerial(0)
+    , m_random(m_conditions.seed)
+    , m_injectedFaults(0)
+    , m_unauthorizedCount(0)
+{
+}
+
+EmulatorBackend::~EmulatorBackend() = default;
+
+void EmulatorBackend::addUser(const QString& email, const QString& password)
+{
+    m_users.insert(email, password);
+}
+
+void EmulatorBackend::revokeTokens()
+{
+    m_idTokens.clear();
+}
+
+void EmulatorBackend::setConditions(const EmulatorConditions& conditions)
+{
+    m_conditions = conditions;
+    m_random.seed(conditions.seed);
+}
+
+void EmulatorBackend::setValue(const QString& path, const QJsonValue& value)
+{
+    assign(splitPath(path), resolveServerValues(value));
+}
+
+QJsonValue EmulatorBackend::value(const QString& path) const
+{
+    const Node* node = find(splitPath(path));
+    return node ? toJson(*node) : QJsonValue(QJsonValue::Null);
+}
+
+void EmulatorBackend::clear()
+{
+    m_root.reset(new Node);
+}
+
+// ==================== DISPATCH ====================
+
+EmulatorResponse EmulatorBackend::handle(const QByteArray& verb, const QUrl& url, const QByteArray& body,
+                                         const QHash<QByteArray, QByteArray>& headers)
+{
+    ++m_requestCount;
+
+    // Un solo numero casuale per richiesta: la sequenza dipende solo dal seed e dall'ordine
+    const double roll = m_random.generateDouble();
+    const bool isDatabase = url.path().endsWith(".json");
+
+    EmulatorResponse response;
+    if (roll < m_conditions.timeoutRate) {
+        response.dropped = true;
+        ++m_injectedFaults;
+        return response;
+    }
+    if (roll < m_conditions.timeoutRate + m_conditions.serverErrorRate) {
+        response = error(503, "Service Unavailable");
+        ++m_injectedFaults;
+    }
+    else if (isDatabase && roll < m_conditions.timeoutRate + m_conditions.serverErrorRate + m_conditions.unauthorizedRate) {
+        response = error(401, "Auth token is expired");
+        ++m_injectedFaults;
+        ++m_unauthorizedCount;
+    }
+    else {
+        response = route(verb, url, body, headers);
+    }
+
+    response.delayMs = m_conditions.latencyMs;
+    if (m_conditions.jitterMs > 0) {
+        response.delayMs += m_random.bounded(-m_conditions.jitterMs, m_conditions.jitterMs + 1);
+    }
+    response.delayMs = qMax(0, response.delayMs);
+    return response;
+}
+
+EmulatorResponse EmulatorBackend::route(const QByteArray& verb, const QUrl& url, const QByteArray& body,
+                                        const QHash<QByteArray, QByteArray>& headers)
+{
+    const QString path = url.path(QUrl::FullyDecoded);
+    const QUrlQuery query(url);
+
+    if (path.endsWith("/accounts:signInWithPassword")) {
+        return verb == "POST" ? handleSignIn(body) : error(405, "Method not allowed");
+    }
+    if (path.endsWith("/v1/token")) {
+        return verb == "POST" ? handleRefresh(body) : error(405, "Method not allowed");
+    }
+    if (!path.endsWith(".json")) {
+        return error(404, "Not found");
+    }
+
+    if (m_requireAuth && !isValidToken(query.queryItemValue("auth", QUrl::FullyDecoded))) {
+        ++m_unauthorizedCount;
+        return error(401, "Permission denied");
+    }
+
+    return handleDatabase(verb, splitPath(path.chopped(5)), query, body, headers);
+}
+
+EmulatorResponse EmulatorBackend::error(int status, const QString& message) const
+{
+    EmulatorResponse response;
+    response.status = status;
+    response.body = "{\"error\":";
+    writeString(message, response.body);
+    response.body += '}';
+    return response;
+}
+
+// ==================== REALTIME DATABASE ====================
+
+EmulatorResponse EmulatorBackend::handleDatabase(const QByteArray& verb, const QStringList& path, const QUrlQuery& query,
+                                                 const QByteArray& body, const QHash<QByteArray, QByteArray>& headers)
+{
+    EmulatorResponse response;
+
+    // ETag: hash del valore del nodo, richiesto con X-Firebase-ETag e verificato da if-match
+    const bool wantsEtag = headers.value("x-firebase-etag") == "true";
+    if (headers.contains("if-match")) {
+        if (verb != "PUT" && verb != "DELETE") {
+            return error(400, "if-match is only supported for PUT and DELETE");
+        }
+
+        const QByteArray current = serialize(path);
+        const QByteArray currentEtag = etagOf(current);
+        if (headers.value("if-match") != currentEtag) {
+            response.status = 412;
+            response.body = current;
+            response.headers.append({ "ETag", currentEtag });
+            return response;
+        }
+    }
+
+    if (verb == "GET" && wantsEtag) {
+        if (!query.isEmpty() && !(query.queryItems().size() == 1 && query.hasQueryItem("auth"))) {
+            return error(400, "X-Firebase-ETag is not supported with query parameters");
+        }
+        response.body = serialize(path);
+        response.headers.append({ "ETag", etagOf(response.body) });
+        return response;
+    }
+
+    if (verb == "GET") {
+        const Node* node = find(path);
+
+        if (!node) {
+            response.body = "null";
+            return response;
+        }
+
+        // shallow=true: solo le chiavi dei figli
+        if (query.queryItemValue("shallow") == "true") {
+            if (node->children.empty()) {
+                writeValue(node->leaf, response.body);
+                return response;
+            }
+            response.body = "{";
+            for (const auto& child : node->children) {
+                if (response.body.size() > 1) {
+                    response.body += ',';
+                }
+                writeString(child.first, response.body);
+                response.body += ":true";
+            }
+            response.body += '}';
+            return response;
+        }
+
+        if (!query.hasQueryItem("orderBy")) {
+            write(*node, response.body);
+            return response;
+        }
+
+        // Query ordinata: orderBy e i limiti arrivano codificati in JSON
+        bool ok = false;
+        const QString orderBy = parseValue(query.queryItemValue("orderBy", QUrl::FullyDecoded).toUtf8(), &ok).toString();
+        if (!ok || orderBy.isEmpty()) {
+            return error(400, "orderBy must be a valid JSON encoded path");
+        }
+
+        auto bound = [&query](const char* name, bool* present) {
+            bool valid = false;
+            *present = query.hasQueryItem(name);
+            return *present ? parseValue(query.queryItemValue(name, QUrl::FullyDecoded).toUtf8(), &valid) : QJsonValue();
+        };
+        bool hasEqual = false, hasStart = false, hasEnd = false;
+        const QJsonValue equalTo = bound("equalTo", &hasEqual);
+        const QJsonValue startAt = bound("startAt", &hasStart);
+        const QJsonValue endAt = bound("endAt", &hasEnd);
+
+        struct Entry
+        {
+            QJsonValue sortValue;
+            const QString* key;
+            const Node* node;
+        };
+        QList<Entry> entries;
+
+        for (const auto& child : node->children) {
+            QJsonValue sortValue;
+            if (orderBy == "$key") {
+                sortValue = child.first;
+            }
+            else if (orderBy == "$value") {
+                sortValue = child.second->leaf;
+            }
+            else {
+                const Node* field = child.second.get();
+                for (const QString& segment : splitPath(orderBy)) {
+                    if (!field) {
+                        break;
+                    }
+                    auto it = field->children.find(segment);
+                    field = it != field->children.end() ? it->second.get() : nullptr;
+                }
+                sortValue = field && field->children.empty() ? field->leaf : QJsonValue(QJsonValue::Null);
+            }
+
+            if ((hasEqual && compareValues(sortValue, equalTo) != 0)
+                || (hasStart && compareValues(sortValue, startAt) < 0)
+                || (hasEnd && compareValues(sortValue, endAt) > 0)) {
+                continue;
+            }
+            entries.append(Entry{ sortValue, &child.first, child.second.get() });
+        }
+
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return compareValues(a.sortValue, b.sortValue) < 0;
+        });
+
+        if (query.hasQueryItem("limitToFirst")) {
+            entries = entries.mid(0, query.queryItemValue("limitToFirst").toInt());
+        }
+        else if (query.hasQueryItem("limitToLast")) {
+            const int limit = query.queryItemValue("limitToLast").toInt();
+            entries = entries.mid(qMax(0, int(entries.size()) - limit));
+        }
+
+        response.body = "{";
+        for (const Entry& entry : std::as_const(entries)) {
+            if (response.body.size() > 1) {
+                response.body += ',';
+            }
+            writeString(*entry.key, response.body);
+            response.body += ':';
+            write(*entry.node, response.body);
+        }
+        response.body += '}';
+        return response;
+    }
+
+    bool ok = false;
+    const QJsonValue data = verb == "DELETE" ? QJsonValue(QJsonValue::Null) : parseValue(body, &ok);
+    if (verb != "DELETE" && !ok) {
+        return error(400, "Invalid data; couldn't parse JSON object, array, or value.");
+    }
+
+    if (verb == "PUT") {
+        const QJsonValue resolved = resolveServerValues(data);
+        assign(path, resolved);
+        writeValue(resolved, response.body);
+    }
+    else if (verb == "POST") {
+        // Chiave generata come i push id di Firebase: ordinabile per tempo di creazione
+        static const char alphabet[] = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+        QString key;
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        for (int i = 0; i < 8; ++i) {
+            key.prepend(QLatin1Char(alphabet[now % 64]));
+            now /= 64;
+        }
+        for (int i = 0; i < 12; ++i) {
+            key += QLatin1Char(alphabet[QRandomGenerator::global()->bounded(64)]);
+        }
+
+        assign(QStringList(path) << key, resolveServerValues(data));
+        response.body = "{\"name\":";
+        writeString(key, response.body);
+        response.body += '}';
+    }
+    else if (verb == "PATCH") {
+        if (!data.isObject()) {
+            return error(400, "Invalid data; PATCH requires an object.");
+        }
+
+        // Ogni chiave puo' essere un percorso relativo (aggiornamento multi-path, atomico)
+        const QJsonObject updates = resolveServerValues(data).toObject();
+        for (auto it = updates.begin(); it != updates.end(); ++it) {
+            assign(QStringList(path) << splitPath(it.key()), it.value());
+        }
+        writeValue(updates, response.body);
+    }
+    else if (verb == "DELETE") {
+        assign(path, QJsonValue::Null);
+        response.body = "null";
+    }
+    else {
+        return error(405, "Method not allowed");
+    }
+
+    if (wantsEtag) {
+        response.headers.append({ "ETag", etagOf(serialize(path)) });
+    }
+    return response;
+}
+
+QByteArray EmulatorBackend::serialize(const QStringList& path) const
+{
+    QByteArray out;
+    if (const Node* node = find(path)) {
+        write(*node, out);
+    }
+    else {
+        out = "null";
+    }
+    return out;
+}
+
+QByteArray EmulatorBackend::etagOf(const QByteArray& serialized)
+{
+    return QCryptographicHash::hash(serialized, QCryptographicHash::Sha1).toBase64();
+}
+
+// ==================== AUTH ====================
+
+QString EmulatorBackend::issueToken(const QString& userId)
+{
+    const QString token = QString("emu.%1.%2.%3")
+        .arg(userId)
+        .arg(++m_tokenSerial)
+        .arg(QRandomGenerator::global()->generate64(), 0, 16);
+    m_idTokens.insert(token, QDateTime::currentDateTimeUtc().addSecs(m_tokenLifetime));
+    return token;
+}
+
+bool EmulatorBackend::isValidToken(const QString& token) const
+{
+    auto it = m_idTokens.constFind(token);
+    return it != m_idTokens.constEnd() && it.value() > QDateTime::currentDateTimeUtc();
+}
+
+EmulatorResponse EmulatorBackend::handleSignIn(const QByteArray& body)
+{
+    const QJsonObject request = QJsonDocument::fromJson(body).object();
+    const QString email = request["email"].toString();
+    const QString password = request["password"].toString();
+
+    auto authError = [](const QString& message) {
+        EmulatorResponse response;
+        response.status = 400;
+        response.body = QJsonDocument(QJsonObject{
+            { "error", QJsonObject{ { "code", 400 }, { "message", message } } }
+        }).toJson(QJsonDocument::Compact);
+        return response;
+    };
+
+    if (email.isEmpty()) {
+        return authError("INVALID_EMAIL");
+    }
+    if (!m_users.isEmpty()) {
+        if (!m_users.contains(email)) {
+            return authError("EMAIL_NOT_FOUND");
+        }
+        if (m_users.value(email) != password) {
+            return authError("INVALID_PASSWORD");
+        }
+    }
+
+    const QString userId = QString::fromLatin1(
+        QCryptographicHash::hash(email.toUtf8(), QCryptographicHash::Sha1).toHex().left(28));
+    const QString refreshToken = QString("emu-refresh.%1.%2").arg(userId).arg(++m_tokenSerial);
+    m_refreshTokens.insert(refreshToken, userId);
+
+    EmulatorResponse response;
+    response.body = QJsonDocument(QJsonObject{
+        { "kind", "identitytoolkit#VerifyPasswordResponse" },
+        { "localId", userId },
+        { "email", email },
+        { "displayName", "" },
+        { "idToken", issueToken(userId) },
+        { "registered", true },
+        { "refreshToken", refreshToken },
+        { "expiresIn", QString::number(m_tokenLifetime) }
+    }).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+EmulatorResponse EmulatorBackend::handleRefresh(const QByteArray& body)
+{
+    // securetoken accetta sia form-urlencoded sia JSON
+    QString grantType;
+    QString refreshToken;
+    if (body.trimmed().startsWith('{')) {
+        const QJsonObject request = QJsonDocument::fromJson(body).object();
+        grantType = request["grant_type"].toString();
+        refreshToken = request["refresh_token"].toString();
+    }
+    else {
+        const QUrlQuery form(QString::fromUtf8(body));
+        grantType = form.queryItemValue("grant_type", QUrl::FullyDecoded);
+        refreshToken = form.queryItemValue("refresh_token", QUrl::FullyDecoded);
+    }
+
+    if (grantType != "refresh_token" || !m_refreshTokens.contains(refreshToken)) {
+        EmulatorResponse response;
+        response.status = 400;
+        response.body = "{\"error\":{\"code\":400,\"message\":\"INVALID_REFRESH_TOKEN\"}}";
+        return response;
+    }
+
+    const QString userId = m_refreshTokens.value(refreshToken);
+    const QString idToken = issueToken(userId);
+
+    EmulatorResponse response;
+    response.body = QJsonDocument(QJsonObject{
+        { "access_token", idToken },
+        { "expires_in", QString::number(m_tokenLifetime) },
+        { "token_type", "Bearer" },
+        { "refresh_token", refreshToken },
+        { "id_token", idToken },
+        { "user_id", userId },
+        { "project_id", "emulator" }
+    }).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+// ==================== TREE ====================
+
+QStringList EmulatorBackend::splitPath(const QString& path)
+{
+    return path.split('/', Qt::SkipEmptyParts);
+}
+
+EmulatorBackend::Node* EmulatorBackend::find(const QStringList& path) const
+{
+    Node* node = m_root.get();
+    for (const QString& segment : path) {
+        auto it = node->children.find(segment);
+        if (it == node->children.end()) {
+            return nullptr;
+        }
+        node = it->second.get();
+    }
+    return node;
+}
+
+QJsonValue EmulatorBackend::resolveServerValues(const QJsonValue& value) const
+{
+    if (value.isObject()) {
+        QJsonObject object = value.toObject();
+        if (object.size() == 1 && object.value(".sv") == QJsonValue("timestamp")) {
+            return double(QDateTime::currentMSecsSinceEpoch());
+        }
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            it.value() = resolveServerValues(it.value());
+        }
+        return object;
+    }
+    if (value.isArray()) {
+        QJsonArray array = value.toArray();
+        for (int i = 0; i < array.size(); ++i) {
+            array[i] = resolveServerValues(array.at(i));
+        }
+        return array;
+    }
+    return value;
+}
+
+std::unique_ptr<EmulatorBackend::Node> EmulatorBackend::build(const QJsonValue& value) const
+{
+    auto node = std::make_unique<Node>();
+
+    auto addChild = [&node, this](const QString& key, const QJsonValue& child) {
+        std::unique_ptr<Node> built = build(child);
+        if (built) {
+            node->children.emplace(key, std::move(built));
+        }
+    };
+
+    if (value.isObject()) {
+        const QJsonObject object = value.toObject();
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            addChild(it.key(), it.value());
+        }
+    }
+    else if (value.isArray()) {
+        const QJsonArray array = value.toArray();
+        for (int i = 0; i < array.size(); ++i) {
+            addChild(QString::number(i), array.at(i));
+        }
+    }
+    else if (!value.isNull() && !value.isUndefined()) {
+        node->leaf = value;
+        return node;
+    }
+
+    // Firebase non memorizza nodi vuoti
+    if (node->children.empty()) {
+        return nullptr;
+    }
+    return node;
+}
+
+void EmulatorBackend::assign(const QStringList& path, const QJsonValue& value)
+{
+    std::unique_ptr<Node> built = build(value);
+
+    if (path.isEmpty()) {
+        m_root = built ? std::move(built) : std::make_unique<Node>();
+        return;
+    }
+
+    if (!built) {
+        prune(path);
+        return;
+    }
+
+    Node* node = m_root.get();
+    for (int i = 0; i < path.size() - 1; ++i) {
+        node->leaf = QJsonValue();
+        std::unique_ptr<Node>& child = node->children[path.at(i)];
+        if (!child) {
+            child = std::make_unique<Node>();
+        }
+        node = child.get();
+    }
+    node->leaf = QJsonValue();
+    node->children[path.last()] = std::move(built);
+}
+
+void EmulatorBackend::prune(const QStringList& path)
+{
+    // Rimuove il nodo e poi gli antenati rimasti vuoti
+    for (int depth = path.size(); depth > 0; --depth) {
+        Node* parent = find(path.mid(0, depth - 1));
+        if (!parent) {
+            continue;
+        }
+        auto it = parent->children.find(path.at(depth - 1));
+        if (it == parent->children.end()) {
+            continue;
+        }
+        if (depth < path.size() && !it->second->children.empty()) {
+            return;
+        }
+        parent->children.erase(it);
+    }
+}
+
+// ==================== SERIALIZATION ====================
+
+int EmulatorBackend::arrayLength(const Node& node)
+{
+    // Come Firebase: chiavi tutte intere e almeno meta' degli indici occupati -> array JSON
+    int maxIndex = -1;
+    for (const auto& child : node.children) {
+        bool isIndex = false;
+        const int index = child.first.toInt(&isIndex);
+        if (!isIndex || index < 0 || QString::number(index) != child.first) {
+            return -1;
+        }
+        maxIndex = qMax(maxIndex, index);
+    }
+    return maxIndex < 2 * int(node.children.size()) ? maxIndex + 1 : -1;
+}
+
+QJsonValue EmulatorBackend::toJson(const Node& node) const
+{
+    if (node.children.empty()) {
+        return node.leaf.isUndefined() ? QJsonValue(QJsonValue::Null) : node.leaf;
+    }
+
+    const int length = arrayLength(node);
+    if (length >= 0) {
+        QJsonArray array;
+        for (int i = 0; i < length; ++i) {
+            auto it = node.children.find(QString::number(i));
+            array.append(it != node.children.end() ? toJson(*it->second) : QJsonValue(QJsonValue::Null));
+        }
+        return array;
+    }
+
+    QJsonObject object;
+    for (const auto& child : node.children) {
+        object.insert(child.first, toJson(*child.second));
+    }
+    return object;
+}
+
+void EmulatorBackend::write(const Node& node, QByteArray& out)
+{
+    if (node.children.empty()) {
+        writeValue(node.leaf, out);
+        return;
+    }
+
+    const int length = arrayLength(node);
+    if (length >= 0) {
+        out += '[';
+        for (int i = 0; i < length; ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            auto it = node.children.find(QString::number(i));
+            if (it != node.children.end()) {
+                write(*it->second, out);
+            }
+            else {
+                out += "null";
+            }
+        }
+        out += ']';
+        return;
+    }
+
+    out += '{';
+    bool first = true;
+    for (const auto& child : node.children) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        writeString(child.first, out);
+        out += ':';
+        write(*child.second, out);
+    }
+    out += '}';
+}
+
+void EmulatorBackend::writeValue(const QJsonValue& value, QByteArray& out)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        out += value.toBool() ? "true" : "false";
+        break;
+    case QJsonValue::Double: {
+        const double number = value.toDouble();
+        if (std::floor(number) == number && std::abs(number) < 9007199254740992.0) {
+            out += QByteArray::number(qint64(number));
+        }
+        else {
+            out += QByteArray::number(number, 'g', 17);
+        }
+        break;
+    }
+    case QJsonValue::String:
+        writeString(value.toString(), out);
+        break;
+    case QJsonValue::Object:
+        out += QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+        break;
+    case QJsonValue::Array:
+        out += QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+        break;
+    default:
+        out += "null";
+        break;
+    }
+}
+
+void EmulatorBackend::writeString(const QString& text, QByteArray& out)
+{
+    out += '"';
+    const QByteArray utf8 = text.toUtf8();
+    for (char c : utf8) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out += QByteArray::number(static_cast<unsigned char>(c), 16).rightJustified(2, '0');
+            }
+            else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef EMULATORBACKEND_H
+#define EMULATORBACKEND_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonValue>
+#include <QList>
+#include <QPair>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QUrlQuery>
+#include <map>
+#include <memory>
+
+/**
+ * @brief Risposta HTTP prodotta dal backend emulato
+ */
+struct EmulatorResponse
+{
+    int status = 200;
+    QByteArray body;
+    QByteArray contentType = "application/json; charset=utf-8";
+    QList<QPair<QByteArray, QByteArray>> headers;
+    int delayMs = 0;      // latenza iniettata prima della risposta
+    bool dropped = false; // timeout iniettato: la risposta non arriva mai
+};
+
+/**
+ * @brief Condizioni di rete e guasti iniettati, applicati da entrambi i trasporti
+ * Le frazioni sono probabilita' per richiesta; con lo stesso seed la sequenza di guasti si ripete
+ */
+struct EmulatorConditions
+{
+    int latencyMs = 0;           // ritardo prima di ogni risposta
+    int jitterMs = 0;            // variazione casuale (+/-) sul ritardo
+    qint64 bytesPerSecond = 0;   // banda in download, 0 = illimitata
+    double unauthorizedRate = 0; // richieste al database che ricevono 401 (token "scaduto")
+    double serverErrorRate = 0;  // richieste che ricevono 503
+    double timeoutRate = 0;      // richieste a cui non si risponde mai
+    quint32 seed = 1;
+};
+
+/**
+ * @brief Emulazione in memoria delle API REST usate da FirebaseDatabaseManager
+ * - Realtime Database: GET/PUT/POST/PATCH/DELETE su <path>.json, parametro auth,
+ *   orderBy/equalTo/startAt/endAt/limitToFirst/shallow, {".sv":"timestamp"}, PATCH multi-path,
+ *   X-Firebase-ETag e if-match (scritture condizionali, 412 con valore ed ETag correnti)
+ * - Auth: accounts:signInWithPassword e securetoken (refresh del token)
+ * - Condizioni iniettabili (EmulatorConditions): latenza, banda, 401, 503, timeout
+ * Le richieste vengono instradate per percorso, quindi lo stesso backend serve sia
+ * un QNetworkAccessManager finto (in-process) sia il server HTTP locale (EmulatorServer)
+ */
+class EmulatorBackend
+{
+public:
+    EmulatorBackend();
+    ~EmulatorBackend();
+
+    // Configuration
+    void setRequireAuth(bool required) { m_requireAuth = required; }
+    void addUser(const QString& email, const QString& password); // senza utenti ogni login e' accettato
+    void setTokenLifetime(int seconds) { m_tokenLifetime = seconds; }
+    void revokeTokens(); // i token emessi diventano invalidi (401 alla prossima richiesta)
+    void setConditions(const EmulatorConditions& conditions);
+    const EmulatorConditions& conditions() const { return m_conditions; }
+
+    // Data
+    void setValue(const QString& path, const QJsonValue& value);
+    QJsonValue value(const QString& path) const;
+    void clear();
+
+    // Statistics
+    qint64 requestCount() const { return m_requestCount; }
+    qint64 injectedFaultCount() const { return m_injectedFaults; }
+    qint64 unauthorizedCount() const { return m_unauthorizedCount; } // 401 inviati, iniettati o per token scaduto
+
+    // Dispatch: verbo, URL completo (host ignorato), corpo della richiesta, header (nomi in minuscolo)
+    EmulatorResponse handle(const QByteArray& verb, const QUrl& url, const QByteArray& body,
+                            const QHash<QByteArray, QByteArray>& headers = QHash<QByteArray, QByteArray>());
+
+private:
+    struct Node
+    {
+        QJsonValue leaf; // valido solo se children e' vuoto
+        std::map<QString, std::unique_ptr<Node>> children;
+    };
+
+    EmulatorResponse route(const QByteArray& verb, const QUrl& url, const QByteArray& body,
+                           const QHash<QByteArray, QByteArray>& headers);
+    EmulatorResponse handleDatabase(const QByteArray& verb, const QStringList& path, const QUrlQuery& query,
+                                     const QByteArray& body, const QHash<QByteArray, QByteArray>& headers);
+    EmulatorResponse handleSignIn(const QByteArray& body);
+    EmulatorResponse handleRefresh(const QByteArray& body);
+    EmulatorResponse error(int status, const QString& message) const;
+
+    QString issueToken(const QString& userId);
+    bool isValidToken(const QString& token) const;
+
+    static QStringList splitPath(const QString& path);
+    Node* find(const QStringList& path) const;
+    void assign(const QStringList& path, const QJsonValue& value);
+    void prune(const QStringList& path);
+    std::unique_ptr<Node> build(const QJsonValue& value) const;
+    QJsonValue resolveServerValues(const QJsonValue& value) const;
+
+    QByteArray serialize(const QStringList& path) const; // "null" se il nodo non esiste
+    static QByteArray etagOf(const QByteArray& serialized);
+    QJsonValue toJson(const Node& node) const;
+    static int arrayLength(const Node& node); // -1 se i figli non vengono restituiti come array
+    static void write(const Node& node, QByteArray& out);
+    static void writeValue(const QJsonValue& value, QByteArray& out);
+    static void writeString(const QString& text, QByteArray& out);
+
+    std::unique_ptr<Node> m_root;
+    QHash<QString, QString> m_users;          // email -> password
+    QHash<QString, QDateTime> m_idTokens;     // token -> scadenza
+    QHash<QString, QString> m_refreshTokens;  // refresh token -> userId
+    bool m_requireAuth;
+    int m_tokenLifetime;
+    qint64 m_requestCount;
+    quint64 m_tokenSerial;
+    EmulatorConditions m_conditions;
+    QRandomGenerator m_random;
+    qint64 m_injectedFaults;
+    qint64 m_unauthorizedCount;
+};
+
+#endif // EMULATORBACKEND_H
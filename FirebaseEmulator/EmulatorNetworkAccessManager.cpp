@@ -0,0 +1,171 @@
+#include "EmulatorNetworkAccessManager.h"
+#include <QTimer>
+#include <cstring>
+
+namespace {
+
+QNetworkReply::NetworkError errorForStatus(int status)
+{
+    switch (status) {
+    case 400:
+        return QNetworkReply::ProtocolInvalidOperationError;
+    case 401:
+        return QNetworkReply::AuthenticationRequiredError;
+    case 403:
+        return QNetworkReply::ContentAccessDenied;
+    case 404:
+        return QNetworkReply::ContentNotFoundError;
+    case 405:
+        return QNetworkReply::ContentOperationNotPermittedError;
+    case 503:
+        return QNetworkReply::ServiceUnavailableError;
+    default:
+        if (status >= 500) {
+            return QNetworkReply::InternalServerError;
+        }
+        return status >= 400 ? QNetworkReply::UnknownContentError : QNetworkReply::NoError;
+    }
+}
+
+QByteArray verbFor(QNetworkAccessManager::Operation op, const QNetworkRequest& request)
+{
+    switch (op) {
+    case QNetworkAccessManager::HeadOperation:
+        return "HEAD";
+    case QNetworkAccessManager::GetOperation:
+        return "GET";
+    case QNetworkAccessManager::PutOperation:
+        return "PUT";
+    case QNetworkAccessManager::PostOperation:
+        return "POST";
+    case QNetworkAccessManager::DeleteOperation:
+        return "DELETE";
+    default:
+        return request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray();
+    }
+}
+
+} // namespace
+
+// ==================== EmulatorNetworkAccessManager ====================
+
+EmulatorNetworkAccessManager::EmulatorNetworkAccessManager(EmulatorBackend* backend, QObject* parent)
+    : QNetworkAccessManager(parent)
+    , m_backend(backend)
+    , m_chunkSize(64 * 1024)
+{
+}
+
+QNetworkReply* EmulatorNetworkAccessManager::createRequest(Operation op, const QNetworkRequest& request, QIODevice* outgoingData)
+{
+    const QByteArray body = outgoingData ? outgoingData->readAll() : QByteArray();
+    QHash<QByteArray, QByteArray> headers;
+    for (const QByteArray& name : request.rawHeaderList()) {
+        headers.insert(name.toLower(), request.rawHeader(name));
+    }
+    const EmulatorResponse response = m_backend->handle(verbFor(op, request), request.url(), body, headers);
+
+    return new EmulatorReply(op, request, response, m_chunkSize, m_backend->conditions().bytesPerSecond, this);
+}
+
+// ==================== EmulatorReply ====================
+
+EmulatorReply::EmulatorReply(QNetworkAccessManager::Operation op, const QNetworkRequest& request,
+                             const EmulatorResponse& response, qint64 chunkSize, qint64 bytesPerSecond,
+                             QObject* parent)
+    : QNetworkReply(parent)
+    , m_body(response.body)
+    , m_offset(0)
+    , m_available(0)
+    , m_chunkSize(qMax<qint64>(1, chunkSize))
+    , m_chunkIntervalMs(0)
+    , m_aborted(false)
+{
+    if (bytesPerSecond > 0) {
+        // Blocchi da circa 50 ms di banda
+        m_chunkSize = qMin(m_chunkSize, qMax<qint64>(1024, bytesPerSecond / 20));
+        m_chunkIntervalMs = int(m_chunkSize * 1000 / bytesPerSecond);
+    }
+
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, response.status);
+    setHeader(QNetworkRequest::ContentTypeHeader, response.contentType);
+    setHeader(QNetworkRequest::ContentLengthHeader, m_body.size());
+    for (const auto& header : response.headers) {
+        setRawHeader(header.first, header.second);
+    }
+
+    const NetworkError networkError = errorForStatus(response.status);
+    if (networkError != NoError) {
+        setError(networkError, QString("Emulator returned HTTP %1").arg(response.status));
+    }
+
+    // Timeout iniettato: la reply resta aperta finche' il chiamante non la abortisce
+    if (response.dropped) {
+        return;
+    }
+
+    // Come una reply reale: nessun segnale prima che il chiamante abbia collegato i suoi slot
+    QTimer::singleShot(response.delayMs, this, [this]() {
+        emit metaDataChanged();
+        deliverChunk();
+    });
+}
+
+void EmulatorReply::deliverChunk()
+{
+    if (m_aborted) {
+        return;
+    }
+
+    if (m_available < m_body.size()) {
+        m_available = qMin<qint64>(m_body.size(), m_available + m_chunkSize);
+        emit readyRead();
+        emit downloadProgress(m_available, m_body.size());
+    }
+
+    if (m_available < m_body.size()) {
+        QTimer::singleShot(m_chunkIntervalMs, this, &EmulatorReply::deliverChunk);
+        return;
+    }
+
+    if (error() != NoError) {
+        emit errorOccurred(error());
+    }
+    setFinished(true);
+    emit finished();
+}
+
+void EmulatorReply::abort()
+{
+    if (m_aborted || isFinished()) {
+        return;
+    }
+
+    m_aborted = true;
+    setError(OperationCanceledError, "Operation canceled");
+    emit errorOccurred(OperationCanceledError);
+    setFinished(true);
+    emit finished();
+}
+
+qint64 EmulatorReply::bytesAvailable() const
+{
+    return m_available - m_offset + QNetworkReply::bytesAvailable();
+}
+
+qint64 EmulatorReply::readData(char* data, qint64 maxSize)
+{
+    const qint64 count = qMin(maxSize, m_available - m_offset);
+    if (count <= 0) {
+        return m_available < m_body.size() ? 0 : -1;
+    }
+
+    std::memcpy(data, m_body.constData() + m_offset, count);
+    m_offset += count;
+    return count;
+}
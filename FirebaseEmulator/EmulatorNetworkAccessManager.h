@@ -0,0 +1,65 @@
+#pragma once
+#ifndef EMULATORNETWORKACCESSMANAGER_H
+#define EMULATORNETWORKACCESSMANAGER_H
+
+#include "EmulatorBackend.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+/**
+ * @brief QNetworkAccessManager in-process che risponde con EmulatorBackend
+ * Nessun socket: le risposte arrivano a blocchi sull'event loop, con gli stessi
+ * segnali di una QNetworkReply reale (readyRead, downloadProgress, finished).
+ * Latenza, banda e timeout iniettati nel backend vengono rispettati
+ */
+class EmulatorNetworkAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    explicit EmulatorNetworkAccessManager(EmulatorBackend* backend, QObject* parent = nullptr);
+
+    EmulatorBackend* backend() const { return m_backend; }
+
+    // Dimensione dei blocchi consegnati a ogni giro dell'event loop
+    void setChunkSize(qint64 bytes) { m_chunkSize = bytes; }
+
+protected:
+    QNetworkReply* createRequest(Operation op, const QNetworkRequest& request, QIODevice* outgoingData) override;
+
+private:
+    EmulatorBackend* m_backend;
+    qint64 m_chunkSize;
+};
+
+/**
+ * @brief Risposta gia' pronta, consegnata a blocchi come se arrivasse dalla rete
+ */
+class EmulatorReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    EmulatorReply(QNetworkAccessManager::Operation op, const QNetworkRequest& request,
+                  const EmulatorResponse& response, qint64 chunkSize, qint64 bytesPerSecond,
+                  QObject* parent = nullptr);
+
+    void abort() override;
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+
+private:
+    void deliverChunk();
+
+    QByteArray m_body;
+    qint64 m_offset;     // byte gia' letti
+    qint64 m_available;  // byte gia' "arrivati"
+    qint64 m_chunkSize;
+    int m_chunkIntervalMs; // pausa tra due blocchi per rispettare la banda
+    bool m_aborted;
+};
+
+#endif // EMULATORNETWORKACCESSMANAGER_H
@@ -0,0 +1,252 @@
+#include "EmulatorServer.h"
+#include <QTimer>
+
+namespace {
+
+const qint64 MaxRequestBytes = 64 * 1024 * 1024;
+
+} // namespace
+
+EmulatorServer::EmulatorServer(EmulatorBackend* backend, QObject* parent)
+    : QObject(parent)
+    , m_backend(backend)
+{
+    QObject::connect(&m_server, &QTcpServer::newConnection, this, &EmulatorServer::acceptConnections);
+}
+
+EmulatorServer::~EmulatorServer()
+{
+    close();
+}
+
+bool EmulatorServer::listen(const QHostAddress& address, quint16 port)
+{
+    return m_server.listen(address, port);
+}
+
+void EmulatorServer::close()
+{
+    m_server.close();
+
+    const QList<QTcpSocket*> sockets = m_connections.keys();
+    m_connections.clear();
+    for (QTcpSocket* socket : sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+}
+
+bool EmulatorServer::isListening() const
+{
+    return m_server.isListening();
+}
+
+quint16 EmulatorServer::port() const
+{
+    return m_server.serverPort();
+}
+
+QString EmulatorServer::baseUrl() const
+{
+    QHostAddress address = m_server.serverAddress();
+    if (address == QHostAddress::Any || address == QHostAddress::AnyIPv4) {
+        address = QHostAddress::LocalHost;
+    }
+
+    const QString host = address.protocol() == QAbstractSocket::IPv6Protocol
+        ? QString("[%1]").arg(address.toString())
+        : address.toString();
+    return QString("http://%1:%2").arg(host).arg(port());
+}
+
+QString EmulatorServer::errorString() const
+{
+    return m_server.errorString();
+}
+
+void EmulatorServer::acceptConnections()
+{
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        m_connections.insert(socket, Connection());
+
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it == m_connections.end()) {
+                return;
+            }
+            it->buffer += socket->readAll();
+            processRequests(socket);
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+// ==================== PARSING ====================
+
+void EmulatorServer::processRequests(QTcpSocket* socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end() || it->busy) {
+        return;
+    }
+    Connection& connection = *it;
+
+    const qsizetype headerEnd = connection.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (connection.buffer.size() > MaxRequestBytes) {
+            socket->abort();
+        }
+        return;
+    }
+
+    const QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() != 3) {
+        socket->abort();
+        return;
+    }
+
+    QHash<QByteArray, QByteArray> headers;
+    for (qsizetype i = 1; i < lines.size(); ++i) {
+        const qsizetype colon = lines.at(i).indexOf(':');
+        if (colon > 0) {
+            headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+        }
+    }
+
+    // Il manager invia sempre corpi di dimensione nota: niente chunked encoding
+    if (headers.contains("transfer-encoding")) {
+        EmulatorResponse response;
+        response.status = 411;
+        response.body = "{\"error\":\"Length Required\"}";
+        connection.buffer.clear();
+        connection.busy = true;
+        connection.closeAfter = true;
+        respond(socket, response);
+        return;
+    }
+
+    const qint64 contentLength = headers.value("content-length", "0").toLongLong();
+    const qint64 requestSize = headerEnd + 4 + contentLength;
+    if (connection.buffer.size() < requestSize) {
+        return;
+    }
+
+    const QByteArray verb = requestLine.at(0);
+    const QByteArray target = requestLine.at(1);
+    const QByteArray body = connection.buffer.mid(headerEnd + 4, contentLength);
+    connection.buffer.remove(0, requestSize);
+    connection.busy = true;
+    connection.closeAfter = headers.value("connection").toLower() == "close"
+        || requestLine.at(2) == "HTTP/1.0";
+
+    const QUrl url = QUrl::fromEncoded("http://emulator" + target);
+    const EmulatorResponse response = m_backend->handle(verb, url, body, headers);
+
+    if (response.dropped) {
+        // Timeout iniettato: nessuna risposta, il client scadra' e chiudera' la connessione
+        return;
+    }
+
+    if (headers.value("accept").contains("text/event-stream") && response.status == 200) {
+        respondEventStream(socket, response);
+        return;
+    }
+
+    respond(socket, response);
+}
+
+// ==================== RESPONSES ====================
+
+void EmulatorServer::respond(QTcpSocket* socket, const EmulatorResponse& response)
+{
+    QTimer::singleShot(response.delayMs, socket, [this, socket, response]() {
+        QByteArray head = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n";
+        head += "Content-Type: " + response.contentType + "\r\n";
+        head += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+        for (const auto& header : response.headers) {
+            head += header.first + ": " + header.second + "\r\n";
+        }
+        head += m_connections.value(socket).closeAfter ? "Connection: close\r\n" : "Connection: keep-alive\r\n";
+        head += "\r\n";
+
+        socket->write(head);
+        writeBody(socket, response.body, 0);
+    });
+}
+
+void EmulatorServer::respondEventStream(QTcpSocket* socket, const EmulatorResponse& snapshot)
+{
+    // Connessione dedicata allo stream: resta occupata finche' il client non la chiude
+    QTimer::singleShot(snapshot.delayMs, socket, [socket, snapshot]() {
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/event-stream; charset=utf-8\r\n"
+                      "Cache-Control: no-cache\r\n"
+                      "Connection: keep-alive\r\n"
+                      "\r\n");
+        socket->write("event: put\ndata: {\"path\":\"/\",\"data\":" + snapshot.body + "}\n\n");
+    });
+}
+
+void EmulatorServer::writeBody(QTcpSocket* socket, const QByteArray& body, qint64 offset)
+{
+    const qint64 bytesPerSecond = m_backend->conditions().bytesPerSecond;
+    if (bytesPerSecond <= 0) {
+        socket->write(body.constData() + offset, body.size() - offset);
+        finishResponse(socket);
+        return;
+    }
+
+    // Banda limitata: un blocco ogni 50 ms circa
+    const qint64 chunk = qMin(body.size() - offset, qMax<qint64>(1024, bytesPerSecond / 20));
+    socket->write(body.constData() + offset, chunk);
+    offset += chunk;
+
+    if (offset >= body.size()) {
+        finishResponse(socket);
+        return;
+    }
+
+    QTimer::singleShot(int(chunk * 1000 / bytesPerSecond), socket, [this, socket, body, offset]() {
+        writeBody(socket, body, offset);
+    });
+}
+
+void EmulatorServer::finishResponse(QTcpSocket* socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) {
+        return;
+    }
+
+    if (it->closeAfter) {
+        socket->disconnectFromHost();
+        return;
+    }
+
+    it->busy = false;
+    if (!it->buffer.isEmpty()) {
+        processRequests(socket);
+    }
+}
+
+QByteArray EmulatorServer::reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 412: return "Precondition Failed";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef EMULATORSERVER_H
+#define EMULATORSERVER_H
+
+#include "EmulatorBackend.h"
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QHash>
+
+/**
+ * @brief Server HTTP/1.1 locale (solo http, niente TLS) davanti a EmulatorBackend
+ * Connessioni keep-alive, una richiesta alla volta per connessione.
+ * Latenza, banda e timeout di EmulatorConditions sono applicati sul socket.
+ * Le richieste text/event-stream ricevono solo lo snapshot iniziale ("put" su "/")
+ */
+class EmulatorServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EmulatorServer(EmulatorBackend* backend, QObject* parent = nullptr);
+    ~EmulatorServer() override;
+
+    bool listen(const QHostAddress& address = QHostAddress::LocalHost, quint16 port = 0);
+    void close();
+    bool isListening() const;
+
+    quint16 port() const;
+    QString baseUrl() const; // es. http://127.0.0.1:9000, da usare come URL del database e degli endpoint auth
+    QString errorString() const;
+
+private:
+    struct Connection
+    {
+        QByteArray buffer;
+        bool busy = false;       // risposta in corso (o mai inviata, per i timeout iniettati)
+        bool closeAfter = false; // il client ha chiesto Connection: close
+    };
+
+    void acceptConnections();
+    void processRequests(QTcpSocket* socket);
+    void respond(QTcpSocket* socket, const EmulatorResponse& response);
+    void respondEventStream(QTcpSocket* socket, const EmulatorResponse& snapshot);
+    void writeBody(QTcpSocket* socket, const QByteArray& body, qint64 offset);
+    void finishResponse(QTcpSocket* socket);
+
+    static QByteArray reasonPhrase(int status);
+
+    EmulatorBackend* m_backend;
+    QTcpServer m_server;
+    QHash<QTcpSocket*, Connection> m_connections;
+};
+
+#endif // EMULATORSERVER_H
@@ -0,0 +1,84 @@
+#include "EmulatorBackend.h"
+#include "EmulatorServer.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("FirebaseEmulator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for the Firebase Realtime Database and Auth REST APIs");
+    parser.addHelpOption();
+
+    const QCommandLineOption portOption("port", "TCP port (0 = any free port).", "port", "9000");
+    const QCommandLineOption hostOption("host", "Address to listen on.", "address", "127.0.0.1");
+    const QCommandLineOption dataOption("data", "JSON file loaded as the database root.", "file");
+    const QCommandLineOption userOption("user", "Accepted account (repeatable). Without users any login succeeds.", "email:password");
+    const QCommandLineOption noAuthOption("no-auth", "Do not require the auth query parameter.");
+    const QCommandLineOption tokenLifetimeOption("token-lifetime", "ID token lifetime in seconds.", "seconds", "3600");
+    const QCommandLineOption latencyOption("latency", "Delay before every response.", "ms", "0");
+    const QCommandLineOption jitterOption("jitter", "Random +/- variation of the delay.", "ms", "0");
+    const QCommandLineOption bandwidthOption("bandwidth", "Download bandwidth cap (0 = unlimited).", "bytes/s", "0");
+    const QCommandLineOption unauthorizedOption("unauthorized-rate", "Fraction of database requests answered with 401.", "fraction", "0");
+    const QCommandLineOption serverErrorOption("error-rate", "Fraction of requests answered with 503.", "fraction", "0");
+    const QCommandLineOption timeoutOption("timeout-rate", "Fraction of requests never answered.", "fraction", "0");
+    const QCommandLineOption seedOption("seed", "Seed of the fault sequence.", "seed", "1");
+
+    parser.addOptions({ portOption, hostOption, dataOption, userOption, noAuthOption, tokenLifetimeOption,
+                        latencyOption, jitterOption, bandwidthOption, unauthorizedOption, serverErrorOption,
+                        timeoutOption, seedOption });
+    parser.process(app);
+
+    EmulatorBackend backend;
+    backend.setRequireAuth(!parser.isSet(noAuthOption));
+    backend.setTokenLifetime(parser.value(tokenLifetimeOption).toInt());
+
+    for (const QString& user : parser.values(userOption)) {
+        const qsizetype separator = user.indexOf(':');
+        if (separator <= 0) {
+            std::cerr << "Invalid --user, expected email:password\n";
+            return 1;
+        }
+        backend.addUser(user.left(separator), user.mid(separator + 1));
+    }
+
+    if (parser.isSet(dataOption)) {
+        QFile file(parser.value(dataOption));
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::cerr << "Cannot open " << file.fileName().toStdString() << "\n";
+            return 1;
+        }
+        const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+        backend.setValue(QString(), document.isArray() ? QJsonValue(document.array()) : QJsonValue(document.object()));
+    }
+
+    EmulatorConditions conditions;
+    conditions.latencyMs = parser.value(latencyOption).toInt();
+    conditions.jitterMs = parser.value(jitterOption).toInt();
+    conditions.bytesPerSecond = parser.value(bandwidthOption).toLongLong();
+    conditions.unauthorizedRate = parser.value(unauthorizedOption).toDouble();
+    conditions.serverErrorRate = parser.value(serverErrorOption).toDouble();
+    conditions.timeoutRate = parser.value(timeoutOption).toDouble();
+    conditions.seed = parser.value(seedOption).toUInt();
+    backend.setConditions(conditions);
+
+    EmulatorServer server(&backend);
+    if (!server.listen(QHostAddress(parser.value(hostOption)), quint16(parser.value(portOption).toUInt()))) {
+        std::cerr << "Cannot listen: " << server.errorString().toStdString() << "\n";
+        return 1;
+    }
+
+    const std::string baseUrl = server.baseUrl().toStdString();
+    std::cout << "Firebase emulator listening on " << baseUrl << "\n"
+              << "  manager.connect(\"" << baseUrl << "\");\n"
+              << "  manager.setAuthEndpoints(\"" << baseUrl << "/v1\", \"" << baseUrl << "/v1\");\n";
+
+    return app.exec();
+}
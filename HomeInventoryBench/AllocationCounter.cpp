@@ -0,0 +1,100 @@
+#include "Benchmarks.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<qint64> allocationCount{ 0 };
+std::atomic<qint64> allocationBytes{ 0 };
+
+inline void countAllocation(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(qint64(size), std::memory_order_relaxed);
+}
+
+} // namespace
+
+AllocationStats allocationStats()
+{
+    AllocationStats stats;
+    stats.count = allocationCount.load(std::memory_order_relaxed);
+    stats.bytes = allocationBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+#if defined(__GLIBC__)
+
+// glibc: si intercetta malloc, cosi' si contano anche i buffer di QString/QByteArray/QList,
+// che Qt alloca con malloc e non con operator new
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) noexcept
+{
+    __libc_free(pointer);
+}
+
+} // extern "C"
+
+#else
+
+// Altre piattaforme (MSVC): solo operator new, i buffer dei container Qt non vengono contati
+void* operator new(size_t size)
+{
+    countAllocation(size);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+#endif
@@ -0,0 +1,229 @@
+﻿#include "Benchmarks.h"
+#include "HomeObjectCodec.h"
+#include "JsonStreamParser.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+
+namespace {
+
+bool sameObject(const HomeObject& a, const HomeObject& b)
+{
+    return a.name() == b.name() && a.color() == b.color() && a.material() == b.material()
+        && a.type() == b.type() && a.notes() == b.notes() && a.locationId() == b.locationId()
+        && a.sublocationId() == b.sublocationId() && a.pictureRef() == b.pictureRef() && a.picture() == b.picture();
+}
+
+// Documenti che l'inventario generato non produce: escape, surrogati, tipi sbagliati, formato precedente
+QList<QByteArray> edgeCasePayloads()
+{
+    return {
+        R"({})",
+        R"(  { "name" : "spaced" , "locationId" : 7 }  )",
+        R"({"name":"quote \" back \\ slash \/ nl \n tab \t \b \f \r uni \u00e8 ctl \u001f","color":"Red","updatedAt":1700000000000})",
+        "{\"name\":\"raw \xF0\x9F\x98\x80 \xC3\xA8\",\"notes\":\"pair \\ud83d\\ude00\"}",
+        R"({"name":"lone \ud800 high","color":"\udc00 low first","material":"\ude00\ud83d reversed"})",
+        R"({"name":42,"color":null,"material":true,"type":["a"],"notes":{"x":1},"locationId":"3","sublocationId":null,"updatedAt":{".sv":"timestamp"}})",
+        R"({"name":"numbers","locationId":3.0,"sublocationId":2.5,"updatedAt":1e17})",
+        R"({"name":"range","locationId":2147483648,"sublocationId":-2147483648,"updatedAt":12345678901234567890})",
+        R"({"name":"exponent","locationId":1E2,"sublocationId":-0,"updatedAt":-1.5e3})",
+        R"({"extra":{"deep":[1,{"name":"inner"}],"s":"x"},"name":"outer","tags":[null,false,-1.5]})",
+        R"({"na\u006de":"escaped key","\u0063olor":"Blue"})",
+        R"({"name":"old format","pictureRef":"","picture":")" + QByteArray("legacy picture bytes").toBase64() + R"("})",
+        R"({"name":"old format, escaped","picture":"aGVs\/bG8="})",
+        R"({"name":"bad \x escape"})",
+        R"({"name":"short \u12"})",
+        R"({"name":"unterminated")",
+        R"(["name"])",
+    };
+}
+
+// Il DOM (toJson/fromJson) e' il riferimento: decode e encode devono dare lo stesso risultato,
+// e un documento che il DOM rifiuta va rifiutato anche da decode (reloadAllObjects ripiega sul DOM)
+void verifyCodec(const QList<QByteArray>& payloads, QList<HomeObject> objects)
+{
+    for (const QByteArray& payload : payloads + edgeCasePayloads()) {
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(payload, &error);
+        const bool valid = error.error == QJsonParseError::NoError && document.isObject();
+
+        HomeObject decoded;
+        qint64 decodedAt = -1;
+        if (HomeObjectCodec::decode(payload, decoded, &decodedAt) != valid) {
+            qFatal("HomeObjectCodec::decode %s a document the DOM %s: %s",
+                   valid ? "rejects" : "accepts", valid ? "accepts" : "rejects", payload.constData());
+        }
+        if (!valid) {
+            continue;
+        }
+
+        qint64 expectedAt = -1;
+        const HomeObject expected = HomeObjectCodec::fromJson(document.object(), &expectedAt);
+        if (!sameObject(decoded, expected) || decodedAt != expectedAt) {
+            qFatal("HomeObjectCodec::decode differs from fromJson: %s", payload.constData());
+        }
+        objects.append(decoded);
+    }
+
+    for (const HomeObject& obj : std::as_const(objects)) {
+        const QByteArray encoded = HomeObjectCodec::encode(obj);
+        if (QJsonDocument::fromJson(encoded).object() != HomeObjectCodec::toJson(obj)) {
+            qFatal("HomeObjectCodec::encode differs from toJson for \"%s\": %s", qUtf8Printable(obj.name()), encoded.constData());
+        }
+    }
+}
+
+} // namespace
+
+void benchCodec(int objectCount)
+{
+    printHeader(QString(u8"🧬 JSON codec - %1 objects").arg(objectCount));
+
+    QuietOutput quiet;
+    const QList<HomeObject> objects = makeInventory(objectCount);
+
+    // ---- HomeObject -> JSON ----
+
+    const BenchResult toJson = runBench("toJson (DOM)", [&objects]() -> qint64 {
+        qsizetype fields = 0;
+        for (const HomeObject& obj : objects) {
+            fields += HomeObjectCodec::toJson(obj).size();
+        }
+        volatile qsizetype sink = fields;
+        Q_UNUSED(sink);
+        return objects.size();
+    });
+    printResult(toJson);
+
+    // Payload di una PUT: DOM e serializzazione contro scrittura diretta in un buffer riusato
+    const BenchResult encodeDom = runBench("toJson + serialize (payload)", [&objects]() -> qint64 {
+        qsizetype bytes = 0;
+        for (const HomeObject& obj : objects) {
+            bytes += QJsonDocument(HomeObjectCodec::toJson(obj)).toJson(QJsonDocument::Compact).size();
+        }
+        volatile qsizetype sink = bytes;
+        Q_UNUSED(sink);
+        return objects.size();
+    });
+    printResult(encodeDom);
+
+    QByteArray buffer;
+    const BenchResult encodeCodec = runBench("HomeObjectCodec::encode (payload)", [&objects, &buffer]() -> qint64 {
+        qsizetype bytes = 0;
+        for (const HomeObject& obj : objects) {
+            buffer.truncate(0);
+            HomeObjectCodec::encode(obj, buffer);
+            bytes += buffer.size();
+        }
+        volatile qsizetype sink = bytes;
+        Q_UNUSED(sink);
+        return objects.size();
+    });
+    printResult(encodeCodec, &encodeDom);
+
+    // ---- JSON -> HomeObject ----
+
+    QJsonObject document;
+    for (const HomeObject& obj : objects) {
+        document.insert(obj.name(), HomeObjectCodec::toJson(obj));
+    }
+
+    const BenchResult fromJson = runBench("fromJson (DOM)", [&document]() -> qint64 {
+        qsizetype length = 0;
+        for (auto it = document.begin(); it != document.end(); ++it) {
+            length += HomeObjectCodec::fromJson(it.value().toObject()).name().size();
+        }
+        volatile qsizetype sink = length;
+        Q_UNUSED(sink);
+        return document.size();
+    });
+    printResult(fromJson);
+
+    // Un oggetto come arriva dal server (updatedAt gia' risolto): byte -> HomeObject
+    QList<QByteArray> payloads;
+    payloads.reserve(objects.size());
+    for (const HomeObject& obj : objects) {
+        QJsonObject json = HomeObjectCodec::toJson(obj);
+        json["updatedAt"] = QDateTime::currentMSecsSinceEpoch();
+        payloads.append(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    }
+    verifyCodec(payloads, objects);
+
+    const BenchResult decodeDom = runBench("parse + fromJson (payload)", [&payloads]() -> qint64 {
+        qsizetype length = 0;
+        for (const QByteArray& payload : payloads) {
+            length += HomeObjectCodec::fromJson(QJsonDocument::fromJson(payload).object()).name().size();
+        }
+        volatile qsizetype sink = length;
+        Q_UNUSED(sink);
+        return payloads.size();
+    });
+    printResult(decodeDom);
+
+    const BenchResult decodeCodec = runBench("HomeObjectCodec::decode (payload)", [&payloads]() -> qint64 {
+        qsizetype length = 0;
+        HomeObject obj;
+        for (const QByteArray& payload : payloads) {
+            HomeObjectCodec::decode(payload, obj);
+            length += obj.name().size();
+        }
+        volatile qsizetype sink = length;
+        Q_UNUSED(sink);
+        return payloads.size();
+    });
+    printResult(decodeCodec, &decodeDom);
+
+    // ---- Documento completo, come la risposta di GET /objects.json ----
+
+    const BenchResult serialize = runBench("serialize document", [&document]() -> qint64 {
+        volatile qsizetype sink = QJsonDocument(document).toJson(QJsonDocument::Compact).size();
+        Q_UNUSED(sink);
+        return document.size();
+    });
+    printResult(serialize);
+
+    const QByteArray payload = QJsonDocument(document).toJson(QJsonDocument::Compact);
+
+    const BenchResult parseDom = runBench("parse document (DOM)", [&payload]() -> qint64 {
+        const QJsonObject parsed = QJsonDocument::fromJson(payload).object();
+        qsizetype length = 0;
+        for (auto it = parsed.begin(); it != parsed.end(); ++it) {
+            length += HomeObjectCodec::fromJson(it.value().toObject()).name().size();
+        }
+        volatile qsizetype sink = length;
+        Q_UNUSED(sink);
+        return parsed.size();
+    });
+    printResult(parseDom);
+
+    // Stesso percorso di reloadAllObjects: blocchi da 64 KiB, un oggetto alla volta
+    const BenchResult parseStream = runBench("parse document (streaming)", [&payload]() -> qint64 {
+        qint64 count = 0;
+        JsonStreamParser parser([&count](const QString&, const QByteArray& value) {
+            HomeObjectCodec::fromJson(QJsonDocument::fromJson(value).object());
+            ++count;
+        });
+        for (qsizetype offset = 0; offset < payload.size(); offset += 64 * 1024) {
+            parser.feed(payload.mid(offset, 64 * 1024));
+        }
+        parser.finish();
+        return count;
+    });
+    printResult(parseStream, &parseDom);
+
+    // Percorso attuale di reloadAllObjects: stesso streaming, ogni membro decodificato senza DOM
+    const BenchResult parseStreamCodec = runBench("parse document (streaming, codec)", [&payload]() -> qint64 {
+        qint64 count = 0;
+        JsonStreamParser parser([&count](const QString&, const QByteArray& value) {
+            HomeObject obj;
+            HomeObjectCodec::decode(value, obj);
+            ++count;
+        });
+        for (qsizetype offset = 0; offset < payload.size(); offset += 64 * 1024) {
+            parser.feed(payload.mid(offset, 64 * 1024));
+        }
+        parser.finish();
+        return count;
+    });
+    printResult(parseStreamCodec, &parseStream);
+}
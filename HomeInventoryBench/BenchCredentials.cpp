@@ -0,0 +1,50 @@
+﻿#include "Benchmarks.h"
+#include "CredentialsManager.h"
+
+void benchCredentials()
+{
+    printHeader(QString(u8"🔐 CredentialsManager"));
+
+    // QStandardPaths e' in modalita' test: le credenziali reali non vengono toccate
+    QuietOutput quiet;
+    CredentialsManager credentials;
+
+    const BenchResult save = runBench("saveCredentials", [&credentials]() -> qint64 {
+        credentials.saveCredentials("bench@example.com", "correct horse battery staple");
+        return 1;
+    });
+    printResult(save);
+
+    const BenchResult load = runBench("loadCredentials", [&credentials]() -> qint64 {
+        QString email;
+        QString password;
+        credentials.loadCredentials(email, password);
+        return 1;
+    });
+    printResult(load);
+
+    const BenchResult hasStored = runBench("hasStoredCredentials", [&credentials]() -> qint64 {
+        volatile bool sink = credentials.hasStoredCredentials();
+        Q_UNUSED(sink);
+        return 1;
+    });
+    printResult(hasStored);
+
+    // I refresh token di Firebase sono lunghi qualche centinaio di caratteri
+    const QString refreshToken = QString("AMf-vB").leftJustified(320, 'x');
+
+    const BenchResult saveToken = runBench("saveRefreshToken", [&credentials, &refreshToken]() -> qint64 {
+        credentials.saveRefreshToken(refreshToken);
+        return 1;
+    });
+    printResult(saveToken);
+
+    const BenchResult loadToken = runBench("loadRefreshToken", [&credentials]() -> qint64 {
+        volatile qsizetype sink = credentials.loadRefreshToken().size();
+        Q_UNUSED(sink);
+        return 1;
+    });
+    printResult(loadToken);
+
+    credentials.clearCredentials();
+}
@@ -0,0 +1,248 @@
+﻿#include "Benchmarks.h"
+#include "FirebaseDatabaseManager.h"
+#include "HomeObjectCodec.h"
+#include "EmulatorBackend.h"
+#include "EmulatorNetworkAccessManager.h"
+#include "ObjectMutation.h"
+#include "ObjectSnapshot.h"
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QVariantMap>
+
+namespace {
+
+// Manager autenticato contro il backend emulato in-process: nessun socket, nessuna credenziale reale
+struct EmulatedSession
+{
+    EmulatorBackend backend;
+    EmulatorNetworkAccessManager network{ &backend };
+    FirebaseDatabaseManager manager;
+
+    explicit EmulatedSession(const QList<HomeObject>& objects)
+    {
+        for (const HomeObject& obj : objects) {
+            backend.setValue("objects/" + obj.name(), HomeObjectCodec::toJson(obj));
+        }
+
+        manager.setNetworkAccessManager(&network);
+        manager.setConnectionWarmUp(false); // nessun host reale da preaprire
+        manager.connect("https://bench.emulator.local");
+        manager.setApiKey("bench-api-key");
+        manager.authenticateWithEmail("bench@example.com", "bench-password", false);
+    }
+};
+
+// Vocabolario nel formato precedente (array): aggiungere o togliere un valore deve prima
+// migrarlo a nodi con chiave, altrimenti la DELETE non trova nulla e la PUT crea un duplicato
+void verifyLegacyAttributes()
+{
+    EmulatedSession session{ QList<HomeObject>() };
+    FirebaseDatabaseManager& manager = session.manager;
+    const QJsonArray legacy = { "Red", "Blue" };
+
+    auto expectColors = [&session](const char* step, QStringList expected) {
+        const QJsonValue node = session.backend.value("colors");
+        QStringList stored;
+        bool keyed = node.isObject();
+        const QJsonObject children = node.toObject();
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            stored.append(it.value().toString());
+            keyed = keyed && it.key() == it.value().toString();
+        }
+        stored.sort();
+        expected.sort();
+        if (!keyed || stored != expected) {
+            qFatal("legacy colors, %s: stored %s instead of keyed %s", step,
+                   qPrintable(QJsonDocument(QJsonObject{ { "colors", node } }).toJson(QJsonDocument::Compact)),
+                   qPrintable(expected.join(", ")));
+        }
+    };
+
+    session.backend.setValue("colors", legacy);
+    if (!manager.removeColor("Red")) {
+        qFatal("legacy colors, removeColor: %s", qPrintable(manager.lastError()));
+    }
+    expectColors("removeColor before any read", { "Blue" });
+
+    // Un client vecchio riscrive l'array: una nuova sessione deve riconoscerlo di nuovo
+    session.backend.setValue("colors", legacy);
+    manager.invalidateCache();
+    if (!manager.addColor("Green")) {
+        qFatal("legacy colors, addColor: %s", qPrintable(manager.lastError()));
+    }
+    expectColors("addColor before any read", { "Red", "Blue", "Green" });
+}
+
+} // namespace
+
+void benchDatabaseManager(int objectCount)
+{
+    printHeader(QString(u8"🔥 FirebaseDatabaseManager (emulated backend) - %1 objects").arg(objectCount));
+
+    QuietOutput quiet;
+    verifyLegacyAttributes();
+    EmulatedSession session(makeInventory(objectCount));
+    FirebaseDatabaseManager& manager = session.manager;
+
+    if (!manager.isAuthenticated()) {
+        benchOut() << "  authentication against the emulator failed: " << manager.lastError().toStdString() << "\n";
+        return;
+    }
+
+    // ---- Letture dalla rete ----
+
+    const BenchResult coldLoad = runBench("getAllObjects (cold, full download)", [&manager]() -> qint64 {
+        manager.invalidateCache();
+        return manager.getAllObjects().size();
+    });
+    printResult(coldLoad);
+
+    // ---- Avvio a freddo dallo snapshot su disco ----
+
+    const QString snapshotPath = QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation))
+        .filePath("bench-objects.snapshot");
+    manager.setSnapshotFile(snapshotPath);
+
+    const BenchResult saveSnapshot = runBench("saveSnapshot", [&manager, objectCount]() -> qint64 {
+        manager.saveSnapshot();
+        return objectCount;
+    });
+    printResult(saveSnapshot);
+
+    // Primo disegno possibile: mappatura e validazione, poi i nomi letti senza copie
+    const BenchResult openSnapshot = runBench("ObjectSnapshot open + scan names", [&snapshotPath]() -> qint64 {
+        ObjectSnapshot snapshot;
+        snapshot.open(snapshotPath);
+        qsizetype length = 0;
+        for (int row = 0; row < snapshot.size(); ++row) {
+            length += snapshot.name(row).size();
+        }
+        volatile qsizetype sink = length;
+        Q_UNUSED(sink);
+        return snapshot.size();
+    });
+    printResult(openSnapshot, &coldLoad);
+
+    // Cache completa (indici compresi) dallo snapshot, senza rete
+    const BenchResult restoreSnapshot = runBench("setSnapshotFile (restore cache)", [&manager, &snapshotPath]() -> qint64 {
+        manager.invalidateCache();
+        manager.setSnapshotFile(snapshotPath);
+        return manager.cachedObjects().size();
+    });
+    printResult(restoreSnapshot, &coldLoad);
+    manager.setSnapshotFile(QString());
+    QFile::remove(snapshotPath);
+
+    // Cache completa ma sempre scaduta: ogni lettura fa la sincronizzazione delta
+    manager.setCacheMaxAge(-1);
+    const BenchResult deltaSync = runBench("getAllObjects (delta sync)", [&manager]() -> qint64 {
+        return manager.getAllObjects().size();
+    });
+    printResult(deltaSync, &coldLoad);
+
+    const BenchResult roomQuery = runBench("getObjects (server query)", [&manager]() -> qint64 {
+        manager.invalidateCache();
+        return manager.getObjects(3, 5).size();
+    });
+    printResult(roomQuery);
+
+    // Vocabolario senza stream realtime, sempre scaduto: ogni lettura va in rete, ma se l'ETag
+    // non e' cambiato l'elenco gia' convertito viene riusato
+    for (int i = 0; i < 200; ++i) {
+        const QString color = QString("Color %1").arg(i, 3, 10, QChar('0'));
+        session.backend.setValue("colors/" + color, color);
+    }
+    const BenchResult colors = runBench("getColors (200 values, ETag revalidated)", [&manager]() -> qint64 {
+        return manager.getColors().size();
+    });
+    printResult(colors);
+
+    // Letture identiche concorrenti (es. piu' combo box aperte insieme): una sola GET in volo
+    const BenchResult concurrentColors = runBench("getColorsAsync x8 (concurrent, coalesced)", [&manager]() -> qint64 {
+        QList<QFuture<QStringList>> futures;
+        for (int i = 0; i < 8; ++i) {
+            futures.append(manager.getColorsAsync());
+        }
+        qint64 values = 0;
+        for (const QFuture<QStringList>& future : futures) {
+            values += awaitResult(future).size();
+        }
+        return values;
+    });
+    printResult(concurrentColors);
+    benchOut() << "    reads joined to a request in flight: " << manager.metrics().coalescedReads << "\n";
+
+    // ---- Letture dalla cache ----
+
+    manager.setCacheMaxAge(60 * 60 * 1000);
+    manager.getAllObjects();
+
+    const BenchResult warmLoad = runBench("getAllObjects (warm)", [&manager]() -> qint64 {
+        return manager.getAllObjects().size();
+    });
+    printResult(warmLoad, &coldLoad);
+
+    const BenchResult warmColors = runBench("getColors (warm)", [&manager]() -> qint64 {
+        return manager.getColors().size();
+    });
+    printResult(warmColors, &colors);
+
+    const BenchResult warmRoom = runBench("getObjects (warm)", [&manager, objectCount]() -> qint64 {
+        manager.getObjects(3, 5);
+        return objectCount;
+    });
+    printResult(warmRoom, &roomQuery);
+
+    const QVariantMap attributeFilters = {
+        { "colors", QStringList{ "Red", "Blue" } },
+        { "types", QStringList{ "Tool", "Book", "Cable" } }
+    };
+    const BenchResult searchAttributes = runBench("searchObjects (colors + types)", [&manager, &attributeFilters, objectCount]() -> qint64 {
+        manager.searchObjects(attributeFilters);
+        return objectCount;
+    });
+    printResult(searchAttributes);
+
+    const QVariantMap nameFilters = { { "name", "hammer" }, { "locationId", 3 } };
+    const BenchResult searchName = runBench("searchObjects (name + location)", [&manager, &nameFilters, objectCount]() -> qint64 {
+        manager.searchObjects(nameFilters);
+        return objectCount;
+    });
+    printResult(searchName);
+
+    const BenchResult suggest = runBench("suggestObjects (typo)", [&manager, objectCount]() -> qint64 {
+        awaitResult(manager.suggestObjectsAsync("hamer", 2, 20));
+        return objectCount;
+    });
+    printResult(suggest);
+
+    // ---- Scritture ----
+
+    int serial = 0;
+    const BenchResult create = runBench("createObject", [&manager, &serial]() -> qint64 {
+        HomeObject obj(QString("bench object %1").arg(++serial), 1, 1);
+        obj.setColor("Red");
+        obj.setType("Tool");
+        manager.createObject(obj);
+        return 1;
+    });
+    printResult(create);
+
+    const QList<HomeObject> batchObjects = makeInventory(100, 7);
+    int batchSerial = 0;
+    const BenchResult batch = runBench("applyBatch (100 upserts)", [&manager, &batchObjects, &batchSerial]() -> qint64 {
+        QList<ObjectMutation> mutations;
+        mutations.reserve(batchObjects.size());
+        ++batchSerial;
+        for (const HomeObject& obj : batchObjects) {
+            HomeObject copy = obj;
+            copy.setNotes(QString("batch %1").arg(batchSerial));
+            mutations.append(ObjectMutation::create(copy));
+        }
+        manager.applyBatch(mutations);
+        return mutations.size();
+    });
+    printResult(batch);
+}
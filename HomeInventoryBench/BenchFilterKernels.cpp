@@ -0,0 +1,123 @@
+﻿#include "Benchmarks.h"
+#include "ObjectTable.h"
+#include "FilterKernels.h"
+#include "SearchFilter.h"
+#include <QVariantMap>
+
+namespace {
+
+// Righe scelte dal ciclo su HomeObject: il risultato che ogni kernel deve riprodurre
+template <typename Predicate>
+ObjectBitmap expectedRows(const QList<HomeObject>& objects, Predicate matches)
+{
+    ObjectBitmap rows(int(objects.size()));
+    for (int row = 0; row < objects.size(); ++row) {
+        if (matches(objects.at(row))) {
+            rows.set(row);
+        }
+    }
+    return rows;
+}
+
+// Un kernel piu' veloce ma sbagliato non deve finire nel report
+void verifySelection(const char* what, FilterKernels::Isa isa, const ObjectBitmap& selection, const ObjectBitmap& expected)
+{
+    bool same = selection.wordCount() == expected.wordCount();
+    for (int w = 0; same && w < expected.wordCount(); ++w) {
+        same = selection.word(w) == expected.word(w);
+    }
+    if (!same) {
+        qFatal("%s: %s selection differs from the HomeObject loop (%d rows instead of %d)",
+               what, FilterKernels::isaName(isa), selection.count(), expected.count());
+    }
+}
+
+} // namespace
+
+void benchFilterKernels(int objectCount)
+{
+    printHeader(QString(u8"⚡ Filter kernels - %1 objects (best ISA: %2)")
+                    .arg(objectCount).arg(FilterKernels::isaName(FilterKernels::bestIsa())));
+
+    const QList<HomeObject> objects = makeInventory(objectCount);
+    const ObjectTable table(objects);
+
+    const int locationId = 3;
+    const int sublocationId = 5;
+    const QStringList colors = { "Red", "Blue", "Black" };
+    const QVariantMap filters = { { "colors", colors } };
+    const SearchFilter filter = SearchFilter::compile(filters);
+
+    const FilterKernels::Isa isas[] = { FilterKernels::Isa::Scalar, FilterKernels::Isa::Sse2, FilterKernels::Isa::Avx2 };
+
+    // ---- getObjects(location, sublocation) ----
+
+    const ObjectBitmap roomRows = expectedRows(objects, [](const HomeObject& obj) {
+        return obj.locationId() == locationId && obj.sublocationId() == sublocationId;
+    });
+
+    // Il ciclo precedente: un confronto per HomeObject, con salto per ogni oggetto
+    const BenchResult roomLoop = runBench("room: HomeObject loop", [&objects]() -> qint64 {
+        int matches = 0;
+        for (const HomeObject& obj : objects) {
+            if (obj.locationId() == locationId && obj.sublocationId() == sublocationId) {
+                ++matches;
+            }
+        }
+        volatile int sink = matches;
+        Q_UNUSED(sink);
+        return objects.size();
+    });
+    printResult(roomLoop);
+
+    for (FilterKernels::Isa isa : isas) {
+        if (isa > FilterKernels::bestIsa()) {
+            continue;
+        }
+        FilterKernels::setIsa(isa);
+        verifySelection("room", isa, table.selectRoom(locationId, sublocationId), roomRows);
+        const BenchResult result = runBench(QString("room: ObjectTable %1").arg(FilterKernels::isaName(isa)),
+                                            [&table]() -> qint64 {
+            volatile int sink = table.selectRoom(locationId, sublocationId).wordCount();
+            Q_UNUSED(sink);
+            return table.rowCount();
+        });
+        printResult(result, &roomLoop);
+    }
+
+    // ---- searchObjects({ colors: [...] }) ----
+
+    const ObjectBitmap colorRows = expectedRows(objects, [&colors](const HomeObject& obj) {
+        return colors.contains(obj.color());
+    });
+
+    const BenchResult colorLoop = runBench("colors: HomeObject loop", [&objects, &colors]() -> qint64 {
+        int matches = 0;
+        for (const HomeObject& obj : objects) {
+            if (colors.contains(obj.color())) {
+                ++matches;
+            }
+        }
+        volatile int sink = matches;
+        Q_UNUSED(sink);
+        return objects.size();
+    });
+    printResult(colorLoop);
+
+    for (FilterKernels::Isa isa : isas) {
+        if (isa > FilterKernels::bestIsa()) {
+            continue;
+        }
+        FilterKernels::setIsa(isa);
+        verifySelection("colors", isa, table.select(filter), colorRows);
+        const BenchResult result = runBench(QString("colors: ObjectTable %1").arg(FilterKernels::isaName(isa)),
+                                            [&table, &filter]() -> qint64 {
+            volatile int sink = table.select(filter).wordCount();
+            Q_UNUSED(sink);
+            return table.rowCount();
+        });
+        printResult(result, &colorLoop);
+    }
+
+    FilterKernels::setIsa(FilterKernels::bestIsa());
+}
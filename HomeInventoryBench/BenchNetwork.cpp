@@ -0,0 +1,123 @@
+﻿#include "Benchmarks.h"
+#include "FirebaseDatabaseManager.h"
+#include "HomeObjectCodec.h"
+#include "EmulatorBackend.h"
+#include "EmulatorServer.h"
+
+namespace {
+
+// Manager collegato via HTTP all'emulatore su localhost: socket, header e keep-alive reali
+struct LocalhostSession
+{
+    EmulatorBackend backend;
+    EmulatorServer server{ &backend };
+    FirebaseDatabaseManager manager;
+
+    explicit LocalhostSession(const QList<HomeObject>& objects)
+    {
+        for (const HomeObject& obj : objects) {
+            backend.setValue("objects/" + obj.name(), HomeObjectCodec::toJson(obj));
+        }
+
+        if (!server.listen()) {
+            return;
+        }
+
+        manager.connect(server.baseUrl());
+        manager.setAuthEndpoints(server.baseUrl() + "/v1", server.baseUrl() + "/v1");
+        manager.setApiKey("bench-api-key");
+        manager.authenticateWithEmail("bench@example.com", "bench-password", false);
+    }
+};
+
+} // namespace
+
+void benchNetwork(int objectCount)
+{
+    printHeader(QString(u8"🌐 Localhost emulator - %1 objects").arg(objectCount));
+
+    QuietOutput quiet;
+    LocalhostSession session(makeInventory(objectCount));
+    FirebaseDatabaseManager& manager = session.manager;
+
+    if (!manager.isAuthenticated()) {
+        benchOut() << "  emulator unavailable: " << session.server.errorString().toStdString()
+                   << manager.lastError().toStdString() << "\n";
+        return;
+    }
+
+    const BenchResult coldLoad = runBench("getAllObjects (cold)", [&manager]() -> qint64 {
+        manager.invalidateCache();
+        return manager.getAllObjects().size();
+    });
+    printResult(coldLoad);
+
+    int serial = 0;
+    auto createOne = [&manager, &serial]() -> qint64 {
+        HomeObject obj(QString("network object %1").arg(++serial), 2, 4);
+        obj.setColor("Blue");
+        return manager.createObject(obj) ? 1 : 0;
+    };
+
+    const BenchResult create = runBench("createObject", createOne);
+    printResult(create);
+
+    // Rete "domestica": 20 ms di latenza e 10 MB/s
+    EmulatorConditions home;
+    home.latencyMs = 20;
+    home.jitterMs = 5;
+    home.bytesPerSecond = 10 * 1000 * 1000;
+    session.backend.setConditions(home);
+
+    const BenchResult slowLoad = runBench("getAllObjects (cold, 20 ms, 10 MB/s)", [&manager]() -> qint64 {
+        manager.invalidateCache();
+        return manager.getAllObjects().size();
+    });
+    printResult(slowLoad, &coldLoad);
+
+    const BenchResult slowCreate = runBench("createObject (20 ms)", createOne);
+    printResult(slowCreate, &create);
+
+    // Rete instabile: 10% di 503, ripetuti con backoff dal request executor
+    EmulatorConditions flaky;
+    flaky.serverErrorRate = 0.1;
+    session.backend.setConditions(flaky);
+    int failedWrites = 0;
+    const BenchResult flakyCreate = runBench("createObject (10% 503, retried)", [&createOne, &failedWrites]() -> qint64 {
+        const qint64 written = createOne();
+        failedWrites += written == 0;
+        return written;
+    });
+    printResult(flakyCreate, &create);
+    benchOut() << "    failed after retries: " << failedWrites << "\n";
+
+    // Token revocato a ogni iterazione: 401, refresh, nuovo tentativo
+    session.backend.setConditions(EmulatorConditions());
+    const BenchResult refresh = runBench("createObject (401 + token refresh)", [&session, &createOne]() -> qint64 {
+        session.backend.revokeTokens();
+        return createOne();
+    });
+    printResult(refresh, &create);
+
+    // Token da 2 secondi: il rinnovo in background deve arrivare prima della scadenza,
+    // quindi nessuna scrittura riceve 401
+    session.backend.setTokenLifetime(2);
+    manager.authenticateWithEmail("bench@example.com", "bench-password", false);
+    const qint64 unauthorizedBefore = session.backend.unauthorizedCount();
+    const BenchResult steady = runBench("createObject (2 s tokens, 3 s run)", createOne, 3000);
+    printResult(steady, &create);
+    benchOut() << "    401 responses during the run: " << session.backend.unauthorizedCount() - unauthorizedBefore << "\n";
+    session.backend.setTokenLifetime(3600);
+
+    // Vista del manager sull'intera sessione: deve coincidere con quanto misurato sopra
+    const FirebaseMetricsSnapshot metrics = manager.metrics();
+    for (auto it = metrics.verbs.begin(); it != metrics.verbs.end(); ++it) {
+        benchOut() << "    " << it.key().toStdString() << ": " << it->calls << " requests, "
+                   << it->failures << " failed, p50 <= " << it->latency.percentileUs(50) << " us, p99 <= "
+                   << it->latency.percentileUs(99) << " us\n";
+    }
+    benchOut() << "    " << metrics.bytesOut / 1024 << " KiB sent, " << metrics.bytesIn / 1024 << " KiB received, "
+               << metrics.tokenRefreshes << " token refreshes, " << metrics.authRetries << " auth retries, "
+               << metrics.retries << " retries, "
+               << metrics.timeouts << " timeouts\n";
+}
@@ -0,0 +1,92 @@
+#pragma once
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include "HomeObject.h"
+#include "Logger.h"
+#include <QList>
+#include <QString>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <functional>
+#include <iosfwd>
+
+// ==================== SYNTHETIC DATA ====================
+
+// Inventario sintetico e ripetibile: stesso seed, stessi oggetti
+QList<HomeObject> makeInventory(int count, quint32 seed = 42);
+
+// ==================== MEASUREMENT ====================
+
+struct BenchResult
+{
+    QString name;
+    qint64 iterations = 0;
+    qint64 items = 0;      // elementi elaborati in totale
+    qint64 totalNs = 0;
+    QList<qint64> samplesNs; // durata delle singole iterazioni (al massimo MaxSamples)
+    qint64 allocations = 0;  // allocazioni durante le iterazioni misurate
+    qint64 allocatedBytes = 0;
+
+    qint64 percentileNs(double percentile) const;
+};
+
+// Ripete body finche' non e' trascorso almeno minMs; body restituisce gli elementi elaborati
+BenchResult runBench(const QString& name, const std::function<qint64()>& body, int minMs = 300);
+void printHeader(const QString& title);
+void printResult(const BenchResult& result, const BenchResult* baseline = nullptr);
+
+// Attende un QFuture girando l'event loop (le risposte dell'emulatore arrivano da li')
+template <typename T>
+T awaitResult(QFuture<T> future)
+{
+    if (!future.isFinished()) {
+        QEventLoop loop;
+        QFutureWatcher<T> watcher;
+        QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+        watcher.setFuture(future);
+        loop.exec();
+    }
+    return future.resultCount() > 0 ? future.result() : T();
+}
+
+// ==================== OUTPUT ====================
+
+// Il report va sempre su stdout, anche mentre l'output della libreria e' silenziato
+std::ostream& benchOut();
+
+// Silenzia il Logger della libreria, std::cout e qDebug per la durata dello scope
+class QuietOutput
+{
+public:
+    QuietOutput();
+    ~QuietOutput();
+
+private:
+    std::streambuf* m_previousBuffer;
+    QtMessageHandler m_previousHandler;
+    LogLevel m_previousLevel;
+};
+
+// ==================== ALLOCATIONS ====================
+
+struct AllocationStats
+{
+    qint64 count = 0;
+    qint64 bytes = 0;
+};
+
+// Contatori globali aggiornati dall'allocatore intercettato (AllocationCounter.cpp)
+AllocationStats allocationStats();
+
+// ==================== SUITES ====================
+
+void benchFilterKernels(int objectCount);
+void benchCodec(int objectCount);
+void benchDatabaseManager(int objectCount);
+void benchNetwork(int objectCount);
+void benchCredentials();
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,226 @@
+#include "Benchmarks.h"
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+static const QStringList BenchColors = { "Red", "Green", "Blue", "Black", "White", "Grey",
+                                         "Yellow", "Brown", "Orange", "Purple", "Pink", "Silver" };
+static const QStringList BenchMaterials = { "Wood", "Metal", "Plastic", "Glass", "Fabric",
+                                            "Leather", "Ceramic", "Paper", "Rubber", "Stone" };
+static const QStringList BenchTypes = { "Tool", "Book", "Cable", "Toy", "Kitchenware", "Clothing",
+                                        "Document", "Electronics", "Decoration", "Sport", "Medicine",
+                                        "Stationery", "Furniture", "Garden", "Food" };
+static const QStringList BenchWords = { "box", "drill", "lamp", "charger", "scarf", "mug", "guide",
+                                        "hammer", "vase", "racket", "notebook", "blanket", "screw" };
+
+QList<HomeObject> makeInventory(int count, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    QList<HomeObject> objects;
+    objects.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        const QString name = QString("%1 %2 %3")
+            .arg(BenchWords.at(random.bounded(BenchWords.size())),
+                 BenchWords.at(random.bounded(BenchWords.size())))
+            .arg(i);
+
+        HomeObject obj(name, random.bounded(1, 11), random.bounded(1, 9));
+        obj.setColor(BenchColors.at(random.bounded(BenchColors.size())));
+        obj.setMaterial(BenchMaterials.at(random.bounded(BenchMaterials.size())));
+        obj.setType(BenchTypes.at(random.bounded(BenchTypes.size())));
+        obj.setNotes(QString("Bought in %1, shelf %2").arg(2000 + random.bounded(25)).arg(random.bounded(20)));
+        objects.append(obj);
+    }
+
+    return objects;
+}
+
+namespace {
+
+const int MaxSamples = 100000;
+
+// Scarta tutto: usato al posto di std::cout mentre parla la libreria
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+NullBuffer nullBuffer;
+
+void discardMessage(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    // Un controllo di correttezza fallito deve arrivare anche con l'output silenziato
+    if (type == QtFatalMsg) {
+        std::cerr << message.toStdString() << std::endl;
+    }
+}
+
+} // namespace
+
+std::ostream& benchOut()
+{
+    // Legato al buffer originale di std::cout: main() lo crea prima di ogni QuietOutput
+    static std::ostream out(std::cout.rdbuf());
+    return out;
+}
+
+QuietOutput::QuietOutput()
+    : m_previousBuffer(std::cout.rdbuf(&nullBuffer))
+    , m_previousHandler(qInstallMessageHandler(discardMessage))
+    , m_previousLevel(Logger::level())
+{
+    Logger::flush(); // i messaggi precedenti escono prima del report
+    Logger::setLevel(LogLevel::Off);
+}
+
+QuietOutput::~QuietOutput()
+{
+    std::cout.rdbuf(m_previousBuffer);
+    qInstallMessageHandler(m_previousHandler);
+    Logger::setLevel(m_previousLevel);
+}
+
+qint64 BenchResult::percentileNs(double percentile) const
+{
+    if (samplesNs.isEmpty()) {
+        return 0;
+    }
+
+    QList<qint64> sorted = samplesNs;
+    std::sort(sorted.begin(), sorted.end());
+    const qsizetype index = qBound<qsizetype>(0, qsizetype(std::ceil(percentile / 100.0 * sorted.size())) - 1, sorted.size() - 1);
+    return sorted.at(index);
+}
+
+BenchResult runBench(const QString& name, const std::function<qint64()>& body, int minMs)
+{
+    BenchResult result;
+    result.name = name;
+    result.samplesNs.reserve(MaxSamples);
+
+    // Un giro a vuoto per cache e allocazioni iniziali
+    body();
+
+    const AllocationStats before = allocationStats();
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 previousNs = 0;
+    do {
+        result.items += body();
+        ++result.iterations;
+
+        const qint64 nowNs = timer.nsecsElapsed();
+        if (result.samplesNs.size() < MaxSamples) {
+            result.samplesNs.append(nowNs - previousNs);
+        }
+        previousNs = nowNs;
+    } while (timer.elapsed() < minMs);
+    result.totalNs = timer.nsecsElapsed();
+
+    const AllocationStats after = allocationStats();
+    result.allocations = after.count - before.count;
+    result.allocatedBytes = after.bytes - before.bytes;
+
+    return result;
+}
+
+void printHeader(const QString& title)
+{
+    benchOut() << "\n" << title.toStdString() << "\n"
+               << "  " << std::left << std::setw(40) << "benchmark" << std::right
+               << std::setw(11) << "p50 us" << std::setw(11) << "p90 us" << std::setw(11) << "p99 us"
+               << std::setw(14) << "M items/s" << std::setw(12) << "allocs/op" << std::setw(12) << "KiB/op"
+               << std::setw(9) << "speedup" << "\n";
+}
+
+void printResult(const BenchResult& result, const BenchResult* baseline)
+{
+    const double seconds = result.totalNs / 1e9;
+    const double itemsPerSecond = seconds > 0 ? result.items / seconds : 0;
+    const double nsPerIteration = result.iterations ? double(result.totalNs) / result.iterations : 0;
+    const double iterations = qMax<qint64>(1, result.iterations);
+
+    std::ostream& out = benchOut();
+    out << "  " << std::left << std::setw(40) << result.name.toStdString() << std::right
+        << std::fixed << std::setprecision(1)
+        << std::setw(11) << result.percentileNs(50) / 1000.0
+        << std::setw(11) << result.percentileNs(90) / 1000.0
+        << std::setw(11) << result.percentileNs(99) / 1000.0
+        << std::setw(14) << std::setprecision(3) << itemsPerSecond / 1e6
+        << std::setw(12) << std::setprecision(1) << result.allocations / iterations
+        << std::setw(12) << result.allocatedBytes / iterations / 1024.0;
+
+    if (baseline && baseline->totalNs > 0 && baseline->iterations > 0 && nsPerIteration > 0) {
+        const double baselineNs = double(baseline->totalNs) / baseline->iterations;
+        out << std::setw(8) << std::setprecision(1) << baselineNs / nsPerIteration << "x";
+    }
+    out << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("HomeInventoryBench");
+
+    // CredentialsManager e cache scrivono in cartelle di test, mai in quelle dell'utente
+    QStandardPaths::setTestModeEnabled(true);
+
+    // Argomenti: nomi delle suite (kernels, codec, manager, network, credentials) e/o dimensioni (es. 1000 10000)
+    QStringList suites;
+    QList<int> sizes;
+    for (const QString& arg : app.arguments().mid(1)) {
+        bool isNumber = false;
+        const int size = arg.toInt(&isNumber);
+        if (isNumber && size > 0) {
+            sizes.append(size);
+        }
+        else {
+            suites.append(arg);
+        }
+    }
+    if (sizes.isEmpty()) {
+        sizes = { 1000, 10000, 100000 };
+    }
+    const bool runAll = suites.isEmpty();
+
+    benchOut() << "HomeInventory benchmarks - Qt " << qVersion() << "\n";
+
+    if (runAll || suites.contains("kernels")) {
+        for (int count : std::as_const(sizes)) {
+            benchFilterKernels(count);
+        }
+    }
+
+    if (runAll || suites.contains("codec")) {
+        for (int count : std::as_const(sizes)) {
+            benchCodec(count);
+        }
+    }
+
+    if (runAll || suites.contains("manager")) {
+        for (int count : std::as_const(sizes)) {
+            benchDatabaseManager(count);
+        }
+    }
+
+    if (runAll || suites.contains("network")) {
+        for (int count : std::as_const(sizes)) {
+            benchNetwork(count);
+        }
+    }
+
+    if (runAll || suites.contains("credentials")) {
+        benchCredentials();
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "AttributeDictionary.h"
+#include <QMutexLocker>
+
+AttributeDictionary& AttributeDictionary::colors()
+{
+    static AttributeDictionary dictionary;
+    return dictionary;
+}
+
+AttributeDictionary& AttributeDictionary::materials()
+{
+    static AttributeDictionary dictionary;
+    return dictionary;
+}
+
+AttributeDictionary& AttributeDictionary::types()
+{
+    static AttributeDictionary dictionary;
+    return dictionary;
+}
+
+AttributeDictionary::AttributeDictionary()
+    : m_size(0)
+{
+    for (auto& chunk : m_values) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    // L'ID 0 e' sempre la stringa vuota, cosi' un HomeObject nuovo non tocca il dizionario
+    m_values[0].store(new QString[ChunkSize], std::memory_order_relaxed);
+    m_ids.insert(QString(), EmptyId);
+    m_size.store(1, std::memory_order_release);
+}
+
+AttributeDictionary::~AttributeDictionary()
+{
+    for (auto& chunk : m_values) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+AttributeDictionary::Id AttributeDictionary::intern(const QString& value)
+{
+    if (value.isEmpty()) {
+        return EmptyId;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_ids.constFind(value);
+    if (it != m_ids.cend()) {
+        return it.value();
+    }
+
+    const Id id = m_size.load(std::memory_order_relaxed);
+    if (id >= Capacity) {
+        // Oltre quattro miliardi di valori distinti: non si puo' restituire un ID senza perdere il valore
+        qFatal("AttributeDictionary: no ID left for a new value");
+    }
+
+    const int index = chunkOf(id);
+    QString* chunk = m_values[index].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new QString[ChunkSize << index];
+        m_values[index].store(chunk, std::memory_order_relaxed);
+    }
+    chunk[id - chunkStart(index)] = value;
+    m_ids.insert(value, id);
+
+    // Pubblica la nuova voce solo dopo averla scritta
+    m_size.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+AttributeDictionary::Id AttributeDictionary::find(const QString& value) const
+{
+    if (value.isEmpty()) {
+        return EmptyId;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    return m_ids.value(value, NoId);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef ATTRIBUTEDICTIONARY_H
+#define ATTRIBUTEDICTIONARY_H
+
+#include "homeinventorydata_global.h"
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QtAlgorithms>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Dizionario condiviso di un vocabolario di attributi (colori, materiali, tipi)
+ * Ogni stringa viene memorizzata una sola volta e identificata da un intero piccolo:
+ * gli HomeObject conservano solo l'ID, confronti e filtri diventano confronti tra interi
+ * Le voci non vengono mai rimosse, quindi un ID resta valido per tutta la vita del processo
+ * Lo spazio cresce a blocchi di dimensione doppia: un valore non vuoto ottiene sempre un ID proprio
+ * value() non prende lock ed e' sicuro da qualunque thread
+ */
+class HOMEINVENTORYDATA_EXPORT AttributeDictionary
+{
+public:
+    using Id = quint32;
+    static constexpr Id EmptyId = 0;        // stringa vuota
+    static constexpr Id NoId = 0xFFFFFFFFu; // valore mai registrato (non corrisponde a nessun oggetto)
+
+    // Vocabolari condivisi
+    static AttributeDictionary& colors();
+    static AttributeDictionary& materials();
+    static AttributeDictionary& types();
+
+    AttributeDictionary();
+    ~AttributeDictionary();
+    AttributeDictionary(const AttributeDictionary&) = delete;
+    AttributeDictionary& operator=(const AttributeDictionary&) = delete;
+
+    Id intern(const QString& value);     // registra il valore se nuovo
+    Id find(const QString& value) const; // NoId se il valore non e' registrato
+
+    const QString& value(Id id) const
+    {
+        if (id >= m_size.load(std::memory_order_acquire)) {
+            return m_values[0].load(std::memory_order_relaxed)[EmptyId];
+        }
+        const int chunk = chunkOf(id);
+        return m_values[chunk].load(std::memory_order_relaxed)[id - chunkStart(chunk)];
+    }
+
+    int size() const { return int(m_size.load(std::memory_order_acquire)); }
+
+private:
+    // Il blocco k contiene ChunkSize << k voci: 24 blocchi coprono tutti gli ID sotto NoId
+    static constexpr Id ChunkSize = 256;
+    static constexpr int MaxChunks = 24;
+    static constexpr Id Capacity = ChunkSize * ((Id(1) << MaxChunks) - 1);
+
+    static int chunkOf(Id id) { return 31 - int(qCountLeadingZeroBits(quint32(id / ChunkSize + 1))); }
+    static Id chunkStart(int chunk) { return ChunkSize * ((Id(1) << chunk) - 1); }
+
+    // Blocchi a indirizzo fisso: un riferimento restituito da value() non viene mai invalidato
+    std::atomic<QString*> m_values[MaxChunks];
+    std::atomic<Id> m_size;
+    QHash<QString, Id> m_ids;
+    mutable QMutex m_mutex;
+};
+
+#endif // ATTRIBUTEDICTIONARY_H
@@ -3,8 +3,7 @@
 #include <QSysInfo>
 #include <QStandardPaths>
 #include <QDir>
-#include <QDebug>
-#include <iostream>
+#include "Logger.h"
 
 // Se hai OpenSSL disponibile, puoi usare AES-256
 // Altrimenti usiamo XOR con chiave derivata dal sistema
@@ -105,11 +104,11 @@ bool CredentialsManager::saveCredentials(const QString& email, const QString& pa
         m_settings->setValue("auth/saved", true);
         m_settings->sync();
 
-        std::cout << u8"✅ Credentials saved securely\n";
+        LOG_INFO("credentials", u8"✅ Credentials saved securely");
         return m_settings->status() == QSettings::NoError;
     }
     catch (...) {
-        std::cout << u8"❌ Failed to save credentials\n";
+        LOG_ERROR("credentials", u8"❌ Failed to save credentials");
         return false;
     }
 }
@@ -127,11 +126,11 @@ bool CredentialsManager::loadCredentials(QString& email, QString& password)
         email = decrypt(encryptedEmail);
         password = decrypt(encryptedPassword);
 
-        std::cout << u8"✅ Credentials loaded from secure storage\n";
+        LOG_INFO("credentials", u8"✅ Credentials loaded from secure storage");
         return !email.isEmpty() && !password.isEmpty();
     }
     catch (...) {
-        std::cout << u8"❌ Failed to load credentials\n";
+        LOG_ERROR("credentials", u8"❌ Failed to load credentials");
         return false;
     }
 }
@@ -149,7 +148,7 @@ void CredentialsManager::clearCredentials()
     m_settings->remove("auth/refreshToken");
     m_settings->sync();
 
-    std::cout << u8"🗑️ Credentials cleared\n";
+    LOG_INFO("credentials", u8"🗑️ Credentials cleared");
 }
 
 bool CredentialsManager::saveRefreshToken(const QString& refreshToken)
@@ -2,6 +2,7 @@
 #ifndef CREDENTIALSMANAGER_H
 #define CREDENTIALSMANAGER_H
 
+#include "homeinventorydata_global.h"
 #include <QString>
 #include <QByteArray>
 #include <QSettings>
@@ -10,7 +11,7 @@
  * @brief Classe per salvare e recuperare credenziali in modo sicuro
  * Le credenziali vengono criptate con AES-256 usando una chiave derivata dal sistema
  */
-class CredentialsManager
+class HOMEINVENTORYDATA_EXPORT CredentialsManager
 {
 public:
     CredentialsManager();
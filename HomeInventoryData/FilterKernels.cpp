@@ -0,0 +1,359 @@
+#include "FilterKernels.h"
+#include <QVarLengthArray>
+#include <atomic>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#  define HOMEINVENTORY_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#endif
+
+// MSVC compila gli intrinsics AVX2 senza /arch; GCC e Clang vogliono l'attributo per funzione
+#if defined(HOMEINVENTORY_X86) && !defined(_MSC_VER)
+#  define HOMEINVENTORY_TARGET_AVX2 __attribute__((target("avx2")))
+#  define HOMEINVENTORY_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#  define HOMEINVENTORY_TARGET_AVX2
+#  define HOMEINVENTORY_TARGET_SSE2
+#endif
+
+namespace {
+
+// Oltre questa dimensione l'insieme si consulta con una tabella, non con un confronto per valore
+const int MaxBroadcastValues = 16;
+
+// ==================== SCALAR ====================
+
+template <typename Predicate>
+void scalarScan(int begin, int rows, quint64* out, Predicate matches)
+{
+    for (int base = begin; base < rows; base += 64) {
+        const int end = qMin(base + 64, rows);
+        quint64 word = 0;
+        for (int row = base; row < end; ++row) {
+            word |= quint64(matches(row)) << (row - base);
+        }
+        out[base / 64] = word;
+    }
+}
+
+void equalsScalar(const qint32* column, int begin, int rows, qint32 value, quint64* out)
+{
+    scalarScan(begin, rows, out, [column, value](int row) {
+        return column[row] == value;
+    });
+}
+
+void equalsBothScalar(const qint32* first, qint32 firstValue, const qint32* second, qint32 secondValue,
+                      int begin, int rows, quint64* out)
+{
+    scalarScan(begin, rows, out, [=](int row) {
+        return (first[row] == firstValue) & (second[row] == secondValue);
+    });
+}
+
+void memberOfScalar(const quint32* column, int begin, int rows, const quint32* values, int valueCount, quint64* out)
+{
+    if (valueCount > MaxBroadcastValues) {
+        // Tabella di appartenenza indicizzata per ID
+        quint32 maxValue = 0;
+        for (int i = 0; i < valueCount; ++i) {
+            maxValue = qMax(maxValue, values[i]);
+        }
+        QVarLengthArray<quint8, 1024> table(qsizetype(maxValue) + 1);
+        std::fill(table.begin(), table.end(), quint8(0));
+        for (int i = 0; i < valueCount; ++i) {
+            table[values[i]] = 1;
+        }
+        scalarScan(begin, rows, out, [column, &table, maxValue](int row) {
+            return column[row] <= maxValue && table[column[row]];
+        });
+        return;
+    }
+
+    scalarScan(begin, rows, out, [column, values, valueCount](int row) {
+        bool hit = false;
+        for (int i = 0; i < valueCount; ++i) {
+            hit |= column[row] == values[i];
+        }
+        return hit;
+    });
+}
+
+#ifdef HOMEINVENTORY_X86
+
+// ==================== SSE2 ====================
+// 4 righe per confronto; 16 confronti riempiono una parola da 64 bit
+
+HOMEINVENTORY_TARGET_SSE2
+int equalsSse2(const qint32* column, int rows, qint32 value, quint64* out)
+{
+    const __m128i needle = _mm_set1_epi32(value);
+    const int full = rows / 64 * 64;
+
+    for (int base = 0; base < full; base += 64) {
+        quint64 word = 0;
+        for (int lane = 0; lane < 64; lane += 4) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + base + lane));
+            const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(data, needle)));
+            word |= quint64(mask) << lane;
+        }
+        out[base / 64] = word;
+    }
+    return full;
+}
+
+HOMEINVENTORY_TARGET_SSE2
+int equalsBothSse2(const qint32* first, qint32 firstValue, const qint32* second, qint32 secondValue,
+                   int rows, quint64* out)
+{
+    const __m128i firstNeedle = _mm_set1_epi32(firstValue);
+    const __m128i secondNeedle = _mm_set1_epi32(secondValue);
+    const int full = rows / 64 * 64;
+
+    for (int base = 0; base < full; base += 64) {
+        quint64 word = 0;
+        for (int lane = 0; lane < 64; lane += 4) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + base + lane));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + base + lane));
+            const __m128i hit = _mm_and_si128(_mm_cmpeq_epi32(a, firstNeedle), _mm_cmpeq_epi32(b, secondNeedle));
+            word |= quint64(_mm_movemask_ps(_mm_castsi128_ps(hit))) << lane;
+        }
+        out[base / 64] = word;
+    }
+    return full;
+}
+
+HOMEINVENTORY_TARGET_SSE2
+int memberOfSse2(const quint32* column, int rows, const quint32* values, int valueCount, quint64* out)
+{
+    __m128i needles[MaxBroadcastValues];
+    for (int i = 0; i < valueCount; ++i) {
+        needles[i] = _mm_set1_epi32(int(values[i]));
+    }
+    const int full = rows / 64 * 64;
+
+    for (int base = 0; base < full; base += 64) {
+        quint64 word = 0;
+        for (int lane = 0; lane < 64; lane += 4) {
+            const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + base + lane));
+            __m128i hit = _mm_setzero_si128();
+            for (int i = 0; i < valueCount; ++i) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi32(data, needles[i]));
+            }
+            word |= quint64(_mm_movemask_ps(_mm_castsi128_ps(hit))) << lane;
+        }
+        out[base / 64] = word;
+    }
+    return full;
+}
+
+// ==================== AVX2 ====================
+// 8 righe per confronto; 8 confronti riempiono una parola da 64 bit
+
+HOMEINVENTORY_TARGET_AVX2
+int equalsAvx2(const qint32* column, int rows, qint32 value, quint64* out)
+{
+    const __m256i needle = _mm256_set1_epi32(value);
+    const int full = rows / 64 * 64;
+
+    for (int base = 0; base < full; base += 64) {
+        quint64 word = 0;
+        for (int lane = 0; lane < 64; lane += 8) {
+            const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + base + lane));
+            const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(data, needle)));
+            word |= quint64(quint32(mask)) << lane;
+        }
+        out[base / 64] = word;
+    }
+    return full;
+}
+
+HOMEINVENTORY_TARGET_AVX2
+int equalsBothAvx2(const qint32* first, qint32 firstValue, const qint32* second, qint32 secondValue,
+                   int rows, quint64* out)
+{
+    const __m256i firstNeedle = _mm256_set1_epi32(firstValue);
+    const __m256i secondNeedle = _mm256_set1_epi32(secondValue);
+    const int full = rows / 64 * 64;
+
+    for (int base = 0; base < full; base += 64) {
+        quint64 word = 0;
+        for (int lane = 0; lane < 64; lane += 8) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + base + lane));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + base + lane));
+            const __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi32(a, firstNeedle), _mm256_cmpeq_epi32(b, secondNeedle));
+            word |= quint64(quint32(_mm256_movemask_ps(_mm256_castsi256_ps(hit)))) << lane;
+        }
+        out[base / 64] = word;
+    }
+    return full;
+}
+
+HOMEINVENTORY_TARGET_AVX2
+int memberOfAvx2(const quint32* column, int rows, const quint32* values, int valueCount, quint64* out)
+{
+    __m256i needles[MaxBroadcastValues];
+    for (int i = 0; i < valueCount; ++i) {
+        needles[i] = _mm256_set1_epi32(int(values[i]));
+    }
+    const int full = rows / 64 * 64;
+
+    for (int base = 0; base < full; base += 64) {
+        quint64 word = 0;
+        for (int lane = 0; lane < 64; lane += 8) {
+            const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + base + lane));
+            __m256i hit = _mm256_setzero_si256();
+            for (int i = 0; i < valueCount; ++i) {
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi32(data, needles[i]));
+            }
+            word |= quint64(quint32(_mm256_movemask_ps(_mm256_castsi256_ps(hit)))) << lane;
+        }
+        out[base / 64] = word;
+    }
+    return full;
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // AVX2 richiede anche che il sistema operativo salvi i registri YMM (OSXSAVE + XCR0)
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // HOMEINVENTORY_X86
+
+FilterKernels::Isa detectIsa()
+{
+#ifdef HOMEINVENTORY_X86
+    if (cpuHasAvx2()) {
+        return FilterKernels::Isa::Avx2;
+    }
+#  if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return FilterKernels::Isa::Sse2; // sempre presente su x86-64
+#  endif
+#endif
+    return FilterKernels::Isa::Scalar;
+}
+
+std::atomic<FilterKernels::Isa>& activeIsaRef()
+{
+    static std::atomic<FilterKernels::Isa> isa(FilterKernels::bestIsa());
+    return isa;
+}
+
+} // namespace
+
+FilterKernels::Isa FilterKernels::bestIsa()
+{
+    static const Isa best = detectIsa();
+    return best;
+}
+
+FilterKernels::Isa FilterKernels::activeIsa()
+{
+    return activeIsaRef().load(std::memory_order_relaxed);
+}
+
+void FilterKernels::setIsa(Isa isa)
+{
+    activeIsaRef().store(qMin(isa, bestIsa()), std::memory_order_relaxed);
+}
+
+const char* FilterKernels::isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::Avx2:
+        return "AVX2";
+    case Isa::Sse2:
+        return "SSE2";
+    case Isa::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+// I kernel vettoriali coprono le parole complete; le righe rimanenti passano dal codice scalare
+
+void FilterKernels::equals(const qint32* column, int rows, qint32 value, quint64* out)
+{
+    int done = 0;
+#ifdef HOMEINVENTORY_X86
+    switch (activeIsa()) {
+    case Isa::Avx2:
+        done = equalsAvx2(column, rows, value, out);
+        break;
+    case Isa::Sse2:
+        done = equalsSse2(column, rows, value, out);
+        break;
+    case Isa::Scalar:
+        break;
+    }
+#endif
+    equalsScalar(column, done, rows, value, out);
+}
+
+void FilterKernels::equalsBoth(const qint32* first, qint32 firstValue,
+                               const qint32* second, qint32 secondValue, int rows, quint64* out)
+{
+    int done = 0;
+#ifdef HOMEINVENTORY_X86
+    switch (activeIsa()) {
+    case Isa::Avx2:
+        done = equalsBothAvx2(first, firstValue, second, secondValue, rows, out);
+        break;
+    case Isa::Sse2:
+        done = equalsBothSse2(first, firstValue, second, secondValue, rows, out);
+        break;
+    case Isa::Scalar:
+        break;
+    }
+#endif
+    equalsBothScalar(first, firstValue, second, secondValue, done, rows, out);
+}
+
+void FilterKernels::memberOf(const quint32* column, int rows, const quint32* values, int valueCount, quint64* out)
+{
+    if (valueCount <= 0) {
+        std::fill(out, out + wordCount(rows), quint64(0));
+        return;
+    }
+
+    int done = 0;
+#ifdef HOMEINVENTORY_X86
+    if (valueCount <= MaxBroadcastValues) {
+        switch (activeIsa()) {
+        case Isa::Avx2:
+            done = memberOfAvx2(column, rows, values, valueCount, out);
+            break;
+        case Isa::Sse2:
+            done = memberOfSse2(column, rows, values, valueCount, out);
+            break;
+        case Isa::Scalar:
+            break;
+        }
+    }
+#endif
+    memberOfScalar(column, done, rows, values, valueCount, out);
+}
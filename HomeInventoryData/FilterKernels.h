@@ -0,0 +1,42 @@
+#pragma once
+#ifndef FILTERKERNELS_H
+#define FILTERKERNELS_H
+
+#include "homeinventorydata_global.h"
+#include <QtGlobal>
+
+/**
+ * @brief Kernel di confronto sulle colonne di ID (vedi ObjectTable)
+ * Ogni kernel confronta una colonna con un valore o un piccolo insieme di valori e scrive
+ * la selezione come maschera di bit: 64 righe per parola, riga i = bit (i % 64) della parola i / 64
+ * L'implementazione (AVX2, SSE2 o scalare) viene scelta a runtime in base alla CPU
+ */
+class HOMEINVENTORYDATA_EXPORT FilterKernels
+{
+public:
+    enum class Isa
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    static Isa bestIsa();   // la migliore supportata dalla CPU
+    static Isa activeIsa(); // quella in uso
+    static void setIsa(Isa isa); // forza un'implementazione (benchmark); limitata a bestIsa()
+    static const char* isaName(Isa isa);
+
+    static int wordCount(int rows) { return (rows + 63) / 64; }
+
+    // out[wordCount(rows)]: bit a 1 dove column[i] == value
+    static void equals(const qint32* column, int rows, qint32 value, quint64* out);
+
+    // out[wordCount(rows)]: bit a 1 dove first[i] == firstValue && second[i] == secondValue
+    static void equalsBoth(const qint32* first, qint32 firstValue,
+                           const qint32* second, qint32 secondValue, int rows, quint64* out);
+
+    // out[wordCount(rows)]: bit a 1 dove column[i] e' uno dei values[0..valueCount)
+    static void memberOf(const quint32* column, int rows, const quint32* values, int valueCount, quint64* out);
+};
+
+#endif // FILTERKERNELS_H
@@ -1,26 +1,175 @@
-﻿#include "firebasedatabasemanager.h"
+﻿#include "FirebaseDatabaseManager.h"
 #include "HomeObject.h"
+#include "HomeObjectCodec.h"
 #include <QNetworkRequest>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QUrlQuery>
-#include <QDebug>
-#include <iostream>
+#include <QCryptographicHash>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QFile>
+#include <QDeadlineTimer>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+#include "Logger.h"
 #include <QDateTime>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+namespace {
+
+const char* const LogCategory = "firebase";
+const int RequestTimeoutMs = 10000; // 10 secondi di inattivita' per le richieste di autenticazione
+const int TokenRefreshMarginSecs = 300; // il token si rinnova 5 minuti prima della scadenza
+const int TokenRefreshRetryMs = 30000;  // nuovo tentativo se il rinnovo in background fallisce
+const int KeepWarmIntervalMs = 60000;   // Qt chiude le connessioni inattive dopo 120 secondi
+const int SnapshotSaveIntervalMs = 5000; // lo snapshot su disco si riscrive solo se la cache e' cambiata
+
+template <typename T>
+std::shared_ptr<QPromise<T>> makePromise()
+{
+    auto promise = std::make_shared<QPromise<T>>();
+    promise->start();
+    return promise;
+}
+
+template <typename T>
+QFuture<T> fulfil(const std::shared_ptr<QPromise<T>>& promise, const T& value)
+{
+    promise->addResult(value);
+    promise->finish();
+    return promise->future();
+}
+
+// Misura un'operazione pubblica dalla chiamata al completamento del future.
+// Per le operazioni bool il risultato e' l'esito; le altre contano come riuscite se non annullate.
+template <typename T>
+void trackOperation(const std::shared_ptr<FirebaseMetrics>& metrics, const char* operation, QFuture<T> future)
+{
+    QElapsedTimer timer;
+    timer.start();
+    future.then([metrics, operation, timer](QFuture<T> finished) {
+        bool success = !finished.isCanceled();
+        if constexpr (std::is_same_v<T, bool>) {
+            success = success && finished.resultCount() > 0 && finished.result();
+        }
+        metrics->recordOperation(QString::fromLatin1(operation), timer.nsecsElapsed() / 1000, success);
+    });
+}
+
+// Attende un'operazione asincrona: usato solo dalle API sincrone di IDatabaseManager,
+// mantenute per compatibilita'. La GUI deve usare le varianti *Async.
+template <typename T>
+T waitForResult(QFuture<T> future)
+{
+    if (!future.isFinished()) {
+        QEventLoop loop;
+        QFutureWatcher<T> watcher;
+        QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+        watcher.setFuture(future);
+        loop.exec();
+    }
+    return future.resultCount() > 0 ? future.result() : T();
+}
+
+QByteArray toPayload(const QJsonValue& data)
+{
+    if (data.isObject()) {
+        return QJsonDocument(data.toObject()).toJson(QJsonDocument::Compact);
+    }
+    if (data.isArray()) {
+        return QJsonDocument(data.toArray()).toJson(QJsonDocument::Compact);
+    }
+
+    // Valori scalari: serializza dentro un array e togli le parentesi
+    QByteArray wrapped = QJsonDocument(QJsonArray{ data }).toJson(QJsonDocument::Compact);
+    return wrapped.mid(1, wrapped.size() - 2);
+}
+
+// Apre la connessione (DNS, TCP e TLS) senza inviare richieste: la prima vera richiesta la trova pronta
+void preconnectTo(QNetworkAccessManager* manager, const QUrl& url)
+{
+    if (!url.isValid() || url.host().isEmpty()) {
+        return;
+    }
+
+#if QT_CONFIG(ssl)
+    if (url.scheme() == "https") {
+        // Con h2 negoziato via ALPN la connessione preaperta e' quella HTTP/2 che useranno le richieste
+        QSslConfiguration sslConfiguration = QSslConfiguration::defaultConfiguration();
+        sslConfiguration.setAllowedNextProtocols({ QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1 });
+        manager->connectToHostEncrypted(url.host(), quint16(url.port(443)), sslConfiguration);
+        return;
+    }
+#endif
+    manager->connectToHost(url.host(), quint16(url.port(80)));
+}
+
+} // namespace
 
 FirebaseDatabaseManager::FirebaseDatabaseManager(QObject* parent)
     : QObject(parent)
+    , m_identityToolkitUrl("https://identitytoolkit.googleapis.com/v1")
+    , m_secureTokenUrl("https://securetoken.googleapis.com/v1")
     , m_isConnected(false)
 	, m_isAuthenticated(false)
     , m_networkManager(new QNetworkAccessManager(this))
 	, m_credentialsManager(new CredentialsManager())
-    , m_isRefreshingToken(false)
+    , m_tokenRefreshTimer(new QTimer(this))
+    , m_streamRetryMs(1000)
+    , m_batchChunkBytes(1024 * 1024)
+    , m_metrics(std::make_shared<FirebaseMetrics>())
+    , m_metricsDumpTimer(new QTimer(this))
+    , m_keepWarmTimer(new QTimer(this))
+    , m_snapshotSaveTimer(new QTimer(this))
+    , m_warmUpEnabled(true)
 {
+    m_pictureCache.setMaxCost(64 * 1024 * 1024); // 64 MB di foto in memoria
+
+    // Rinnovo del token in background: le richieste non pagano mai 401 + refresh + replay
+    m_tokenRefreshTimer->setSingleShot(true);
+    QObject::connect(m_tokenRefreshTimer, &QTimer::timeout, this, [this]() {
+        refreshAccessToken([this](bool refreshed) {
+            if (!refreshed && m_isAuthenticated) {
+                m_tokenRefreshTimer->start(TokenRefreshRetryMs);
+            }
+        });
+    });
+
+    QObject::connect(m_metricsDumpTimer, &QTimer::timeout, this, [this]() {
+        writeMetricsDump();
+    });
+
+    // Dopo un periodo di inattivita' riapre le connessioni prima che la cache di Qt le chiuda
+    m_keepWarmTimer->setInterval(KeepWarmIntervalMs);
+    QObject::connect(m_keepWarmTimer, &QTimer::timeout, this, [this]() {
+        if (!m_lastRequest.isValid() || m_lastRequest.elapsed() >= m_keepWarmTimer->interval()) {
+            preconnect();
+        }
+    });
+
+    QObject::connect(m_snapshotSaveTimer, &QTimer::timeout, this, [this]() {
+        if (m_objectCache.isComplete() && m_objectCache.revision() != m_snapshotRevision) {
+            saveSnapshot();
+        }
+    });
+
+    // Dopo il login la cache ripartita dallo snapshot si riconcilia senza attendere una lettura
+    QObject::connect(this, &FirebaseDatabaseManager::authenticationCompleted, this, [this](bool success) {
+        if (success) {
+            reconcileObjects();
+        }
+    });
 }
 
 FirebaseDatabaseManager::~FirebaseDatabaseManager()
 {
+    writeMetricsDump(); // ultima fotografia prima di chiudere
     disconnect();
     delete m_credentialsManager;
 }
@@ -36,8 +185,12 @@ bool FirebaseDatabaseManager::connect(const QString& firebaseUrl)
 
 	m_isConnected = true; //(Checkare perchè mi sembra brutto metterlo a true senza/prima di testare la connessione)
 
-    std::cout << u8"🔗 Firebase URL configured: ";
-    qDebug() << m_firebaseUrl;
+    LOG_INFO(LogCategory, u8"🔗 Firebase URL configured: " << m_firebaseUrl);
+
+    preconnect();
+    if (m_warmUpEnabled && m_keepWarmTimer->interval() > 0) {
+        m_keepWarmTimer->start();
+    }
 
     return true;
     // Test della connessione con una semplice GET request
@@ -66,1083 +219,2457 @@ bool FirebaseDatabaseManager::setApiKey(const QString& apiKey)
     }
 
     m_apiKey = apiKey;
-    std::cout << u8"🔑 API Key configured\n";
+    LOG_INFO(LogCategory, u8"🔑 API Key configured");
+
+    // Il login arriva subito dopo: la connessione verso l'host di autenticazione si apre ora
+    preconnect();
     return true;
 }
 
 bool FirebaseDatabaseManager::tryAutoLogin()
 {
+    return waitForResult(tryAutoLoginAsync());
+}
+
+QFuture<bool> FirebaseDatabaseManager::tryAutoLoginAsync()
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "tryAutoLogin", promise->future());
+
     if (!m_credentialsManager->hasStoredCredentials()) {
-        std::cout << u8"ℹ️ No saved credentials found\n";
-        return false;
+        LOG_INFO(LogCategory, u8"ℹ️ No saved credentials found");
+        return fulfil(promise, false);
     }
 
-    std::cout << u8"🔐 Attempting auto-login with saved credentials...\n";
+    LOG_INFO(LogCategory, u8"🔐 Attempting auto-login with saved credentials...");
 
     QString email, password;
     if (!m_credentialsManager->loadCredentials(email, password)) {
         setLastError("Failed to load saved credentials");
-        return false;
+        return fulfil(promise, false);
     }
 
+    auto signIn = [this, promise, email, password]() {
+        signInWithEmailPassword(email, password, [this, promise](bool success) {
+            if (success) {
+                LOG_INFO(LogCategory, u8"✅ Auto-login successful, logged in as " << m_userEmail);
+                emit authenticationCompleted(true, m_userEmail);
+            }
+            fulfil(promise, success);
+        });
+    };
+
     // Prova prima con il refresh token se disponibile
     QString refreshToken = m_credentialsManager->loadRefreshToken();
-    if (!refreshToken.isEmpty()) {
-        m_refreshToken = refreshToken;
-        if (refreshAccessToken()) {
-            m_userEmail = email;
-            m_isAuthenticated = true;
-            std::cout << u8"✅ Auto-login successful with refresh token!\n";
-            std::cout << u8"👤 Logged in as: ";
-            qDebug() << m_userEmail;
-            emit authenticationCompleted(true, m_userEmail);
-            return true;
-        }
+    if (refreshToken.isEmpty()) {
+        signIn();
+        return promise->future();
     }
 
-    // Altrimenti usa email e password
-    bool success = signInWithEmailPassword(email, password);
-    if (success) {
-        std::cout << u8"✅ Auto-login successful!\n";
-        std::cout << u8"👤 Logged in as: ";
-        qDebug() << m_userEmail;
+    m_refreshToken = refreshToken;
+    refreshAccessToken([this, promise, email, signIn](bool refreshed) {
+        if (!refreshed) {
+            // Altrimenti usa email e password
+            signIn();
+            return;
+        }
+
+        m_userEmail = email;
+        m_isAuthenticated = true;
+        LOG_INFO(LogCategory, u8"✅ Auto-login successful with refresh token, logged in as " << m_userEmail);
         emit authenticationCompleted(true, m_userEmail);
-    }
+        fulfil(promise, true);
+    });
 
-    return success;
+    return promise->future();
 }
 
 bool FirebaseDatabaseManager::authenticateWithEmail(const QString& email, const QString& password, bool rememberMe)
 {
+    return waitForResult(authenticateWithEmailAsync(email, password, rememberMe));
+}
+
+QFuture<bool> FirebaseDatabaseManager::authenticateWithEmailAsync(const QString& email, const QString& password, bool rememberMe)
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "authenticateWithEmail", promise->future());
+
     if (email.isEmpty() || password.isEmpty()) {
         setLastError("Email and password cannot be empty");
-        return false;
+        return fulfil(promise, false);
     }
 
-    std::cout << u8"🔐 Authenticating with email/password...\n";
+    LOG_INFO(LogCategory, u8"🔐 Authenticating with email/password...");
 
-    bool success = signInWithEmailPassword(email, password);
+    signInWithEmailPassword(email, password, [this, promise, email, password, rememberMe](bool success) {
+        if (success) {
+            LOG_INFO(LogCategory, u8"✅ Authentication successful, logged in as " << m_userEmail);
 
-    if (success) {
-        std::cout << u8"✅ Authentication successful!\n";
-        std::cout << u8"👤 Logged in as: ";
-        qDebug() << m_userEmail;
-
-        // Salva le credenziali se richiesto
-        if (rememberMe) {
-            if (m_credentialsManager->saveCredentials(email, password)) {
-                std::cout << u8"💾 Credentials saved for auto-login\n";
-            }
-            if (!m_refreshToken.isEmpty()) {
-                m_credentialsManager->saveRefreshToken(m_refreshToken);
+            // Salva le credenziali se richiesto
+            if (rememberMe) {
+                if (m_credentialsManager->saveCredentials(email, password)) {
+                    LOG_INFO(LogCategory, u8"💾 Credentials saved for auto-login");
+                }
+                if (!m_refreshToken.isEmpty()) {
+                    m_credentialsManager->saveRefreshToken(m_refreshToken);
+                }
             }
+
+            emit authenticationCompleted(true, m_userEmail);
+        }
+        else {
+            LOG_WARNING(LogCategory, u8"❌ Authentication failed");
+            emit authenticationCompleted(false, "");
         }
 
-        emit authenticationCompleted(true, m_userEmail);
-    }
-    else {
-        std::cout << u8"❌ Authentication failed!\n";
-        emit authenticationCompleted(false, "");
-    }
+        fulfil(promise, success);
+    });
 
-    return success;
+    return promise->future();
 }
 
-bool FirebaseDatabaseManager::signInWithEmailPassword(const QString& email, const QString& password)
+void FirebaseDatabaseManager::signInWithEmailPassword(const QString& email, const QString& password, ResultCallback callback)
 {
     if (m_apiKey.isEmpty()) {
         setLastError("API Key not configured. Call setApiKey() first.");
-        return false;
+        callback(false);
+        return;
     }
 
-    QUrl url("https://identitytoolkit.googleapis.com/v1/accounts:signInWithPassword");
+    QUrl url(m_identityToolkitUrl + "/accounts:signInWithPassword");
     QUrlQuery query;
     query.addQueryItem("key", m_apiKey);
     url.setQuery(query);
 
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    QNetworkRequest request = makeRequest(url, "application/json");
 
     QJsonObject postData;
     postData["email"] = email;
     postData["password"] = password;
     postData["returnSecureToken"] = true;
 
-    QJsonDocument doc(postData);
-    QNetworkReply* reply = m_networkManager->post(request, doc.toJson());
-
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
-
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
-
-    timer.start(10000);
-    loop.exec();
-
-    if (!timer.isActive()) {
-        setLastError("Request timeout");
-        reply->deleteLater();
-        return false;
-    }
-    timer.stop();
-
-    bool success = false;
+    const QByteArray body = QJsonDocument(postData).toJson();
+    dispatch(m_networkManager->post(request, body), body.size(), RequestTimeoutMs, [this, callback](QNetworkReply* reply) {
+        if (reply->property("timedOut").toBool()) {
+            setLastError("Request timeout");
+            callback(false);
+            return;
+        }
 
-    if (reply->error() == QNetworkReply::NoError) {
-        QByteArray response = reply->readAll();
-        QJsonDocument responseDoc = QJsonDocument::fromJson(response);
-        QJsonObject responseObj = responseDoc.object();
+        bool success = false;
 
-        m_idToken = responseObj["idToken"].toString();
-        m_refreshToken = responseObj["refreshToken"].toString();
-        m_userEmail = responseObj["email"].toString();
-        m_userId = responseObj["localId"].toString();
+        if (reply->error() == QNetworkReply::NoError) {
+            QByteArray response = reply->readAll();
+            QJsonDocument responseDoc = QJsonDocument::fromJson(response);
+            QJsonObject responseObj = responseDoc.object();
 
-        int expiresIn = responseObj["expiresIn"].toString().toInt();
-        if (expiresIn == 0) expiresIn = 3600; // Default 1 hr
-		m_tokenExpiry = QDateTime::currentDateTime().addSecs(expiresIn - 300); // Refresh 5 min before expiry
+            m_idToken = responseObj["idToken"].toString();
+            m_refreshToken = responseObj["refreshToken"].toString();
+            m_userEmail = responseObj["email"].toString();
+            m_userId = responseObj["localId"].toString();
 
-        m_isAuthenticated = !m_idToken.isEmpty();
-        success = m_isAuthenticated;
-    }
-    else {
-        QByteArray response = reply->readAll();
-        QJsonDocument responseDoc = QJsonDocument::fromJson(response);
-        QJsonObject errorObj = responseDoc.object()["error"].toObject();
-        QString errorMessage = errorObj["message"].toString();
+            int expiresIn = responseObj["expiresIn"].toString().toInt();
+            if (expiresIn == 0) expiresIn = 3600; // Default 1 hr
+            setTokenLifetime(expiresIn);
 
-        // Messaggi di errore user-friendly
-        if (errorMessage.contains("INVALID_PASSWORD")) {
-            setLastError("Invalid password");
-        }
-        else if (errorMessage.contains("EMAIL_NOT_FOUND")) {
-            setLastError("Email not found");
-        }
-        else if (errorMessage.contains("USER_DISABLED")) {
-            setLastError("This account has been disabled");
-        }
-        else if (errorMessage.contains("TOO_MANY_ATTEMPTS")) {
-            setLastError("Too many failed attempts. Please try again later");
+            m_isAuthenticated = !m_idToken.isEmpty();
+            success = m_isAuthenticated;
+            if (success) {
+                scheduleTokenRefresh();
+            }
         }
         else {
-            setLastError("Authentication failed: " + errorMessage);
+            QByteArray response = reply->readAll();
+            QJsonDocument responseDoc = QJsonDocument::fromJson(response);
+            QJsonObject errorObj = responseDoc.object()["error"].toObject();
+            QString errorMessage = errorObj["message"].toString();
+
+            // Messaggi di errore user-friendly
+            if (errorMessage.contains("INVALID_PASSWORD")) {
+                setLastError("Invalid password");
+            }
+            else if (errorMessage.contains("EMAIL_NOT_FOUND")) {
+                setLastError("Email not found");
+            }
+            else if (errorMessage.contains("USER_DISABLED")) {
+                setLastError("This account has been disabled");
+            }
+            else if (errorMessage.contains("TOO_MANY_ATTEMPTS")) {
+                setLastError("Too many failed attempts. Please try again later");
+            }
+            else {
+                setLastError("Authentication failed: " + errorMessage);
+            }
         }
-    }
 
-    reply->deleteLater();
-    return success;
+        callback(success);
+    });
 }
 
-bool FirebaseDatabaseManager::refreshAccessToken()
+void FirebaseDatabaseManager::refreshAccessToken(ResultCallback callback)
 {
-    if (m_isRefreshingToken) {
-        std::cout << u8"⏳ Token refresh already in progress, skipping...\n";
-        return false;
-    }
+    // Un solo refresh in volo: chi arriva nel frattempo ne attende l'esito
+    m_refreshWaiters.append(callback);
+    if (m_refreshWaiters.size() > 1) {
+        LOG_DEBUG(LogCategory, u8"⏳ Token refresh already in progress, waiting...");
+        return;
+    }
+
+    auto notifyWaiters = [this](bool success) {
+        const QList<ResultCallback> waiters = std::move(m_refreshWaiters);
+        m_refreshWaiters.clear();
+        for (const auto& waiter : waiters) {
+            waiter(success);
+        }
+    };
 
     if (m_refreshToken.isEmpty()) {
         setLastError("No refresh token available");
-        return false;
+        notifyWaiters(false);
+        return;
     }
 
     if (m_apiKey.isEmpty()) {
         setLastError("API Key not configured");
-        return false;
+        notifyWaiters(false);
+        return;
     }
 
-    std::cout << u8"🔄 Starting token refresh...\n";
-	m_isRefreshingToken = true;
+    LOG_DEBUG(LogCategory, u8"🔄 Starting token refresh...");
 
-    QUrl url("https://securetoken.googleapis.com/v1/token");
+    QUrl url(m_secureTokenUrl + "/token");
     QUrlQuery query;
     query.addQueryItem("key", m_apiKey);
     url.setQuery(query);
 
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-
-    QString postData = QString("grant_type=refresh_token&refresh_token=%1").arg(m_refreshToken);
-
-    QNetworkReply* reply = m_networkManager->post(request, postData.toUtf8());
-
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
-
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QNetworkRequest request = makeRequest(url, "application/x-www-form-urlencoded");
 
-    timer.start(10000);
-    loop.exec();
+    const QByteArray postData = QString("grant_type=refresh_token&refresh_token=%1").arg(m_refreshToken).toUtf8();
 
-    if (!timer.isActive()) {
-        setLastError("Token refresh timeout");
-        reply->deleteLater();
-		m_isRefreshingToken = false;
-        return false;
-    }
-    timer.stop();
+    dispatch(m_networkManager->post(request, postData), postData.size(), RequestTimeoutMs, [this, notifyWaiters](QNetworkReply* reply) {
+        if (reply->property("timedOut").toBool()) {
+            setLastError("Token refresh timeout");
+            m_metrics->recordTokenRefresh(false);
+            notifyWaiters(false);
+            return;
+        }
 
-    bool success = false;
+        bool success = false;
 
-    if (reply->error() == QNetworkReply::NoError) {
-        QByteArray responseData = reply->readAll();
-        // std::cout << u8"📥 Refresh response:"; qDebug() << responseData;  // DUBUG: print all json response data, very long, decomment only if needed
+        if (reply->error() == QNetworkReply::NoError) {
+            QByteArray responseData = reply->readAll();
+            // LOG_TRACE(LogCategory, u8"📥 Refresh response: " << responseData);  // DUBUG: contiene i token, decommentare solo se serve
 
-        QJsonDocument responseDoc = QJsonDocument::fromJson(responseData);
-        QJsonObject responseObj = responseDoc.object();
+            QJsonDocument responseDoc = QJsonDocument::fromJson(responseData);
+            QJsonObject responseObj = responseDoc.object();
 
-        QString newIdToken = responseObj["id_token"].toString();
-        QString newRefreshToken = responseObj["refresh_token"].toString();
+            QString newIdToken = responseObj["id_token"].toString();
+            QString newRefreshToken = responseObj["refresh_token"].toString();
 
-        if (!newIdToken.isEmpty()) {
-            m_idToken = newIdToken;
-            m_refreshToken = newRefreshToken;
+            if (!newIdToken.isEmpty()) {
+                m_idToken = newIdToken;
+                m_refreshToken = newRefreshToken;
 
-            // Aggiorna la scadenza del token
-            int expiresIn = responseObj["expires_in"].toString().toInt();
-            if (expiresIn == 0) expiresIn = 3600;
-            m_tokenExpiry = QDateTime::currentDateTime().addSecs(expiresIn - 300);
+                // Aggiorna la scadenza del token
+                int expiresIn = responseObj["expires_in"].toString().toInt();
+                if (expiresIn == 0) expiresIn = 3600;
+                setTokenLifetime(expiresIn);
 
-            success = true;
+                success = true;
+                scheduleTokenRefresh();
 
-            // Salva il nuovo refresh token
-            m_credentialsManager->saveRefreshToken(m_refreshToken);
+                // Salva il nuovo refresh token
+                m_credentialsManager->saveRefreshToken(m_refreshToken);
 
-            std::cout << u8"\n✅ Token refreshed successfully";
-            std::cout << u8"\n🔑 New token length:" << m_idToken.length();
-            std::cout << u8"\n⏰ Token expires:";
-            qDebug() << m_tokenExpiry.toString();
+                LOG_INFO(LogCategory, u8"✅ Token refreshed, length " << m_idToken.length()
+                         << u8", next refresh at " << m_tokenExpiry.toString());
+            }
+            else {
+                setLastError("Token refresh returned empty token");
+                LOG_ERROR(LogCategory, u8"❌ Empty token in refresh response");
+            }
         }
         else {
-            setLastError("Token refresh returned empty token");
-            std::cout << u8"\n❌ Empty token in response";
+            QByteArray errorData = reply->readAll();
+            LOG_ERROR(LogCategory, u8"❌ Refresh error: " << errorData);
+            setLastError("Token refresh failed: " + reply->errorString());
         }
-    }
-    else {
-        QByteArray errorData = reply->readAll();
-        std::cout << u8"\n❌ Refresh error:" << errorData;
-        setLastError("Token refresh failed: " + reply->errorString());
-    }
 
-    reply->deleteLater();
-	m_isRefreshingToken = false;
-    return success;
+        m_metrics->recordTokenRefresh(success);
+        notifyWaiters(success);
+    });
+}
+
+void FirebaseDatabaseManager::setTokenLifetime(int expiresIn)
+{
+    // Token molto brevi (emulatore): si rinnova a meta' vita invece che 5 minuti prima
+    const QDateTime now = QDateTime::currentDateTime();
+    m_tokenValidUntil = now.addSecs(expiresIn);
+    m_tokenExpiry = now.addSecs(expiresIn - qMin(TokenRefreshMarginSecs, expiresIn / 2));
+}
+
+void FirebaseDatabaseManager::scheduleTokenRefresh()
+{
+    // m_tokenExpiry include gia' il margine: a quell'ora il token e' ancora valido
+    const qint64 delayMs = QDateTime::currentDateTime().msecsTo(m_tokenExpiry);
+    m_tokenRefreshTimer->start(int(qBound<qint64>(0, delayMs, std::numeric_limits<int>::max())));
+}
+
+bool FirebaseDatabaseManager::isTokenExpired() const
+{
+    return m_tokenValidUntil.isValid() && QDateTime::currentDateTime() >= m_tokenValidUntil;
 }
 
 void FirebaseDatabaseManager::disconnect()
 {
+    // Ultimo stato noto su disco prima di svuotare la cache
+    if (m_objectCache.isComplete() && m_objectCache.revision() != m_snapshotRevision) {
+        saveSnapshot();
+    }
+    m_snapshot.close();
+
+    unsubscribe();
+    m_tokenRefreshTimer->stop();
+    m_keepWarmTimer->stop();
     m_isConnected = false;
     m_isAuthenticated = false;
     m_firebaseUrl.clear();
     m_idToken.clear();
     m_refreshToken.clear();
+    m_tokenExpiry = QDateTime();
+    m_tokenValidUntil = QDateTime();
     m_userEmail.clear();
     m_userId.clear();
+    m_objectCache.clear();
+    m_pictureCache.clear();
+    m_storedPictures.clear();
+    m_attributeSnapshots.clear();
+    m_keyedNodes.clear();
 }
 
 void FirebaseDatabaseManager::logout(bool clearSavedCredentials)
 {
-    std::cout << u8"👋 Logging out user: ";
-    qDebug() << m_userEmail;
+    LOG_INFO(LogCategory, u8"👋 Logging out user: " << m_userEmail);
 
     if (clearSavedCredentials) {
         m_credentialsManager->clearCredentials();
-        std::cout << u8"🗑️ Saved credentials cleared\n";
+        LOG_INFO(LogCategory, u8"🗑️ Saved credentials cleared");
+
+        // Senza credenziali salvate non resta nemmeno l'inventario su disco
+        if (!m_snapshotPath.isEmpty()) {
+            m_snapshot.close();
+            QFile::remove(m_snapshotPath);
+            m_snapshotRevision = m_objectCache.revision();
+        }
     }
 
     disconnect();
 }
 
-bool FirebaseDatabaseManager::isConnected() const
+void FirebaseDatabaseManager::setCacheMaxAge(qint64 msecs)
 {
-    return m_isConnected;
+    m_objectCache.setMaxAge(msecs);
 }
 
-bool FirebaseDatabaseManager::isAuthenticated() const
+void FirebaseDatabaseManager::invalidateCache()
 {
-    return m_isAuthenticated;
+    m_objectCache.invalidate();
+    m_attributeSnapshots.clear();
+    m_keyedNodes.clear();
 }
 
-QString FirebaseDatabaseManager::currentUserEmail() const
+QList<HomeObject> FirebaseDatabaseManager::cachedObjects() const
 {
-    return m_userEmail;
+    return m_objectCache.objects();
 }
 
-QString FirebaseDatabaseManager::lastError() const
+bool FirebaseDatabaseManager::setSnapshotFile(const QString& filePath)
 {
-    return m_lastError;
-}
+    m_snapshot.close();
+    m_snapshotPath = filePath;
 
-void FirebaseDatabaseManager::setLastError(const QString& error)
-{
-    m_lastError = error;
-    if (!error.isEmpty()) {
-        std::cout << u8"❌ Firebase Error: ";
-        qDebug() << error;
+    if (filePath.isEmpty()) {
+        m_snapshotSaveTimer->stop();
+        return false;
     }
-}
-
-QString FirebaseDatabaseManager::buildUrl(const QString& path) const
-{
-    QString url = m_firebaseUrl + path;
+    m_snapshotSaveTimer->start(SnapshotSaveIntervalMs);
 
-    if (m_isAuthenticated && !m_idToken.isEmpty()) {
-        QUrl qUrl(url);
-        QUrlQuery query(qUrl);
-        query.addQueryItem("auth", m_idToken);
-        qUrl.setQuery(query);
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_snapshot.open(filePath)) {
+        LOG_INFO(LogCategory, u8"💾 No snapshot loaded: " << m_snapshot.errorString());
+        return false;
+    }
 
-        // DEBUG: Stampa l'URL (solo i primi caratteri del token per sicurezza)
-        std::cout << u8"🔗 Request URL: "; 
-        qDebug() << qUrl.toString().left(100) + "...";
-        std::cout << u8"🔑 Token present:" << !m_idToken.isEmpty() << "Length:" << m_idToken.length() << "\n";
+    // Il watermark di un altro database non e' un punto di partenza valido per il delta
+    if (m_snapshot.source() != m_firebaseUrl) {
+        LOG_INFO(LogCategory, u8"💾 Snapshot of another database ignored: " << m_snapshot.source().toString());
+        m_snapshot.close();
+        return false;
+    }
 
-        return qUrl.toString();
+    // Una cache gia' caricata dalla rete e' piu' recente dello snapshot
+    if (!m_objectCache.isComplete()) {
+        m_objectCache.restore(m_snapshot.objects(), m_snapshot.watermark());
+        m_snapshotRevision = m_objectCache.revision();
+        LOG_INFO(LogCategory, u8"💾 Restored " << m_snapshot.size() << " objects from the snapshot of "
+                 << m_snapshot.savedAt().toString(Qt::ISODate) << " in " << timer.elapsed() << " ms");
+        emit objectsReset();
     }
 
-    std::cout << u8"⚠️ Building URL without auth token!\n";
-    return url;
+    reconcileObjects();
+    return true;
 }
 
-// ==================== GET REQUEST ====================
-QJsonDocument FirebaseDatabaseManager::performGetRequest(const QString& path, int retryCount)
+bool FirebaseDatabaseManager::saveSnapshot()
 {
-    if(!m_isAuthenticated) {
-        setLastError("Not authenticated. Please log in first.");
-        emit authenticationRequired();
-        return QJsonDocument();
-	}
-
-    QUrl url(buildUrl(path));
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-
-    QNetworkReply* reply = m_networkManager->get(request);
-
-    // Attendi la risposta (modo sincrono per semplicità)
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
-
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
-
-    timer.start(10000); // 10 secondi timeout
-    loop.exec();
-
-    if (!timer.isActive()) {
-        setLastError("Request timeout");
-        reply->deleteLater();
-        return QJsonDocument();
+    if (m_snapshotPath.isEmpty() || !m_objectCache.isComplete()) {
+        return false;
     }
-    timer.stop();
 
-    if (reply->error() == QNetworkReply::AuthenticationRequiredError) {
-        reply->deleteLater();
-
-        if (retryCount < 1) {  // <-- CAMBIATO: solo 1 retry
-            std::cout << u8"⚠️ Authentication error, attempting token refresh...\n";
-            if (refreshAccessToken()) {
-                std::cout << u8"🔄 Retrying request after token refresh...\n";
-                return performGetRequest(path, retryCount + 1);  // <-- Incrementa retry
-            }
-        }
+    QElapsedTimer timer;
+    timer.start();
 
-        setLastError("Authentication expired. Please login again.");
-        m_isAuthenticated = false; 
-        emit authenticationRequired();
-        return QJsonDocument();
+    // Su Windows un file mappato non si puo' sostituire: la vista si chiude e si riapre sul file nuovo
+    m_snapshot.close();
+    QString error;
+    const bool saved = ObjectSnapshot::write(m_snapshotPath, m_firebaseUrl, m_objectCache.objects(),
+                                             m_objectCache.syncWatermark(), &error);
+    if (saved) {
+        m_snapshotRevision = m_objectCache.revision();
+        LOG_DEBUG(LogCategory, u8"💾 Snapshot saved: " << m_objectCache.size() << " objects in " << timer.elapsed() << " ms");
     }
-
-    if (reply->error() != QNetworkReply::NoError) {
-        setLastError(reply->errorString());
-        reply->deleteLater();
-        return QJsonDocument();
+    else {
+        LOG_WARNING(LogCategory, u8"⚠️ Cannot write snapshot " << m_snapshotPath << ": " << error);
     }
 
-    QByteArray responseData = reply->readAll();
-    reply->deleteLater();
-
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
+    m_snapshot.open(m_snapshotPath);
+    return saved;
+}
 
-    if (parseError.error != QJsonParseError::NoError) {
-        setLastError("JSON parse error: " + parseError.errorString());
-        return QJsonDocument();
-    }
+void FirebaseDatabaseManager::setBatchChunkSize(qint64 bytes)
+{
+    m_batchChunkBytes = bytes;
+}
 
-    return doc;
+void FirebaseDatabaseManager::setPictureCacheSize(qint64 bytes)
+{
+    m_pictureCache.setMaxCost(bytes);
 }
 
-// ==================== PUT REQUEST ====================
-bool FirebaseDatabaseManager::performPutRequest(const QString& path, const QJsonValue& data, int retryCount)
+void FirebaseDatabaseManager::setNetworkAccessManager(QNetworkAccessManager* manager)
 {
-    if (!m_isAuthenticated) {
-        setLastError("Not authenticated. Please log in first.");
-        emit authenticationRequired();
-        return false;
+    if (!manager || manager == m_networkManager) {
+        return;
     }
 
-    QUrl url(buildUrl(path));
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    // Gli stream aperti usano ancora il vecchio manager
+    unsubscribe();
 
-    QJsonDocument doc;
-    if (data.isObject()) {
-        doc = QJsonDocument(data.toObject());
+    if (m_networkManager->parent() == this) {
+        m_networkManager->deleteLater();
     }
-    else if (data.isArray()) {
-        doc = QJsonDocument(data.toArray());
-    }
-
-    QByteArray jsonData = doc.toJson(QJsonDocument::Compact);
-    QNetworkReply* reply = m_networkManager->put(request, jsonData);
-
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
-
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    m_networkManager = manager;
+    preconnect();
+}
 
-    timer.start(10000);
-    loop.exec();
+void FirebaseDatabaseManager::setAuthEndpoints(const QString& identityToolkitUrl, const QString& secureTokenUrl)
+{
+    m_identityToolkitUrl = identityToolkitUrl;
+    m_secureTokenUrl = secureTokenUrl;
 
-    if (!timer.isActive()) {
-        setLastError("Request timeout");
-        reply->deleteLater();
-        return false;
+    while (m_identityToolkitUrl.endsWith('/')) {
+        m_identityToolkitUrl.chop(1);
     }
-    timer.stop();
-
-    if (reply->error() == QNetworkReply::AuthenticationRequiredError) {
-        reply->deleteLater();
-
-        if (retryCount < 1) {  // <-- Solo 1 retry
-            std::cout << u8"\n⚠️ Authentication error, attempting token refresh...";
-            if (refreshAccessToken()) {
-                std::cout << u8"\n🔄 Retrying request after token refresh...";
-                return performPutRequest(path, data, retryCount + 1);
-            }
-        }
-
-        setLastError("Authentication expired. Please login again.");
-        m_isAuthenticated = false;
-        emit authenticationRequired();
-        return false;
+    while (m_secureTokenUrl.endsWith('/')) {
+        m_secureTokenUrl.chop(1);
     }
+}
+
+// ==================== CONNECTIONS ====================
+void FirebaseDatabaseManager::setConnectionWarmUp(bool enabled, int keepWarmIntervalMs)
+{
+    m_warmUpEnabled = enabled;
+    m_keepWarmTimer->setInterval(keepWarmIntervalMs);
 
-    bool success = (reply->error() == QNetworkReply::NoError);
-    if (!success) {
-        setLastError(reply->errorString());
+    if (!enabled || keepWarmIntervalMs <= 0) {
+        m_keepWarmTimer->stop();
     }
-    else {
-        setLastError(QString());
+    else if (m_isConnected) {
+        m_keepWarmTimer->start();
     }
-
-    reply->deleteLater();
-    return success;
 }
 
-// ==================== POST REQUEST ====================
-bool FirebaseDatabaseManager::performPostRequest(const QString& path, const QJsonValue& data, int retryCount)
+void FirebaseDatabaseManager::preconnect()
 {
-    if (!m_isAuthenticated) {
-        setLastError("Not authenticated. Please login first.");
-        emit authenticationRequired();
-        return false;
+    if (!m_warmUpEnabled) {
+        return;
     }
 
-    QUrl url(buildUrl(path));
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-
-    QJsonDocument doc;
-    if (data.isObject()) {
-        doc = QJsonDocument(data.toObject());
+    // Database sempre; host di autenticazione solo se un login o un refresh sono possibili
+    if (m_isConnected) {
+        preconnectTo(m_networkManager, QUrl(m_firebaseUrl));
     }
-    else if (data.isArray()) {
-        doc = QJsonDocument(data.toArray());
+    if (!m_apiKey.isEmpty()) {
+        const QUrl identityToolkit(m_identityToolkitUrl);
+        const QUrl secureToken(m_secureTokenUrl);
+        preconnectTo(m_networkManager, identityToolkit);
+        if (secureToken.host() != identityToolkit.host() || secureToken.port() != identityToolkit.port()) {
+            preconnectTo(m_networkManager, secureToken);
+        }
     }
+}
 
-    QByteArray jsonData = doc.toJson(QJsonDocument::Compact);
+QNetworkRequest FirebaseDatabaseManager::makeRequest(const QUrl& url, const QByteArray& contentType) const
+{
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, contentType);
 
-    QNetworkReply* reply = m_networkManager->post(request, jsonData);
+    // HTTP/2 (negoziato via ALPN, solo su TLS): tutte le richieste verso un host
+    // condividono una connessione, con molti stream in parallelo invece di 6 connessioni HTTP/1.1
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    return request;
+}
 
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
+// ==================== REQUEST POLICY ====================
+void FirebaseDatabaseManager::setRequestOptions(const RequestOptions& options)
+{
+    m_requestOptions = options;
+}
 
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+RequestOptions FirebaseDatabaseManager::requestOptions() const
+{
+    return m_requestOptions;
+}
 
-    timer.start(10000);
-    loop.exec();
+void FirebaseDatabaseManager::cancelPendingRequests()
+{
+    // Le richieste nuove usano un token nuovo, quelle in volo terminano con "Request cancelled"
+    CancellationToken cancelled = m_requestOptions.cancellation;
+    m_requestOptions.cancellation = CancellationToken();
+    cancelled.cancel();
+}
 
-    if (!timer.isActive()) {
-        setLastError("Request timeout");
-        reply->deleteLater();
-        return false;
-    }
-    timer.stop();
+// ==================== METRICS ====================
+FirebaseMetricsSnapshot FirebaseDatabaseManager::metrics() const
+{
+    return m_metrics->snapshot();
+}
 
-    if (reply->error() == QNetworkReply::AuthenticationRequiredError) {
-        reply->deleteLater();
+void FirebaseDatabaseManager::resetMetrics()
+{
+    m_metrics->reset();
+}
 
-        if (retryCount < 1) {
-            std::cout << u8"\n⚠️ Authentication error, attempting token refresh...";
-            if (refreshAccessToken()) {
-                std::cout << u8"\n🔄 Retrying request after token refresh...";
-                return performPostRequest(path, data, retryCount + 1);
-            }
-        }
+void FirebaseDatabaseManager::setMetricsDumpFile(const QString& filePath, MetricsFormat format, int intervalMs)
+{
+    m_metricsDumpPath = filePath;
+    m_metricsDumpFormat = format;
 
-        setLastError("Authentication expired. Please login again.");
-        m_isAuthenticated = false;
-        emit authenticationRequired();
-        return false;
+    if (filePath.isEmpty() || intervalMs <= 0) {
+        m_metricsDumpTimer->stop();
+        return;
     }
+    m_metricsDumpTimer->start(intervalMs);
+}
 
-    bool success = (reply->error() == QNetworkReply::NoError);
-    if (!success) {
-        setLastError(reply->errorString());
-    }
-    else {
-        setLastError(QString());
+void FirebaseDatabaseManager::writeMetricsDump()
+{
+    if (m_metricsDumpPath.isEmpty()) {
+        return;
     }
 
-    reply->deleteLater();
-    return success;
+    // QSaveFile: chi legge il file (es. node_exporter textfile collector) non vede mai un dump a meta'
+    const FirebaseMetricsSnapshot snapshot = m_metrics->snapshot();
+    QSaveFile file(m_metricsDumpPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_ERROR(LogCategory, u8"❌ Cannot write metrics to " << m_metricsDumpPath);
+        return;
+    }
+    file.write(m_metricsDumpFormat == MetricsFormat::Prometheus ? snapshot.toPrometheus() : snapshot.toJson());
+    file.commit();
 }
 
-// ==================== DELETE REQUEST ====================
-bool FirebaseDatabaseManager::performDeleteRequest(const QString& path, int retryCount)
+bool FirebaseDatabaseManager::isConnected() const
 {
-    if (!m_isAuthenticated) {
-        setLastError("Not authenticated. Please log in first.");
-        emit authenticationRequired();
-        return false;
-    }
-
-    QUrl url(buildUrl(path));
-    QNetworkRequest request(url);
+    return m_isConnected;
+}
 
-    QNetworkReply* reply = m_networkManager->deleteResource(request);
+bool FirebaseDatabaseManager::isAuthenticated() const
+{
+    return m_isAuthenticated;
+}
 
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
+QString FirebaseDatabaseManager::currentUserEmail() const
+{
+    return m_userEmail;
+}
 
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+QString FirebaseDatabaseManager::lastError() const
+{
+    return m_lastError;
+}
 
-    timer.start(10000);
-    loop.exec();
+void FirebaseDatabaseManager::setLastError(const QString& error)
+{
+    m_lastError = error;
+    if (!error.isEmpty()) {
+        LOG_ERROR(LogCategory, u8"❌ Firebase Error: " << error);
+    }
+}
 
-    if (!timer.isActive()) {
-        setLastError("Request timeout");
-        reply->deleteLater();
-        return false;
+QString FirebaseDatabaseManager::buildUrl(const QString& path, const FirebaseQuery& params) const
+{
+    QString url = m_firebaseUrl + path;
+    if (!params.isEmpty()) {
+        url += '?' + params.toString();
     }
-    timer.stop();
 
-    if (reply->error() == QNetworkReply::AuthenticationRequiredError) {
-        reply->deleteLater();
+    if (m_isAuthenticated && !m_idToken.isEmpty()) {
+        QUrl qUrl(url);
+        QUrlQuery query(qUrl);
+        query.addQueryItem("auth", m_idToken);
+        qUrl.setQuery(query);
 
-        if (retryCount < 1) {
-            std::cout << u8"\n⚠️ Authentication error, attempting token refresh...";
-            if (refreshAccessToken()) {
-                std::cout << u8"\n🔄 Retrying request after token refresh...";
-                return performPostRequest(path, retryCount + 1);
-            }
-        }
+        // Solo i primi caratteri del token, per sicurezza
+        LOG_TRACE(LogCategory, u8"🔗 Request URL: " << qUrl.toString().left(100) << "... (token length " << m_idToken.length() << ")");
 
-        setLastError("Authentication expired. Please login again.");
-        m_isAuthenticated = false;
-        emit authenticationRequired();
-        return false;
+        return qUrl.toString();
     }
 
-    bool success = (reply->error() == QNetworkReply::NoError);
-    if (!success) {
-        setLastError(reply->errorString());
-    }
-    else {
-        setLastError(QString());
-    }
+    LOG_WARNING(LogCategory, u8"⚠️ Building URL without auth token!");
+    return url;
+}
+
+// ==================== REQUEST PIPELINE ====================
+void FirebaseDatabaseManager::dispatch(QNetworkReply* reply, qint64 requestBytes, int timeoutMs, std::function<void(QNetworkReply*)> onFinished)
+{
+    // Timeout di inattivita' per singola richiesta: allo scadere la reply viene abortita
+    // ed emette finished, quindi non serve nessun event loop locale.
+    // Ogni blocco ricevuto lo fa ripartire, cosi' i download lunghi ma attivi non scadono.
+    QTimer* timer = new QTimer(reply);
+    timer->setSingleShot(true);
+    QObject::connect(timer, &QTimer::timeout, reply, [this, reply]() {
+        m_metrics->recordTimeout();
+        reply->setProperty("timedOut", true);
+        reply->abort();
+    });
+
+    // Byte ricevuti: l'ultimo downloadProgress, indipendente da chi consuma il corpo (anche in streaming)
+    auto bytesIn = std::make_shared<qint64>(0);
+    QObject::connect(reply, &QNetworkReply::downloadProgress, timer, [timer, bytesIn, timeoutMs](qint64 received, qint64) {
+        *bytesIn = received;
+        timer->start(timeoutMs);
+    });
+    timer->start(timeoutMs);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    m_lastRequest.start(); // attivita' recente: il keep-warm non serve
+
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply, timer, onFinished, requestBytes, bytesIn, elapsed]() {
+        timer->stop();
+
+        const QByteArray verb = reply->operation() == QNetworkAccessManager::CustomOperation
+            ? reply->request().attribute(QNetworkRequest::CustomVerbAttribute).toByteArray()
+            : QByteArray(reply->operation() == QNetworkAccessManager::PostOperation ? "POST" : "GET");
+        m_metrics->recordRequest(verb, elapsed.nsecsElapsed() / 1000, reply->error() == QNetworkReply::NoError,
+                                 requestBytes, *bytesIn);
+
+        reply->deleteLater();
+        onFinished(reply);
+    });
+}
 
-    reply->deleteLater();
-    return success;
+// Stato di una richiesta logica attraverso tutti i suoi tentativi
+struct FirebaseDatabaseManager::PendingRequest
+{
+    QByteArray verb;
+    QString path;
+    FirebaseQuery query;
+    QByteArray payload;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    RequestOptions options;
+    ResponseCallback callback;
+    ChunkCallback onChunk;
+    QDeadlineTimer deadline;
+    int attempt = 0;
+    bool authRetried = false;    // al massimo un refresh del token per richiesta
+    bool chunksDelivered = false; // uno stream gia' consegnato in parte non si puo' ripetere
+};
+
+void FirebaseDatabaseManager::sendRequest(const QByteArray& verb, const QString& path, const FirebaseQuery& query,
+                                          const QByteArray& payload, ReplyCallback callback, ChunkCallback onChunk)
+{
+    sendRequest(verb, path, query, payload, m_requestOptions, callback, onChunk);
+}
+
+void FirebaseDatabaseManager::sendRequest(const QByteArray& verb, const QString& path, const FirebaseQuery& query,
+                                          const QByteArray& payload, const RequestOptions& options,
+                                          ReplyCallback callback, ChunkCallback onChunk)
+{
+    auto request = std::make_shared<PendingRequest>();
+    request->verb = verb;
+    request->path = path;
+    request->query = query;
+    request->payload = payload;
+    request->options = options;
+    request->callback = [callback](bool success, const HttpResponse& response) {
+        callback(success, response.body);
+    };
+    request->onChunk = onChunk;
+    request->deadline = options.deadlineMs > 0 ? QDeadlineTimer(options.deadlineMs) : QDeadlineTimer(QDeadlineTimer::Forever);
+
+    executeRequest(request);
+}
+
+void FirebaseDatabaseManager::sendConditionalRequest(const QByteArray& verb, const QString& path, const QByteArray& payload,
+                                                     const QByteArray& ifMatch, ResponseCallback callback)
+{
+    auto request = std::make_shared<PendingRequest>();
+    request->verb = verb;
+    request->path = path;
+    request->payload = payload;
+    request->headers.append({ "X-Firebase-ETag", "true" });
+    if (!ifMatch.isEmpty()) {
+        request->headers.append({ "if-match", ifMatch });
+    }
+    request->options = m_requestOptions;
+    request->callback = callback;
+    request->deadline = m_requestOptions.deadlineMs > 0 ? QDeadlineTimer(m_requestOptions.deadlineMs) : QDeadlineTimer(QDeadlineTimer::Forever);
+
+    executeRequest(request);
 }
 
-// ==================== PATCH REQUEST ====================
-bool FirebaseDatabaseManager::performPatchRequest(const QString& path, const QJsonValue& data, int retryCount)
+void FirebaseDatabaseManager::executeRequest(const std::shared_ptr<PendingRequest>& request)
 {
+    if (request->options.cancellation.isCancelled()) {
+        setLastError("Request cancelled");
+        request->callback(false, HttpResponse());
+        return;
+    }
+
     if (!m_isAuthenticated) {
         setLastError("Not authenticated. Please log in first.");
         emit authenticationRequired();
-        return false;
-	}
-
-    QUrl url(buildUrl(path));
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        request->callback(false, HttpResponse());
+        return;
+    }
+
+    // Token gia' scaduto (es. il PC era in sospensione e il timer non e' scattato in tempo):
+    // meglio attendere il refresh condiviso che inviare una richiesta destinata al 401
+    if (!request->authRetried && isTokenExpired() && !m_refreshToken.isEmpty()) {
+        request->authRetried = true;
+        refreshAccessToken([this, request](bool refreshed) {
+            if (!refreshed) {
+                expireAuthentication();
+                request->callback(false, HttpResponse());
+                return;
+            }
+            executeRequest(request);
+        });
+        return;
+    }
 
-    QJsonDocument doc;
-    if (data.isObject()) {
-        doc = QJsonDocument(data.toObject());
+    if (request->deadline.hasExpired()) {
+        setLastError("Request deadline exceeded");
+        request->callback(false, HttpResponse());
+        return;
     }
 
-    QByteArray jsonData = doc.toJson(QJsonDocument::Compact);
+    ++request->attempt;
 
-    // Qt non ha un metodo patch() diretto, quindi usiamo sendCustomRequest
-    QNetworkReply* reply = m_networkManager->sendCustomRequest(request, "PATCH", jsonData);
+    QNetworkRequest networkRequest = makeRequest(QUrl(buildUrl(request->path, request->query)), "application/json");
+    for (const auto& header : std::as_const(request->headers)) {
+        networkRequest.setRawHeader(header.first, header.second);
+    }
+    QNetworkReply* pending = m_networkManager->sendCustomRequest(networkRequest, request->verb, request->payload);
 
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
+    if (request->onChunk) {
+        // Streaming: i dati vengono consegnati man mano che arrivano, solo per risposte 2xx
+        QObject::connect(pending, &QNetworkReply::readyRead, this, [pending, request]() {
+            const int status = pending->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            if (status >= 200 && status < 300) {
+                request->chunksDelivered = true;
+                request->onChunk(pending->readAll());
+            }
+        });
+    }
 
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    // Scadenza complessiva e annullamento abortiscono il tentativo in corso
+    if (!request->deadline.isForever()) {
+        QTimer::singleShot(int(qMax<qint64>(0, request->deadline.remainingTime())), pending, [pending]() {
+            pending->setProperty("deadlineExceeded", true);
+            pending->abort();
+        });
+    }
+    const int cancelId = request->options.cancellation.onCancel([pending]() {
+        pending->setProperty("cancelled", true);
+        pending->abort();
+    });
 
-    timer.start(10000);
-    loop.exec();
+    dispatch(pending, request->payload.size(), request->options.attemptTimeoutMs, [this, request, cancelId](QNetworkReply* reply) {
+        request->options.cancellation.removeOnCancel(cancelId);
 
-    if (!timer.isActive()) {
-        setLastError("Request timeout");
-        reply->deleteLater();
-        return false;
-    }
-    timer.stop();
+        if (reply->property("cancelled").toBool()) {
+            setLastError("Request cancelled");
+            request->callback(false, HttpResponse());
+            return;
+        }
 
-    if (reply->error() == QNetworkReply::AuthenticationRequiredError) {
-        reply->deleteLater();
+        if (reply->property("deadlineExceeded").toBool()) {
+            setLastError("Request deadline exceeded");
+            request->callback(false, HttpResponse());
+            return;
+        }
 
-        if (retryCount < 1) {
-            std::cout << u8"\n⚠️ Authentication error, attempting token refresh...";
-            if (refreshAccessToken()) {
-                std::cout << u8"\n🔄 Retrying request after token refresh...";
-                return performPostRequest(path, data, retryCount + 1);
+        if (reply->error() == QNetworkReply::AuthenticationRequiredError) {
+            // Solo 1 retry, sempre con lo stesso verbo della richiesta originale
+            if (request->authRetried) {
+                expireAuthentication();
+                request->callback(false, HttpResponse());
+                return;
             }
+
+            LOG_WARNING(LogCategory, u8"⚠️ Authentication error, attempting token refresh...");
+            m_metrics->recordAuthRetry();
+            request->authRetried = true;
+            refreshAccessToken([this, request](bool refreshed) {
+                if (!refreshed) {
+                    expireAuthentication();
+                    request->callback(false, HttpResponse());
+                    return;
+                }
+
+                LOG_DEBUG(LogCategory, u8"🔄 Retrying request after token refresh...");
+                executeRequest(request);
+            });
+            return;
         }
 
-        setLastError("Authentication expired. Please login again.");
-        m_isAuthenticated = false;
-        emit authenticationRequired();
-        return false;
-    }
+        HttpResponse response;
+        response.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        response.etag = reply->rawHeader("ETag");
+
+        if (reply->error() != QNetworkReply::NoError) {
+            const int status = response.status;
+            const bool timedOut = reply->property("timedOut").toBool();
+
+            if (RequestOptions::isRetryable(reply->error(), status) && RequestOptions::isIdempotent(request->verb)
+                && !request->chunksDelivered && request->attempt < request->options.maxAttempts) {
+                // Retry-After (429/503) vale piu' del backoff calcolato
+                int delayMs = request->options.backoffDelayMs(request->attempt);
+                const int retryAfterSecs = reply->rawHeader("Retry-After").toInt();
+                if (retryAfterSecs > 0) {
+                    delayMs = qMax(delayMs, retryAfterSecs * 1000);
+                }
+
+                if (request->deadline.isForever() || delayMs < request->deadline.remainingTime()) {
+                    LOG_DEBUG(LogCategory, u8"🔁 " << request->verb << ' ' << request->path << " failed ("
+                              << (timedOut ? QString("timeout") : reply->errorString()) << "), attempt "
+                              << request->attempt + 1 << " in " << delayMs << " ms");
+                    m_metrics->recordRetry();
+
+                    // Annullare durante l'attesa fa ripartire subito executeRequest, che termina la richiesta
+                    QTimer* retryTimer = new QTimer(this);
+                    retryTimer->setSingleShot(true);
+                    const int retryCancelId = request->options.cancellation.onCancel([retryTimer]() {
+                        retryTimer->start(0);
+                    });
+                    QObject::connect(retryTimer, &QTimer::timeout, this, [this, request, retryTimer, retryCancelId]() {
+                        request->options.cancellation.removeOnCancel(retryCancelId);
+                        retryTimer->deleteLater();
+                        executeRequest(request);
+                    });
+                    retryTimer->start(delayMs);
+                    return;
+                }
+            }
+
+            // Il corpo di un errore HTTP serve a chi lo gestisce (es. 412: valore corrente del nodo)
+            setLastError(timedOut ? QString("Request timeout") : reply->errorString());
+            response.body = reply->readAll();
+            request->callback(false, response);
+            return;
+        }
 
-    bool success = (reply->error() == QNetworkReply::NoError);
-    if (!success) {
-        setLastError(reply->errorString());
-    }
-    else {
         setLastError(QString());
-    }
 
-    reply->deleteLater();
-    return success;
+        if (request->onChunk) {
+            request->onChunk(reply->readAll());
+            request->callback(true, response);
+            return;
+        }
+
+        response.body = reply->readAll();
+        request->callback(true, response);
+    });
 }
 
-// ==================== CONVERSIONE OGGETTI ====================
-QJsonObject FirebaseDatabaseManager::objectToJson(const HomeObject& object) const
+void FirebaseDatabaseManager::getJson(const QString& path, JsonCallback callback)
 {
-    QJsonObject json;
-    json["name"] = object.name();
-    json["color"] = object.color();
-    json["material"] = object.material();
-    json["type"] = object.type();
-    json["notes"] = object.notes();
-    json["locationId"] = object.locationId();
-    json["sublocationId"] = object.sublocationId();
+    getJson(path, FirebaseQuery(), callback);
+}
 
-    // Picture come base64 se presente
-    if (!object.picture().isEmpty()) {
-        json["picture"] = QString(object.picture().toBase64());
+void FirebaseDatabaseManager::getJson(const QString& path, const FirebaseQuery& query, JsonCallback callback)
+{
+    // Stessa lettura gia' in volo: si attende quella, una sola richiesta e un solo parse
+    const QString key = path + '?' + query.toString();
+    if (!m_jsonReads.join(key, callback)) {
+        m_metrics->recordCoalescedRead();
+        return;
     }
 
-    return json;
+    sendRequest("GET", path, query, QByteArray(), [this, key](bool success, const QByteArray& response) {
+        if (!success) {
+            m_jsonReads.complete(key, false, QJsonDocument());
+            return;
+        }
+
+        // Firebase risponde "null" se il nodo non esiste
+        if (response.trimmed() == "null") {
+            m_jsonReads.complete(key, true, QJsonDocument());
+            return;
+        }
+
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(response, &parseError);
+        m_metrics->recordParse(parseTimer.nsecsElapsed() / 1000);
+
+        if (parseError.error != QJsonParseError::NoError) {
+            setLastError("JSON parse error: " + parseError.errorString());
+            m_jsonReads.complete(key, false, QJsonDocument());
+            return;
+        }
+
+        m_jsonReads.complete(key, true, doc);
+    });
 }
 
-HomeObject FirebaseDatabaseManager::jsonToObject(const QString& key, const QJsonObject& json) const
+void FirebaseDatabaseManager::writeJson(const QByteArray& verb, const QString& path, const QJsonValue& data, ResultCallback callback)
 {
-    HomeObject obj;
-    obj.setName(json["name"].toString());
-    obj.setColor(json["color"].toString());
-    obj.setMaterial(json["material"].toString());
-    obj.setType(json["type"].toString());
-    obj.setNotes(json["notes"].toString());
-    obj.setLocationId(json["locationId"].toInt());
-    obj.setSublocationId(json["sublocationId"].toInt());
+    sendRequest(verb, path, FirebaseQuery(), toPayload(data), [callback](bool success, const QByteArray&) {
+        callback(success);
+    });
+}
 
-    // Picture da base64 se presente
-    if (json.contains("picture")) {
-        QByteArray pictureData = QByteArray::fromBase64(json["picture"].toString().toUtf8());
-        obj.setPicture(pictureData);
-    }
+void FirebaseDatabaseManager::expireAuthentication()
+{
+    setLastError("Authentication expired. Please login again.");
+    m_isAuthenticated = false;
+    m_tokenRefreshTimer->stop();
+    emit authenticationRequired();
+}
+
+// ==================== CONVERSIONE OGGETTI ====================
+// Il formato degli oggetti e' definito solo in HomeObjectCodec
 
-    return obj;
+QString FirebaseDatabaseManager::pictureRefFor(const QByteArray& picture)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(picture, QCryptographicHash::Sha256).toHex());
 }
 
 // ==================== OBJECT OPERATIONS ====================
 
-bool FirebaseDatabaseManager::createObject(const HomeObject& object)
+void FirebaseDatabaseManager::putObject(const HomeObject& object, ResultCallback callback)
 {
-    if (!isAuthenticated()) {
-		setLastError("Not authenticated");
-        emit authenticationRequired();
-		return false;   
-    }
-
     if (!object.isValid()) {
         setLastError("Invalid object - name is required");
-        return false;
+        callback(false);
+        return;
     }
 
-    QJsonObject jsonObj = objectToJson(object);
-    QString path = QString("/objects/%1.json").arg(object.name());
+    auto write = [this, callback](const HomeObject& stored) {
+        QString path = QString("/objects/%1.json").arg(stored.name());
 
-    bool success = performPutRequest(path, jsonObj);
+        sendRequest("PUT", path, FirebaseQuery(), HomeObjectCodec::encode(stored), [this, stored, callback](bool success, const QByteArray&) {
+            if (success) {
+                m_objectCache.insert(stored);
+                LOG_DEBUG(LogCategory, u8"✅ Object created: " << stored.name());
+            }
+            callback(success);
+        });
+    };
 
-    if (success) {
-        std::cout << u8"✅ Object created: ";
-        qDebug() << object.name();
+    if (object.picture().isEmpty()) {
+        write(object);
+        return;
     }
 
-    return success;
+    // Foto nuova o modificata: prima nel picture store, poi l'oggetto con il solo riferimento
+    storePicture(object.picture(), [object, write, callback](bool success, const QString& pictureRef) {
+        if (!success) {
+            callback(false);
+            return;
+        }
+
+        HomeObject stored = object;
+        stored.setPictureRef(pictureRef);
+        write(stored);
+    });
 }
 
-QList<HomeObject> FirebaseDatabaseManager::getAllObjects()
+void FirebaseDatabaseManager::removeObject(const QString& objectName, ResultCallback callback)
 {
-    QList<HomeObject> objects;
+    QString path = QString("/objects/%1.json").arg(objectName);
 
-    if (!isAuthenticated()) {
-        setLastError("Not authenticated");
-        emit authenticationRequired();
-        return objects;
-    }
+    sendRequest("DELETE", path, FirebaseQuery(), QByteArray(), [this, objectName, callback](bool success, const QByteArray&) {
+        if (success) {
+            m_objectCache.remove(objectName);
+            LOG_DEBUG(LogCategory, u8"🗑️ Object deleted: " << objectName);
+        }
+        callback(success);
+    });
+}
 
-    QJsonDocument doc = performGetRequest("/objects.json");
+void FirebaseDatabaseManager::storePicture(const QByteArray& picture, std::function<void(bool success, const QString& pictureRef)> callback)
+{
+    const QString pictureRef = pictureRefFor(picture);
+    m_pictureCache.insert(pictureRef, new QByteArray(picture), picture.size());
 
-    if (doc.isNull() || !doc.isObject()) {
-        return objects; // Empty list se non ci sono oggetti
+    // Stesso contenuto = stesso hash: una foto gia' presente non viene ricaricata
+    if (m_storedPictures.contains(pictureRef)) {
+        callback(true, pictureRef);
+        return;
     }
 
-    QJsonObject allObjects = doc.object();
+    QString path = QString("/pictures/%1.json").arg(pictureRef);
+    writeJson("PUT", path, QString::fromLatin1(picture.toBase64()), [this, pictureRef, callback](bool success) {
+        if (success) {
+            m_storedPictures.insert(pictureRef);
+        }
+        callback(success, pictureRef);
+    });
+}
 
-    for (auto it = allObjects.begin(); it != allObjects.end(); ++it) {
-        QString key = it.key();
-        QJsonObject objJson = it.value().toObject();
+void FirebaseDatabaseManager::syncObjects(std::function<void()> done)
+{
+    const bool hit = !m_objectCache.isStale();
+    m_metrics->recordCacheLookup(hit);
+    if (hit) {
+        setLastError(QString()); // nessuna richiesta: un errore precedente non riguarda questa lettura
+        done();
+        return;
+    }
 
-        HomeObject obj = jsonToObject(key, objJson);
-        objects.append(obj);
+    // Se una sincronizzazione e' gia' in corso, accoda la lettura
+    m_syncWaiters.append(done);
+    if (m_syncWaiters.size() > 1) {
+        return;
     }
 
-    std::cout << u8"📦 Retrieved " << objects.size() << " objects from Firebase\n";
-    return objects;
-}
+    auto notifyWaiters = [this](bool) {
+        const QList<std::function<void()>> waiters = std::move(m_syncWaiters);
+        m_syncWaiters.clear();
+        for (const auto& waiter : waiters) {
+            waiter();
+        }
+    };
 
-QList<HomeObject> FirebaseDatabaseManager::getObjects(int locationId, int sublocationId)
-{
-    QList<HomeObject> allObjects = getAllObjects();
-    QList<HomeObject> filteredObjects;
+    if (!m_objectCache.isComplete()) {
+        reloadAllObjects(notifyWaiters);
+        return;
+    }
 
-    for (const HomeObject& obj : allObjects) {
-        if (obj.locationId() == locationId && obj.sublocationId() == sublocationId) {
-            filteredObjects.append(obj);
+    deltaSyncObjects([this, notifyWaiters](bool success, bool indexMissing) {
+        // Un errore di rete o del server non rende la cache incompleta: resta quella (scaduta),
+        // il chiamante vede l'errore e la prossima lettura riprova la delta
+        if (success || !indexMissing) {
+            notifyWaiters(success);
+            return;
         }
-    }
 
-    return filteredObjects;
+        // Senza indice su updatedAt la delta non e' possibile: ricarica tutto, la cache
+        // completa viene sostituita solo se il download riesce
+        reloadAllObjects(notifyWaiters);
+    });
 }
 
-bool FirebaseDatabaseManager::updateObject(const QString& oldName, const HomeObject& newObject)
+void FirebaseDatabaseManager::reconcileObjects()
 {
-    if (!isAuthenticated()) {
-        setLastError("Not authenticated");
-        emit authenticationRequired();
-        return false;
+    if (!isAuthenticated() || !m_objectCache.isComplete() || !m_objectCache.isStale()) {
+        return;
     }
 
-    // Se il nome è cambiato, devo eliminare il vecchio e creare il nuovo
-    if (oldName != newObject.name()) {
-        if (!deleteObject(oldName)) {
-            return false;
+    // Solo i cambiamenti dopo il watermark dello snapshot: la vista resta utilizzabile nel frattempo
+    const quint64 revision = m_objectCache.revision();
+    syncObjects([this, revision]() {
+        if (m_objectCache.revision() != revision) {
+            emit objectsReset();
         }
-    }
-
-    return createObject(newObject);
+    });
 }
 
-bool FirebaseDatabaseManager::deleteObject(const QString& objectName)
+void FirebaseDatabaseManager::reloadAllObjects(ResultCallback callback, std::function<void(const HomeObject&)> onObject)
 {
-    if (!isAuthenticated()) {
-        setLastError("Not authenticated");
-        emit authenticationRequired();
-        return false;
-    }
+    struct ReloadState
+    {
+        QList<HomeObject> objects;
+        qint64 watermark = 0;
+        qint64 parseNs = 0; // registrato una sola volta a fine download: niente lock delle metriche per oggetto
+    };
+    auto state = std::make_shared<ReloadState>();
+
+    // Ogni oggetto viene convertito appena il suo sottoalbero e' arrivato:
+    // ne' la risposta intera ne' il DOM completo restano in memoria
+    auto parser = std::make_shared<JsonStreamParser>([state, onObject](const QString&, const QByteArray& value) {
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        HomeObject obj;
+        qint64 updatedAt = 0;
+        if (!HomeObjectCodec::decode(value, obj, &updatedAt)) {
+            // Il codec accetta solo JSON valido: per tutto il resto si mantiene il comportamento del DOM
+            obj = HomeObjectCodec::fromJson(QJsonDocument::fromJson(value).object(), &updatedAt);
+        }
+        state->parseNs += parseTimer.nsecsElapsed();
 
-    QString path = QString("/objects/%1.json").arg(objectName);
-    bool success = performDeleteRequest(path);
+        state->watermark = qMax(state->watermark, updatedAt);
+        state->objects.append(obj);
 
-    if (success) {
-        std::cout << u8"🗑️ Object deleted: ";
-        qDebug() << objectName;
-    }
+        if (onObject) {
+            onObject(obj);
+        }
+    });
+
+    auto onFinished = [this, state, parser, callback](bool success, const QByteArray&) {
+        if (!success) {
+            callback(false);
+            return;
+        }
 
-    return success;
+        const bool parsed = parser->finish();
+        m_metrics->recordParse(state->parseNs / 1000);
+
+        if (!parsed) {
+            setLastError("JSON parse error: " + parser->errorString());
+            callback(false);
+            return;
+        }
+
+        m_objectCache.replaceAll(state->objects, state->watermark);
+
+        LOG_INFO(LogCategory, u8"📦 Retrieved " << state->objects.size() << " objects from Firebase");
+        callback(true);
+    };
+
+    // Download completo: nessuna scadenza complessiva, conta solo l'inattivita' del singolo tentativo
+    RequestOptions options = m_requestOptions;
+    options.deadlineMs = 0;
+    sendRequest("GET", "/objects.json", FirebaseQuery(), QByteArray(), options, onFinished, [parser](const QByteArray& chunk) {
+        parser->feed(chunk);
+    });
 }
 
-QList<HomeObject> FirebaseDatabaseManager::searchObjects(const QVariantMap& filters)
+void FirebaseDatabaseManager::deltaSyncObjects(DeltaCallback callback)
 {
-    QList<HomeObject> allObjects = getAllObjects();
-    QList<HomeObject> results;
+    // Due letture leggere in parallelo: le sole chiavi (per scoprire le eliminazioni)
+    // e gli oggetti modificati dopo l'ultimo updatedAt ricevuto
+    struct DeltaState
+    {
+        int pending = 2;
+        bool success = true;
+        bool indexMissing = false;
+        QSet<QString> keys;
+        QJsonObject changed;
+    };
+    auto state = std::make_shared<DeltaState>();
+
+    auto complete = [this, state, callback]() {
+        if (--state->pending > 0) {
+            return;
+        }
+        if (!state->success) {
+            callback(false, state->indexMissing);
+            return;
+        }
 
-    for (const HomeObject& obj : allObjects) {
-        bool matches = true;
+        m_objectCache.retainOnly(state->keys);
 
-        // Filtra per nome (partial match)
-        if (filters.contains("name")) {
-            QString searchName = filters["name"].toString();
-            if (!searchName.isEmpty() && !obj.name().contains(searchName, Qt::CaseInsensitive)) {
-                matches = false;
-            }
+        qint64 watermark = m_objectCache.syncWatermark();
+        for (auto it = state->changed.begin(); it != state->changed.end(); ++it) {
+            qint64 updatedAt = 0;
+            m_objectCache.insert(HomeObjectCodec::fromJson(it.value().toObject(), &updatedAt));
+            watermark = qMax(watermark, updatedAt);
         }
-
-        // Filtra per colore
-        if (filters.contains("colors")) {
-            QStringList colors = filters["colors"].toStringList();
-            if (!colors.isEmpty() && !colors.contains(obj.color())) {
-                matches = false;
-            }
+        m_objectCache.markSynced(watermark);
+
+        LOG_DEBUG(LogCategory, u8"🔄 Delta sync: " << state->changed.size() << " changed, "
+                  << m_objectCache.size() << " cached objects");
+        callback(true, false);
+    };
+
+    getJson("/objects.json", FirebaseQuery::shallowKeys(), [state, complete](bool success, const QJsonDocument& doc) {
+        state->success = state->success && success;
+        const QJsonObject keys = doc.object();
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+            state->keys.insert(it.key());
         }
-
-        // Filtra per materiale
-        if (filters.contains("materials")) {
-            QStringList materials = filters["materials"].toStringList();
-            if (!materials.isEmpty() && !materials.contains(obj.material())) {
-                matches = false;
+        complete();
+    });
+
+    FirebaseQuery changedQuery = FirebaseQuery::orderBy("updatedAt");
+    changedQuery.startAt(m_objectCache.syncWatermark());
+
+    // Senza getJson: in caso di errore serve il corpo, per distinguere l'indice mancante (400)
+    sendRequest("GET", "/objects.json", changedQuery, QByteArray(), [this, state, complete](bool success, const QByteArray& response) {
+        if (success && response.trimmed() != "null") {
+            QJsonParseError parseError;
+            state->changed = QJsonDocument::fromJson(response, &parseError).object();
+            if (parseError.error != QJsonParseError::NoError) {
+                setLastError("JSON parse error: " + parseError.errorString());
+                success = false;
             }
         }
-
-        // Filtra per tipo
-        if (filters.contains("types")) {
-            QStringList types = filters["types"].toStringList();
-            if (!types.isEmpty() && !types.contains(obj.type())) {
-                matches = false;
-            }
+        else if (!success) {
+            state->indexMissing = response.contains("Index not defined");
         }
+        state->success = state->success && success;
+        complete();
+    });
+}
+
+void FirebaseDatabaseManager::queryObjects(const FirebaseQuery& query, ObjectsCallback callback)
+{
+    // Solo il sottoalbero selezionato dal server attraversa la rete
+    getJson("/objects.json", query, [this, callback](bool success, const QJsonDocument& doc) {
+        QList<HomeObject> objects;
+
+        const QJsonObject matches = doc.object();
+        objects.reserve(matches.size());
 
-        if (matches) {
-            results.append(obj);
+        for (auto it = matches.begin(); it != matches.end(); ++it) {
+            HomeObject obj = HomeObjectCodec::fromJson(it.value().toObject());
+            m_objectCache.insert(obj);
+            objects.append(obj);
         }
-    }
 
-    return results;
+        callback(success, objects);
+    });
 }
 
-// ==================== ATTRIBUTES OPERATIONS ====================
+bool FirebaseDatabaseManager::createObject(const HomeObject& object)
+{
+    return waitForResult(createObjectAsync(object));
+}
 
-QStringList FirebaseDatabaseManager::getColors()
+QFuture<bool> FirebaseDatabaseManager::createObjectAsync(const HomeObject& object)
 {
-    QStringList colors;
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "createObject", promise->future());
 
     if (!isAuthenticated()) {
         setLastError("Not authenticated");
         emit authenticationRequired();
-        return colors;
+        return fulfil(promise, false);
     }
 
-    QJsonDocument doc = performGetRequest("/colors.json");
+    putObject(object, [promise](bool success) {
+        fulfil(promise, success);
+    });
 
-    if (doc.isArray()) {
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            colors.append(val.toString());
-        }
-    }
+    return promise->future();
+}
 
-    std::cout << u8"🎨 Retrieved " << colors.size() << " colors\n";
-    return colors;
+QList<HomeObject> FirebaseDatabaseManager::getAllObjects()
+{
+    return waitForResult(getAllObjectsAsync());
 }
 
-QStringList FirebaseDatabaseManager::getMaterials()
+QFuture<QList<HomeObject>> FirebaseDatabaseManager::getAllObjectsAsync()
 {
-    QStringList materials;
+    auto promise = makePromise<QList<HomeObject>>();
+    trackOperation(m_metrics, "getAllObjects", promise->future());
 
     if (!isAuthenticated()) {
         setLastError("Not authenticated");
         emit authenticationRequired();
-        return materials;
+        return fulfil(promise, QList<HomeObject>());
     }
 
-    QJsonDocument doc = performGetRequest("/materials.json");
-
-    if (doc.isArray()) {
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            materials.append(val.toString());
+    syncObjects([this, promise]() {
+        // Una cache incompleta (download fallito, solo alcune stanze) non e' l'inventario
+        if (!m_objectCache.isComplete()) {
+            if (lastError().isEmpty()) {
+                setLastError("Objects not loaded");
+            }
+            fulfil(promise, QList<HomeObject>());
+            return;
         }
-    }
+        fulfil(promise, m_objectCache.objects());
+    });
 
-    std::cout << u8"🔨 Retrieved " << materials.size() << " materials\n";
-    return materials;
+    return promise->future();
 }
 
-QStringList FirebaseDatabaseManager::getTypes()
+QFuture<HomeObject> FirebaseDatabaseManager::streamAllObjectsAsync()
 {
-    QStringList types;
+    auto promise = std::make_shared<QPromise<HomeObject>>();
+    promise->start();
+    trackOperation(m_metrics, "streamAllObjects", promise->future());
 
     if (!isAuthenticated()) {
         setLastError("Not authenticated");
         emit authenticationRequired();
-        return types;
+        promise->finish();
+        return promise->future();
     }
 
-    QJsonDocument doc = performGetRequest("/types.json");
-
-    if (doc.isArray()) {
-        QJsonArray arr = doc.array();
-        for (const QJsonValue& val : arr) {
-            types.append(val.toString());
+    if (!m_objectCache.isStale()) {
+        for (const HomeObject& obj : m_objectCache.objects()) {
+            promise->addResult(obj);
         }
+        promise->finish();
+        return promise->future();
     }
 
-    std::cout << u8"📋 Retrieved " << types.size() << " types\n";
-    return types;
+    // I primi oggetti sono disponibili prima che il download sia terminato
+    reloadAllObjects([promise](bool) {
+        promise->finish();
+    }, [promise](const HomeObject& obj) {
+        promise->addResult(obj);
+    });
+
+    return promise->future();
 }
 
-bool FirebaseDatabaseManager::addColor(const QString& color)
+QList<HomeObject> FirebaseDatabaseManager::getObjects(int locationId, int sublocationId)
+{
+    return waitForResult(getObjectsAsync(locationId, sublocationId));
+}
+
+QFuture<QList<HomeObject>> FirebaseDatabaseManager::getObjectsAsync(int locationId, int sublocationId)
 {
+    auto promise = makePromise<QList<HomeObject>>();
+    trackOperation(m_metrics, "getObjects", promise->future());
+
     if (!isAuthenticated()) {
         setLastError("Not authenticated");
         emit authenticationRequired();
-        return false;
+        return fulfil(promise, QList<HomeObject>());
     }
 
-    QStringList colors = getColors();
-
-    if (colors.contains(color)) {
-        setLastError("Color already exists");
-        return false;
+    if (!m_objectCache.isStale()) {
+        return fulfil(promise, m_objectCache.objects(locationId, sublocationId));
     }
 
-    colors.append(color);
+    // Cache non aggiornata: il server filtra per locationId, la sublocation si filtra qui
+    queryObjects(FirebaseQuery::orderBy("locationId").equalTo(locationId),
+                 [this, promise, locationId, sublocationId](bool success, const QList<HomeObject>& roomObjects) {
+        // Meglio gli oggetti gia' in cache, anche se vecchi, che una stanza vuota
+        if (!success) {
+            fulfil(promise, m_objectCache.objects(locationId, sublocationId));
+            return;
+        }
+
+        QList<HomeObject> filteredObjects;
 
-    QJsonArray arr;
-    for (const QString& c : colors) {
-        arr.append(c);
-    }
+        for (const HomeObject& obj : roomObjects) {
+            if (obj.sublocationId() == sublocationId) {
+                filteredObjects.append(obj);
+            }
+        }
 
-    return performPutRequest("/colors.json", arr);
+        fulfil(promise, filteredObjects);
+    });
+
+    return promise->future();
 }
 
-bool FirebaseDatabaseManager::addMaterial(const QString& material)
+bool FirebaseDatabaseManager::updateObject(const QString& oldName, const HomeObject& newObject)
+{
+    return waitForResult(updateObjectAsync(oldName, newObject));
+}
+
+QFuture<bool> FirebaseDatabaseManager::updateObjectAsync(const QString& oldName, const HomeObject& newObject)
 {
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "updateObject", promise->future());
+
     if (!isAuthenticated()) {
         setLastError("Not authenticated");
         emit authenticationRequired();
-        return false;
+        return fulfil(promise, false);
     }
 
-    QStringList materials = getMaterials();
-
-    if (materials.contains(material)) {
-        setLastError("Material already exists");
-        return false;
+    if (oldName == newObject.name()) {
+        putObject(newObject, [promise](bool success) {
+            fulfil(promise, success);
+        });
+        return promise->future();
     }
 
-    materials.append(material);
+    // Se il nome è cambiato, devo eliminare il vecchio e creare il nuovo
+    removeObject(oldName, [this, promise, newObject](bool deleted) {
+        if (!deleted) {
+            fulfil(promise, false);
+            return;
+        }
 
-    QJsonArray arr;
-    for (const QString& m : materials) {
-        arr.append(m);
-    }
+        putObject(newObject, [promise](bool success) {
+            fulfil(promise, success);
+        });
+    });
 
-    return performPutRequest("/materials.json", arr);
+    return promise->future();
 }
 
-bool FirebaseDatabaseManager::addType(const QString& type)
+bool FirebaseDatabaseManager::deleteObject(const QString& objectName)
+{
+    return waitForResult(deleteObjectAsync(objectName));
+}
+
+QFuture<bool> FirebaseDatabaseManager::deleteObjectAsync(const QString& objectName)
 {
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "deleteObject", promise->future());
+
     if (!isAuthenticated()) {
         setLastError("Not authenticated");
         emit authenticationRequired();
-        return false;
-    }
-
-    QStringList types = getTypes();
-
-    if (types.contains(type)) {
-        setLastError("Type already exists");
-        return false;
+        return fulfil(promise, false);
     }
 
-    types.append(type);
+    removeObject(objectName, [promise](bool success) {
+        fulfil(promise, success);
+    });
 
-    QJsonArray arr;
-    for (const QString& t : types) {
-        arr.append(t);
-    }
+    return promise->future();
+}
 
-    return performPutRequest("/types.json", arr);
+bool FirebaseDatabaseManager::applyBatch(const QList<ObjectMutation>& mutations)
+{
+    return waitForResult(applyBatchAsync(mutations));
 }
 
-bool FirebaseDatabaseManager::removeColor(const QString& color)
+QFuture<bool> FirebaseDatabaseManager::applyBatchAsync(const QList<ObjectMutation>& mutations)
 {
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "applyBatch", promise->future());
+
     if (!isAuthenticated()) {
         setLastError("Not authenticated");
         emit authenticationRequired();
-        return false;
+        return fulfil(promise, false);
     }
 
-    QStringList colors = getColors();
-    colors.removeAll(color);
-
-    QJsonArray arr;
-    for (const QString& c : colors) {
-        arr.append(c);
+    if (mutations.isEmpty()) {
+        return fulfil(promise, true);
     }
 
-    return performPutRequest("/colors.json", arr);
-}
+    // Ogni percorso compare una sola volta: a parita' di percorso vince l'ultima mutazione,
+    // come se le operazioni venissero eseguite in sequenza
+    QStringList order;
+    QHash<QString, QByteArray> values;  // percorso -> valore JSON gia' serializzato
+    QHash<QString, HomeObject> written; // percorso -> oggetto scritto (assente se il valore finale e' null)
 
-bool FirebaseDatabaseManager::removeMaterial(const QString& material)
-{
-    if (!isAuthenticated()) {
-        setLastError("Not authenticated");
-        emit authenticationRequired();
-        return false;
-    }
+    // I percorsi di una stessa mutazione (vecchio nome, foto, nuovo nome) devono finire nella
+    // stessa PATCH, che e' atomica: due mutazioni che condividono un percorso formano un solo gruppo
+    QHash<QString, QString> groupOf; // percorso -> percorso rappresentativo del gruppo
+    QStringList touched;             // percorsi scritti dalla mutazione corrente
 
-    QStringList materials = getMaterials();
-    materials.removeAll(material);
+    auto groupRoot = [&groupOf](QString key) {
+        while (groupOf.contains(key)) {
+            key = groupOf.value(key);
+        }
+        return key;
+    };
 
-    QJsonArray arr;
-    for (const QString& m : materials) {
-        arr.append(m);
-    }
+    auto set = [&order, &values, &touched](const QString& key, const QByteArray& value) {
+        if (!values.contains(key)) {
+            order.append(key);
+        }
+        values.insert(key, value);
+        touched.append(key);
+    };
 
-    return performPutRequest("/materials.json", arr);
-}
+    for (const ObjectMutation& mutation : mutations) {
+        touched.clear();
 
-bool FirebaseDatabaseManager::removeType(const QString& type)
-{
-    if (!isAuthenticated()) {
-        setLastError("Not authenticated");
-        emit authenticationRequired();
-        return false;
-    }
+        if (mutation.type == ObjectMutation::Type::Delete) {
+            set("objects/" + mutation.oldName, "null");
+            written.remove("objects/" + mutation.oldName);
+            continue;
+        }
+
+        if (!mutation.object.isValid()) {
+            setLastError("Invalid object in batch - name is required");
+            return fulfil(promise, false);
+        }
+
+        if (mutation.type == ObjectMutation::Type::Update && !mutation.oldName.isEmpty()
+            && mutation.oldName != mutation.object.name()) {
+            set("objects/" + mutation.oldName, "null");
+            written.remove("objects/" + mutation.oldName);
+        }
+
+        HomeObject stored = mutation.object;
+
+        // Le foto nuove viaggiano nella stessa PATCH, nel picture store
+        if (!stored.picture().isEmpty()) {
+            const QString pictureRef = pictureRefFor(stored.picture());
+            stored.setPictureRef(pictureRef);
+            m_pictureCache.insert(pictureRef, new QByteArray(stored.picture()), stored.picture().size());
+
+            if (!m_storedPictures.contains(pictureRef)) {
+                set("pictures/" + pictureRef, '"' + stored.picture().toBase64() + '"'); // base64: nessun escape
+            }
+        }
 
-    QStringList types = getTypes();
-    types.removeAll(type);
+        set("objects/" + stored.name(), HomeObjectCodec::encode(stored));
+        written.insert("objects/" + stored.name(), stored);
 
-    QJsonArray arr;
-    for (const QString& t : types) {
-        arr.append(t);
+        const QString root = groupRoot(touched.first());
+        for (const QString& key : std::as_const(touched)) {
+            const QString keyRoot = groupRoot(key);
+            if (keyRoot != root) {
+                groupOf.insert(keyRoot, root);
+            }
+        }
     }
 
-    return performPutRequest("/types.json", arr);
-}
\ No newline at end of file
+    QStringList groupOrder;
+    QHash<QString, QStringList> groups;
+    for (const QString& key : std::as_const(order)) {
+        const QString root = groupRoot(key);
+        if (!groups.contains(root)) {
+            groupOrder.append(root);
+        }
+        groups[root].append(key);
+    }
+
+    // Una PATCH multi-percorso sulla radice per ogni blocco di al massimo m_batchChunkBytes;
+    // un gruppo non viene mai diviso, anche se da solo supera il limite.
+    // Il corpo si compone dai valori gia' serializzati, senza ricostruire un DOM
+    struct Chunk
+    {
+        QByteArray payload;
+        QStringList keys;
+    };
+    QList<Chunk> chunks;
+    Chunk current;
+
+    for (const QString& root : std::as_const(groupOrder)) {
+        const QStringList& keys = groups[root];
+        qint64 groupBytes = 0;
+        for (const QString& key : keys) {
+            groupBytes += key.size() + values[key].size() + 4;
+        }
+
+        if (!current.keys.isEmpty() && current.payload.size() + groupBytes > m_batchChunkBytes) {
+            current.payload += '}';
+            chunks.append(current);
+            current = Chunk();
+        }
+
+        for (const QString& key : keys) {
+            current.payload += current.keys.isEmpty() ? '{' : ',';
+            HomeObjectCodec::encodeString(key, current.payload);
+            current.payload += ':';
+            current.payload += values[key];
+            current.keys.append(key);
+        }
+    }
+    current.payload += '}';
+    chunks.append(current);
+
+    struct BatchState
+    {
+        int pending = 0;
+        bool success = true;
+    };
+    auto state = std::make_shared<BatchState>();
+    state->pending = chunks.size();
+
+    const int mutationCount = mutations.size();
+
+    for (const Chunk& chunk : std::as_const(chunks)) {
+        const QStringList keys = chunk.keys;
+        sendRequest("PATCH", "/.json", FirebaseQuery(), chunk.payload,
+                    [this, state, promise, keys, written, mutationCount, chunkCount = chunks.size()](bool success, const QByteArray&) {
+            if (success) {
+                for (const QString& key : keys) {
+                    if (key.startsWith("pictures/")) {
+                        m_storedPictures.insert(key.mid(9));
+                    }
+                    else if (written.contains(key)) {
+                        m_objectCache.insert(written.value(key));
+                    }
+                    else {
+                        m_objectCache.remove(key.mid(8));
+                    }
+                }
+            }
+
+            state->success = state->success && success;
+
+            if (--state->pending == 0) {
+                if (state->success) {
+                    LOG_DEBUG(LogCategory, u8"📦 Batch applied: " << mutationCount << " mutations in "
+                              << chunkCount << " request(s)");
+                }
+                fulfil(promise, state->success);
+            }
+        });
+    }
+
+    return promise->future();
+}
+
+QList<HomeObject> FirebaseDatabaseManager::searchObjects(const QVariantMap& filters)
+{
+    return waitForResult(searchObjectsAsync(filters));
+}
+
+QFuture<QList<HomeObject>> FirebaseDatabaseManager::searchObjectsAsync(const QVariantMap& filters)
+{
+    auto promise = makePromise<QList<HomeObject>>();
+    trackOperation(m_metrics, "searchObjects", promise->future());
+
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return fulfil(promise, QList<HomeObject>());
+    }
+
+    // I filtri vengono compilati una volta sola, non per ogni oggetto, ma solo quando gli oggetti
+    // sono arrivati: prima i loro attributi potrebbero non essere ancora nei vocabolari
+    auto filterLocal = [promise, filters](const QList<HomeObject>& candidates) {
+        const SearchFilter filter = SearchFilter::compile(filters);
+        QList<HomeObject> results;
+
+        for (const HomeObject& obj : candidates) {
+            if (filter.matches(obj)) {
+                results.append(obj);
+            }
+        }
+
+        fulfil(promise, results);
+    };
+
+    // Scegli il filtro su attributo piu' selettivo da delegare al server
+    static const QList<QPair<QString, QString>> serverFilters = {
+        { "colors", "color" }, { "materials", "material" }, { "types", "type" }
+    };
+
+    QString orderByChild;
+    QStringList values;
+    for (const auto& filter : serverFilters) {
+        const QStringList filterValues = filters.value(filter.first).toStringList();
+        if (!filterValues.isEmpty() && (values.isEmpty() || filterValues.size() < values.size())) {
+            orderByChild = filter.second;
+            values = filterValues;
+        }
+    }
+
+    // Cache aggiornata o nessun filtro delegabile (il nome non e' indicizzabile): filtra in locale
+    if (!m_objectCache.isStale() || values.isEmpty()) {
+        syncObjects([this, promise, filters]() {
+            fulfil(promise, m_objectCache.search(SearchFilter::compile(filters)));
+        });
+        return promise->future();
+    }
+
+    // Una query equalTo per ogni valore, in parallelo; gli altri filtri si applicano sull'unione
+    struct UnionState
+    {
+        int pending = 0;
+        bool success = true;
+        QHash<QString, HomeObject> matches;
+    };
+    auto state = std::make_shared<UnionState>();
+    state->pending = values.size();
+
+    for (const QString& value : values) {
+        queryObjects(FirebaseQuery::orderBy(orderByChild).equalTo(value),
+                     [this, promise, filters, state, filterLocal](bool success, const QList<HomeObject>& objects) {
+            state->success = state->success && success;
+            for (const HomeObject& obj : objects) {
+                state->matches.insert(obj.name(), obj);
+            }
+            if (--state->pending > 0) {
+                return;
+            }
+
+            // Un'unione a cui manca una query non e' il risultato completo: si cerca nella cache
+            if (!state->success) {
+                fulfil(promise, m_objectCache.search(SearchFilter::compile(filters)));
+                return;
+            }
+            filterLocal(state->matches.values());
+        });
+    }
+
+    return promise->future();
+}
+
+QFuture<QList<ObjectTable::RoomCount>> FirebaseDatabaseManager::countObjectsByRoomAsync()
+{
+    auto promise = makePromise<QList<ObjectTable::RoomCount>>();
+    trackOperation(m_metrics, "countObjectsByRoom", promise->future());
+
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return fulfil(promise, QList<ObjectTable::RoomCount>());
+    }
+
+    // Aggregazione sulle colonne della cache, senza materializzare gli oggetti
+    syncObjects([this, promise]() {
+        fulfil(promise, m_objectCache.countByRoom());
+    });
+
+    return promise->future();
+}
+
+QFuture<QList<HomeObject>> FirebaseDatabaseManager::suggestObjectsAsync(const QString& text, int maxDistance, int limit)
+{
+    auto promise = makePromise<QList<HomeObject>>();
+    trackOperation(m_metrics, "suggestObjects", promise->future());
+
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return fulfil(promise, QList<HomeObject>());
+    }
+
+    // Servito dall'indice a trigrammi della cache. Ad ogni tasto non si attende la rete:
+    // se la cache e' solo un po' vecchia si risponde subito e la si aggiorna in background
+    if (m_objectCache.isComplete()) {
+        if (m_objectCache.isStale()) {
+            syncObjects([]() {});
+        }
+        return fulfil(promise, m_objectCache.suggest(text, maxDistance, limit));
+    }
+
+    syncObjects([this, promise, text, maxDistance, limit]() {
+        fulfil(promise, m_objectCache.suggest(text, maxDistance, limit));
+    });
+
+    return promise->future();
+}
+
+// ==================== PICTURE OPERATIONS ====================
+
+QByteArray FirebaseDatabaseManager::getPicture(const QString& pictureRef)
+{
+    return waitForResult(getPictureAsync(pictureRef));
+}
+
+QFuture<QByteArray> FirebaseDatabaseManager::getPictureAsync(const QString& pictureRef)
+{
+    auto promise = makePromise<QByteArray>();
+    trackOperation(m_metrics, "getPicture", promise->future());
+
+    if (pictureRef.isEmpty()) {
+        return fulfil(promise, QByteArray());
+    }
+
+    if (const QByteArray* cached = m_pictureCache.object(pictureRef)) {
+        return fulfil(promise, *cached);
+    }
+
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return fulfil(promise, QByteArray());
+    }
+
+    // Stessa foto gia' in download (es. piu' righe della lista con lo stesso riferimento)
+    if (!m_pictureReads.join(pictureRef, [promise](const QByteArray& picture) { fulfil(promise, picture); })) {
+        m_metrics->recordCoalescedRead();
+        return promise->future();
+    }
+
+    QString path = QString("/pictures/%1.json").arg(pictureRef);
+
+    sendRequest("GET", path, FirebaseQuery(), QByteArray(), [this, pictureRef](bool success, const QByteArray& response) {
+        QByteArray picture;
+
+        if (success) {
+            // Il nodo contiene una stringa base64: avvolgila in un array per poterla parsare
+            const QJsonArray wrapped = QJsonDocument::fromJson('[' + response + ']').array();
+            picture = QByteArray::fromBase64(wrapped.at(0).toString().toLatin1());
+        }
+
+        if (!picture.isEmpty()) {
+            m_pictureCache.insert(pictureRef, new QByteArray(picture), picture.size());
+            m_storedPictures.insert(pictureRef);
+        }
+
+        m_pictureReads.complete(pictureRef, picture);
+    });
+
+    return promise->future();
+}
+
+// ==================== REALTIME CHANGE FEED ====================
+
+bool FirebaseDatabaseManager::subscribe()
+{
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return false;
+    }
+
+    if (isSubscribed()) {
+        return true;
+    }
+
+    static const QStringList nodes = { "objects", "colors", "materials", "types" };
+
+    for (const QString& node : nodes) {
+        FirebaseEventStream* stream = new FirebaseEventStream(m_networkManager, this);
+        m_eventStreams.insert(node, stream);
+
+        QObject::connect(stream, &FirebaseEventStream::opened, this, [this]() {
+            m_streamRetryMs = 1000;
+        });
+        QObject::connect(stream, &FirebaseEventStream::eventReceived, this,
+                         [this, node](const QString& event, const QString& path, const QJsonValue& data) {
+            if (node == "objects") {
+                applyObjectEvent(event, path, data);
+            }
+            else {
+                applyAttributeEvent(node, event, path, data);
+            }
+        });
+        QObject::connect(stream, &FirebaseEventStream::keepAlive, this, [this, node]() {
+            // Lo stream e' vivo: la cache non ha bisogno di essere riletta
+            if (node == "objects") {
+                m_objectCache.markSynced(m_objectCache.syncWatermark());
+            }
+        });
+        QObject::connect(stream, &FirebaseEventStream::authRevoked, this, [this, node]() {
+            refreshAccessToken([this, node](bool refreshed) {
+                if (!refreshed) {
+                    expireAuthentication();
+                    unsubscribe();
+                    return;
+                }
+                openEventStream(node);
+            });
+        });
+        QObject::connect(stream, &FirebaseEventStream::canceled, this, [this, node](const QString& reason) {
+            setLastError("Realtime stream canceled for " + node + ": " + reason);
+        });
+        QObject::connect(stream, &FirebaseEventStream::closed, this, [this, node]() {
+            scheduleStreamReconnect(node);
+        });
+
+        openEventStream(node);
+    }
+
+    LOG_INFO(LogCategory, u8"📡 Subscribed to realtime changes");
+    return true;
+}
+
+void FirebaseDatabaseManager::unsubscribe()
+{
+    if (m_eventStreams.isEmpty()) {
+        return;
+    }
+
+    for (FirebaseEventStream* stream : std::as_const(m_eventStreams)) {
+        stream->close();
+        stream->deleteLater();
+    }
+    m_eventStreams.clear();
+    m_attributeModels.clear();
+
+    LOG_INFO(LogCategory, u8"📡 Unsubscribed from realtime changes");
+}
+
+bool FirebaseDatabaseManager::isSubscribed() const
+{
+    return !m_eventStreams.isEmpty();
+}
+
+void FirebaseDatabaseManager::openEventStream(const QString& node)
+{
+    FirebaseEventStream* stream = m_eventStreams.value(node);
+    if (!stream) {
+        return;
+    }
+
+    stream->open(QUrl(buildUrl("/" + node + ".json")));
+}
+
+void FirebaseDatabaseManager::scheduleStreamReconnect(const QString& node)
+{
+    FirebaseEventStream* stream = m_eventStreams.value(node);
+    if (!stream) {
+        return;
+    }
+
+    // Backoff esponenziale fino a 1 minuto, azzerato alla prossima apertura riuscita
+    const int delay = m_streamRetryMs;
+    m_streamRetryMs = qMin(m_streamRetryMs * 2, 60000);
+
+    LOG_WARNING(LogCategory, u8"📡 Realtime stream closed, reconnecting in " << delay << " ms");
+    QTimer::singleShot(delay, stream, [this, node]() {
+        openEventStream(node);
+    });
+}
+
+void FirebaseDatabaseManager::applyObjectEvent(const QString& event, const QString& path, const QJsonValue& data)
+{
+    const QStringList segments = path.split('/', Qt::SkipEmptyParts);
+
+    if (segments.isEmpty()) {
+        const QJsonObject children = data.toObject();
+
+        if (event == "put") {
+            // Snapshot completo: primo evento dopo l'apertura dello stream
+            QList<HomeObject> objects;
+            qint64 watermark = 0;
+            objects.reserve(children.size());
+
+            for (auto it = children.begin(); it != children.end(); ++it) {
+                qint64 updatedAt = 0;
+                objects.append(HomeObjectCodec::fromJson(it.value().toObject(), &updatedAt));
+                watermark = qMax(watermark, updatedAt);
+            }
+
+            m_objectCache.replaceAll(objects, watermark);
+            emit objectsReset();
+            return;
+        }
+
+        // patch sulla radice: ogni figlio e' un oggetto intero, o null se eliminato
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            applyObjectValue(it.key(), it.value());
+        }
+        return;
+    }
+
+    const QString name = segments.first();
+
+    if (segments.size() == 1 && event == "put") {
+        applyObjectValue(name, data);
+        return;
+    }
+
+    // Modifica parziale di un oggetto noto: applica i campi alla sua rappresentazione JSON
+    if (!m_objectCache.contains(name)) {
+        return;
+    }
+
+    QJsonObject json = HomeObjectCodec::toJson(m_objectCache.value(name));
+
+    if (segments.size() == 1) {
+        const QJsonObject fields = data.toObject();
+        for (auto it = fields.begin(); it != fields.end(); ++it) {
+            json[it.key()] = it.value();
+        }
+    }
+    else {
+        json[segments.at(1)] = data;
+    }
+
+    applyObjectValue(name, json);
+}
+
+void FirebaseDatabaseManager::applyObjectValue(const QString& name, const QJsonValue& value)
+{
+    if (value.isNull()) {
+        if (m_objectCache.contains(name)) {
+            m_objectCache.remove(name);
+            emit objectRemoved(name);
+        }
+        return;
+    }
+
+    qint64 updatedAt = 0;
+    HomeObject obj = HomeObjectCodec::fromJson(value.toObject(), &updatedAt);
+
+    m_objectCache.insert(obj);
+    m_objectCache.markSynced(updatedAt);
+    emit objectChanged(obj);
+}
+
+void FirebaseDatabaseManager::applyAttributeEvent(const QString& node, const QString& event, const QString& path, const QJsonValue& data)
+{
+    QMap<QString, QString>& values = m_attributeModels[node];
+
+    auto assign = [&values](const QString& key, const QJsonValue& value) {
+        if (value.isNull()) {
+            values.remove(key);
+        }
+        else {
+            values.insert(key, value.toString());
+        }
+    };
+
+    const QStringList segments = path.split('/', Qt::SkipEmptyParts);
+
+    if (!segments.isEmpty()) {
+        assign(segments.first(), data);
+    }
+    else {
+        if (event == "put") {
+            values.clear();
+        }
+
+        // Le liste con indici consecutivi arrivano come array JSON
+        if (data.isArray()) {
+            m_keyedNodes.remove(node); // riscritto nel formato precedente da un client vecchio
+            const QJsonArray arr = data.toArray();
+            for (int i = 0; i < arr.size(); ++i) {
+                assign(QString::number(i), arr.at(i));
+            }
+        }
+        else {
+            const QJsonObject children = data.toObject();
+            for (auto it = children.begin(); it != children.end(); ++it) {
+                assign(it.key(), it.value());
+            }
+        }
+    }
+
+    emit attributesChanged(node, attributeValues(node));
+}
+
+QStringList FirebaseDatabaseManager::attributeValues(const QString& node) const
+{
+    const QMap<QString, QString> values = m_attributeModels.value(node);
+    QStringList keys = values.keys();
+
+    // Chiavi numeriche (array): mantieni l'ordine degli indici
+    bool numeric = true;
+    for (const QString& key : keys) {
+        key.toInt(&numeric);
+        if (!numeric) {
+            break;
+        }
+    }
+    if (numeric) {
+        std::sort(keys.begin(), keys.end(), [](const QString& a, const QString& b) {
+            return a.toInt() < b.toInt();
+        });
+    }
+
+    QStringList result;
+    result.reserve(keys.size());
+    for (const QString& key : keys) {
+        result.append(values.value(key));
+    }
+    return result;
+}
+
+// ==================== ATTRIBUTES OPERATIONS ====================
+
+// Ogni valore e' un figlio del nodo con chiave derivata dal valore stesso:
+// /colors/<chiave> = "valore". Aggiungere o togliere un valore tocca una sola chiave.
+QString FirebaseDatabaseManager::attributeKey(const QString& value)
+{
+    // Firebase non accetta . $ # [ ] / e i caratteri di controllo nelle chiavi
+    static const QString forbidden = QStringLiteral(".$#[]/%");
+
+    QString key;
+    key.reserve(value.size());
+    for (const QChar c : value) {
+        if (forbidden.contains(c) || c.unicode() < 0x20 || c.unicode() == 0x7F) {
+            key += QString("%%1").arg(c.unicode(), 2, 16, QChar('0')).toUpper();
+        }
+        else {
+            key += c;
+        }
+    }
+    return key;
+}
+
+QString FirebaseDatabaseManager::attributePath(const QString& node, const QString& value)
+{
+    return "/" + node + "/" + QString::fromLatin1(QUrl::toPercentEncoding(attributeKey(value))) + ".json";
+}
+
+void FirebaseDatabaseManager::fetchStringList(const QString& node, StringListCallback callback)
+{
+    // Con lo stream realtime attivo il vocabolario locale e' gia' aggiornato: nessuna richiesta
+    if (isSubscribed() && m_attributeModels.contains(node)) {
+        setLastError(QString());
+        callback(attributeValues(node));
+        return;
+    }
+
+    auto cached = m_attributeSnapshots.constFind(node);
+    const bool fresh = cached != m_attributeSnapshots.constEnd() && cached->fetched.elapsed() < m_objectCache.maxAge();
+    m_metrics->recordCacheLookup(fresh);
+    if (fresh) {
+        setLastError(QString());
+        callback(cached->values);
+        return;
+    }
+
+    if (!m_attributeReads.join(node, callback)) {
+        m_metrics->recordCoalescedRead();
+        return;
+    }
+
+    // Firebase non ha GET condizionali (niente 304): l'ETag evita di riconvertire un nodo
+    // invariato e rende condizionale l'unica riscrittura dell'intero nodo (la migrazione)
+    sendConditionalRequest("GET", "/" + node + ".json", QByteArray(), QByteArray(), [this, node](bool success, const HttpResponse& response) {
+        auto snapshot = m_attributeSnapshots.find(node);
+
+        if (!success) {
+            // Meglio l'ultimo elenco noto che un elenco vuoto
+            m_attributeReads.complete(node, snapshot != m_attributeSnapshots.end() ? snapshot->values : QStringList());
+            return;
+        }
+
+        if (snapshot != m_attributeSnapshots.end() && !response.etag.isEmpty() && snapshot->etag == response.etag) {
+            snapshot->fetched.start();
+            m_attributeReads.complete(node, snapshot->values);
+            return;
+        }
+
+        QStringList values;
+        bool migrating = false;
+        const QJsonDocument doc = QJsonDocument::fromJson(response.body);
+
+        if (doc.isArray()) {
+            // Formato precedente (array intero): migrato una volta sola a nodi con chiave
+            const QJsonArray legacy = doc.array();
+            for (const QJsonValue& val : legacy) {
+                const QString value = val.toString();
+                if (!value.isEmpty() && !values.contains(value)) {
+                    values.append(value);
+                }
+            }
+            migrating = true;
+            migrateAttributeNode(node, legacy, response.etag, [](bool) {});
+        }
+        else {
+            const QJsonObject children = doc.object();
+            for (auto it = children.begin(); it != children.end(); ++it) {
+                values.append(it.value().toString());
+            }
+            m_keyedNodes.insert(node);
+        }
+
+        if (migrating) {
+            m_attributeSnapshots.remove(node);
+        }
+        else {
+            AttributeSnapshot& stored = m_attributeSnapshots[node];
+            stored.etag = response.etag;
+            stored.values = values;
+            stored.fetched.start();
+        }
+
+        m_attributeReads.complete(node, values);
+    });
+}
+
+void FirebaseDatabaseManager::addAttribute(const QString& node, const QString& value, const QString& duplicateError, ResultCallback callback)
+{
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        callback(false);
+        return;
+    }
+
+    if (value.isEmpty()) {
+        setLastError("Attribute value is required");
+        callback(false);
+        return;
+    }
+
+    // Con lo stream realtime attivo il vocabolario locale e' aggiornato: il duplicato
+    // si riconosce senza andare in rete
+    if (isSubscribed() && m_attributeModels.value(node).contains(attributeKey(value))) {
+        setLastError(duplicateError);
+        callback(false);
+        return;
+    }
+
+    // PUT condizionale di una sola chiave: riesce solo se la chiave non esiste (ETag di null),
+    // quindi il duplicato si riconosce anche senza stream e senza lettura preventiva
+    ensureKeyedNode(node, [this, node, value, duplicateError, callback](bool keyed) {
+        if (!keyed) {
+            callback(false);
+            return;
+        }
+        createAttributeKey(node, value, duplicateError, callback, true);
+    });
+}
+
+void FirebaseDatabaseManager::ensureKeyedNode(const QString& node, ResultCallback callback, bool retryOnConflict)
+{
+    // Una chiave scritta accanto a un array lo renderebbe un oggetto con i vecchi valori sotto
+    // "0", "1"...: la migrazione non partirebbe piu' e una DELETE per valore non troverebbe nulla
+    if (m_keyedNodes.contains(node)) {
+        callback(true);
+        return;
+    }
+
+    sendConditionalRequest("GET", "/" + node + ".json", QByteArray(), QByteArray(),
+                           [this, node, callback, retryOnConflict](bool success, const HttpResponse& response) {
+        if (!success) {
+            callback(false);
+            return;
+        }
+
+        const QJsonDocument doc = QJsonDocument::fromJson(response.body);
+        if (!doc.isArray()) {
+            m_keyedNodes.insert(node);
+            callback(true);
+            return;
+        }
+
+        migrateAttributeNode(node, doc.array(), response.etag, [this, node, callback, retryOnConflict](bool migrated) {
+            // Il nodo e' cambiato tra lettura e migrazione: si rilegge una volta
+            if (!migrated && retryOnConflict) {
+                ensureKeyedNode(node, callback, false);
+                return;
+            }
+            callback(migrated);
+        });
+    });
+}
+
+void FirebaseDatabaseManager::migrateAttributeNode(const QString& node, const QJsonArray& legacy, const QByteArray& etag,
+                                                   ResultCallback callback)
+{
+    QJsonObject keyed;
+    for (const QJsonValue& val : legacy) {
+        const QString value = val.toString();
+        if (!value.isEmpty()) {
+            keyed.insert(attributeKey(value), value);
+        }
+    }
+
+    // Condizionale: se un altro client ha modificato il nodo nel frattempo non lo sovrascrive
+    sendConditionalRequest("PUT", "/" + node + ".json", toPayload(keyed), etag,
+                           [this, node, callback](bool success, const HttpResponse& response) {
+        if (success) {
+            m_keyedNodes.insert(node);
+            m_attributeSnapshots.remove(node);
+            LOG_INFO(LogCategory, u8"🔁 Migrated " << node << " to keyed nodes");
+        }
+        else if (response.status == 412) {
+            LOG_INFO(LogCategory, u8"🔁 " << node << " changed during migration, left to the next reader");
+        }
+        callback(success);
+    });
+}
+
+void FirebaseDatabaseManager::createAttributeKey(const QString& node, const QString& value, const QString& duplicateError,
+                                                 ResultCallback callback, bool retryOnStaleEtag)
+{
+    const QByteArray nullEtag = m_nullEtag.isEmpty() ? QByteArray("unknown") : m_nullEtag;
+
+    sendConditionalRequest("PUT", attributePath(node, value), toPayload(value), nullEtag,
+                           [this, node, value, duplicateError, callback, retryOnStaleEtag](bool success, const HttpResponse& response) {
+        if (success) {
+            m_attributeSnapshots.remove(node);
+            callback(true);
+            return;
+        }
+
+        if (response.status != 412) {
+            callback(false);
+            return;
+        }
+
+        // 412 con corpo null: la chiave non esiste, era l'ETag di null a non essere ancora noto
+        if (response.body.trimmed() == "null" && retryOnStaleEtag && !response.etag.isEmpty()) {
+            m_nullEtag = response.etag;
+            createAttributeKey(node, value, duplicateError, callback, false);
+            return;
+        }
+
+        setLastError(duplicateError);
+        callback(false);
+    });
+}
+
+void FirebaseDatabaseManager::removeAttribute(const QString& node, const QString& value, ResultCallback callback)
+{
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        callback(false);
+        return;
+    }
+
+    ensureKeyedNode(node, [this, node, value, callback](bool keyed) {
+        if (!keyed) {
+            callback(false);
+            return;
+        }
+
+        sendRequest("DELETE", attributePath(node, value), FirebaseQuery(), QByteArray(), [this, node, callback](bool success, const QByteArray&) {
+            if (success) {
+                m_attributeSnapshots.remove(node);
+            }
+            callback(success);
+        });
+    });
+}
+
+QStringList FirebaseDatabaseManager::getColors()
+{
+    return waitForResult(getColorsAsync());
+}
+
+QFuture<QStringList> FirebaseDatabaseManager::getColorsAsync()
+{
+    auto promise = makePromise<QStringList>();
+    trackOperation(m_metrics, "getColors", promise->future());
+
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return fulfil(promise, QStringList());
+    }
+
+    fetchStringList("colors", [promise](const QStringList& colors) {
+        LOG_DEBUG(LogCategory, u8"🎨 Retrieved " << colors.size() << " colors");
+        fulfil(promise, colors);
+    });
+
+    return promise->future();
+}
+
+QStringList FirebaseDatabaseManager::getMaterials()
+{
+    return waitForResult(getMaterialsAsync());
+}
+
+QFuture<QStringList> FirebaseDatabaseManager::getMaterialsAsync()
+{
+    auto promise = makePromise<QStringList>();
+    trackOperation(m_metrics, "getMaterials", promise->future());
+
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return fulfil(promise, QStringList());
+    }
+
+    fetchStringList("materials", [promise](const QStringList& materials) {
+        LOG_DEBUG(LogCategory, u8"🔨 Retrieved " << materials.size() << " materials");
+        fulfil(promise, materials);
+    });
+
+    return promise->future();
+}
+
+QStringList FirebaseDatabaseManager::getTypes()
+{
+    return waitForResult(getTypesAsync());
+}
+
+QFuture<QStringList> FirebaseDatabaseManager::getTypesAsync()
+{
+    auto promise = makePromise<QStringList>();
+    trackOperation(m_metrics, "getTypes", promise->future());
+
+    if (!isAuthenticated()) {
+        setLastError("Not authenticated");
+        emit authenticationRequired();
+        return fulfil(promise, QStringList());
+    }
+
+    fetchStringList("types", [promise](const QStringList& types) {
+        LOG_DEBUG(LogCategory, u8"📋 Retrieved " << types.size() << " types");
+        fulfil(promise, types);
+    });
+
+    return promise->future();
+}
+
+bool FirebaseDatabaseManager::addColor(const QString& color)
+{
+    return waitForResult(addColorAsync(color));
+}
+
+QFuture<bool> FirebaseDatabaseManager::addColorAsync(const QString& color)
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "addColor", promise->future());
+    addAttribute("colors", color, "Color already exists", [promise](bool success) {
+        fulfil(promise, success);
+    });
+    return promise->future();
+}
+
+bool FirebaseDatabaseManager::addMaterial(const QString& material)
+{
+    return waitForResult(addMaterialAsync(material));
+}
+
+QFuture<bool> FirebaseDatabaseManager::addMaterialAsync(const QString& material)
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "addMaterial", promise->future());
+    addAttribute("materials", material, "Material already exists", [promise](bool success) {
+        fulfil(promise, success);
+    });
+    return promise->future();
+}
+
+bool FirebaseDatabaseManager::addType(const QString& type)
+{
+    return waitForResult(addTypeAsync(type));
+}
+
+QFuture<bool> FirebaseDatabaseManager::addTypeAsync(const QString& type)
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "addType", promise->future());
+    addAttribute("types", type, "Type already exists", [promise](bool success) {
+        fulfil(promise, success);
+    });
+    return promise->future();
+}
+
+bool FirebaseDatabaseManager::removeColor(const QString& color)
+{
+    return waitForResult(removeColorAsync(color));
+}
+
+QFuture<bool> FirebaseDatabaseManager::removeColorAsync(const QString& color)
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "removeColor", promise->future());
+    removeAttribute("colors", color, [promise](bool success) {
+        fulfil(promise, success);
+    });
+    return promise->future();
+}
+
+bool FirebaseDatabaseManager::removeMaterial(const QString& material)
+{
+    return waitForResult(removeMaterialAsync(material));
+}
+
+QFuture<bool> FirebaseDatabaseManager::removeMaterialAsync(const QString& material)
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "removeMaterial", promise->future());
+    removeAttribute("materials", material, [promise](bool success) {
+        fulfil(promise, success);
+    });
+    return promise->future();
+}
+
+bool FirebaseDatabaseManager::removeType(const QString& type)
+{
+    return waitForResult(removeTypeAsync(type));
+}
+
+QFuture<bool> FirebaseDatabaseManager::removeTypeAsync(const QString& type)
+{
+    auto promise = makePromise<bool>();
+    trackOperation(m_metrics, "removeType", promise->future());
+    removeAttribute("types", type, [promise](bool success) {
+        fulfil(promise, success);
+    });
+    return promise->future();
+}
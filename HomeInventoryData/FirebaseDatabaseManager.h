@@ -2,9 +2,17 @@
 #ifndef FIREBASEDATABASEMANAGER_H
 #define FIREBASEDATABASEMANAGER_H
 
-#include "idatabasemanager.h"
+#include "IDatabaseManager.h"
 #include "homeinventorydata_global.h"
 #include "CredentialsManager.h"
+#include "ObjectCache.h"
+#include "FirebaseQuery.h"
+#include "JsonStreamParser.h"
+#include "FirebaseEventStream.h"
+#include "FirebaseMetrics.h"
+#include "RequestOptions.h"
+#include "SingleFlight.h"
+#include "ObjectSnapshot.h"
 #include <QObject>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
@@ -13,6 +21,15 @@
 #include <QJsonArray>
 #include <QEventLoop>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QCache>
+#include <QSet>
+#include <QMap>
+#include <QHash>
+#include <QFuture>
+#include <QPromise>
+#include <functional>
+#include <memory>
 
 class HOMEINVENTORYDATA_EXPORT FirebaseDatabaseManager : public QObject, public IDatabaseManager
 {
@@ -31,18 +48,39 @@ public:
     bool setApiKey(const QString& apiKey);
     bool authenticateWithEmail(const QString& email, const QString& password, bool rememberMe = true);
     bool tryAutoLogin(); // Try auto login with saved credentials
+    QFuture<bool> authenticateWithEmailAsync(const QString& email, const QString& password, bool rememberMe = true);
+    QFuture<bool> tryAutoLoginAsync();
     bool isAuthenticated() const;
     QString currentUserEmail() const;
     void logout(bool clearSavedCredentials = false);
 
+    // Realtime change feed: tiene cache e vocabolari aggiornati con i soli cambiamenti
+    bool subscribe();
+    void unsubscribe();
+    bool isSubscribed() const;
+
+    // Local object cache
+    void setCacheMaxAge(qint64 msecs);
+    void invalidateCache();
+    QList<HomeObject> cachedObjects() const; // ultimo stato noto senza rete (anche non ancora riconciliato)
+
+    // Snapshot su disco: all'avvio la cache riparte dall'ultimo inventario noto, la rete la riconcilia in background
+    bool setSnapshotFile(const QString& filePath); // dopo connect(); carica subito lo snapshot se valido, path vuoto = disattiva
+    bool saveSnapshot();
+    const ObjectSnapshot& snapshot() const { return m_snapshot; } // vista zero-copy, riaperta a ogni salvataggio
+
     bool createObject(const HomeObject& object) override;
     QList<HomeObject> getObjects(int locationId, int sublocationId) override;
     QList<HomeObject> getAllObjects() override;
+    QFuture<HomeObject> streamAllObjectsAsync(); // risultati progressivi, man mano che arrivano dalla rete
     bool updateObject(const QString& oldName, const HomeObject& newObject) override;
     bool deleteObject(const QString& objectName) override;
+    bool applyBatch(const QList<ObjectMutation>& mutations) override;
 
     QList<HomeObject> searchObjects(const QVariantMap& filters) override;
 
+    QByteArray getPicture(const QString& pictureRef) override;
+
     QStringList getColors() override;
     QStringList getMaterials() override;
     QStringList getTypes() override;
@@ -55,14 +93,71 @@ public:
     bool removeMaterial(const QString& material) override;
     bool removeType(const QString& type) override;
 
+    // Async variants (non bloccanti, tutte sulla stessa pipeline di richieste)
+    QFuture<bool> createObjectAsync(const HomeObject& object) override;
+    QFuture<QList<HomeObject>> getObjectsAsync(int locationId, int sublocationId) override;
+    QFuture<QList<HomeObject>> getAllObjectsAsync() override;
+    QFuture<bool> updateObjectAsync(const QString& oldName, const HomeObject& newObject) override;
+    QFuture<bool> deleteObjectAsync(const QString& objectName) override;
+    QFuture<bool> applyBatchAsync(const QList<ObjectMutation>& mutations) override;
+    void setBatchChunkSize(qint64 bytes);
+
+    QFuture<QList<HomeObject>> searchObjectsAsync(const QVariantMap& filters) override;
+    QFuture<QList<ObjectTable::RoomCount>> countObjectsByRoomAsync(); // numero di oggetti per (location, sublocation)
+    QFuture<QList<HomeObject>> suggestObjectsAsync(const QString& text, int maxDistance = 2, int limit = 20); // type-ahead su nome e note, tollera errori di battitura
+
+    QFuture<QByteArray> getPictureAsync(const QString& pictureRef) override;
+    void setPictureCacheSize(qint64 bytes);
+
+    QFuture<QStringList> getColorsAsync() override;
+    QFuture<QStringList> getMaterialsAsync() override;
+    QFuture<QStringList> getTypesAsync() override;
+
+    QFuture<bool> addColorAsync(const QString& color) override;
+    QFuture<bool> addMaterialAsync(const QString& material) override;
+    QFuture<bool> addTypeAsync(const QString& type) override;
+
+    QFuture<bool> removeColorAsync(const QString& color) override;
+    QFuture<bool> removeMaterialAsync(const QString& material) override;
+    QFuture<bool> removeTypeAsync(const QString& type) override;
+
     QString lastError() const override;
 
+    // Trasporto: di default un QNetworkAccessManager interno; benchmark ed emulatore ne iniettano uno proprio
+    void setNetworkAccessManager(QNetworkAccessManager* manager);
+
+    // Endpoint di autenticazione (base URL senza slash finale, es. "http://127.0.0.1:9000/v1" per l'emulatore)
+    void setAuthEndpoints(const QString& identityToolkitUrl, const QString& secureTokenUrl);
+
+    // Esecuzione delle richieste: scadenza, retry con backoff e annullamento
+    void setRequestOptions(const RequestOptions& options);
+    RequestOptions requestOptions() const;
+    void cancelPendingRequests(); // le richieste in volo o in attesa di retry falliscono subito
+
+    // Connessioni: preapertura in connect()/setApiKey() e keep-warm nei periodi di inattivita'
+    void setConnectionWarmUp(bool enabled, int keepWarmIntervalMs = 60000); // 0 = nessun keep-warm
+    void preconnect(); // DNS + TCP + TLS verso database e autenticazione, senza inviare richieste
+
+    // Metriche: contatori e istogrammi di operazioni, verbi HTTP, byte, parsing e token
+    enum class MetricsFormat { Prometheus, Json };
+    FirebaseMetricsSnapshot metrics() const;
+    void resetMetrics();
+    void setMetricsDumpFile(const QString& filePath, MetricsFormat format = MetricsFormat::Prometheus, int intervalMs = 10000); // path vuoto = disattiva
+
 signals:
     void authenticationCompleted(bool success, const QString& email);
     void authenticationRequired();
 
+    // Realtime change feed
+    void objectChanged(const HomeObject& object);
+    void objectRemoved(const QString& objectName);
+    void objectsReset(); // nuovo snapshot completo degli oggetti
+    void attributesChanged(const QString& attribute, const QStringList& values);
+
 private:
     QString m_firebaseUrl;
+    QString m_identityToolkitUrl; // signInWithPassword
+    QString m_secureTokenUrl;     // refresh del token
 	QString m_apiKey;
     bool m_isConnected;
 	bool m_isAuthenticated;
@@ -73,26 +168,119 @@ private:
     QNetworkAccessManager* m_networkManager;
     QString m_lastError;
 	CredentialsManager* m_credentialsManager;
-	QDateTime m_tokenExpiry;
-	bool m_isRefreshingToken; // prevent infinite token refresh loops
+	QDateTime m_tokenExpiry; // ora del rinnovo (scadenza reale meno il margine)
+    QDateTime m_tokenValidUntil;               // scadenza reale del token
+    QTimer* m_tokenRefreshTimer;               // rinnovo proattivo del token
+    QList<std::function<void(bool)>> m_refreshWaiters; // richieste in attesa del refresh in volo
+    ObjectCache m_objectCache;
+    QList<std::function<void()>> m_syncWaiters; // letture in attesa della sincronizzazione in corso
+    QCache<QString, QByteArray> m_pictureCache;   // foto gia' scaricate, costo = dimensione in byte
+    QSet<QString> m_storedPictures;               // riferimenti gia' presenti nel picture store
+    QHash<QString, FirebaseEventStream*> m_eventStreams;     // nodo -> stream aperto
+    QHash<QString, QMap<QString, QString>> m_attributeModels; // nodo -> (chiave -> valore)
+    int m_streamRetryMs;
+    qint64 m_batchChunkBytes; // dimensione massima del corpo di una singola PATCH di un batch
+    std::shared_ptr<FirebaseMetrics> m_metrics; // condiviso con i future ancora in volo
+    QTimer* m_metricsDumpTimer;
+    QString m_metricsDumpPath;
+    MetricsFormat m_metricsDumpFormat = MetricsFormat::Prometheus;
+    QTimer* m_keepWarmTimer;
+    QTimer* m_snapshotSaveTimer;
+    ObjectSnapshot m_snapshot;
+    QString m_snapshotPath;
+    quint64 m_snapshotRevision = 0; // revisione della cache scritta nell'ultimo snapshot
+    RequestOptions m_requestOptions; // default di ogni richiesta al database
+
+    // Vocabolari letti senza stream: valori ed ETag dell'ultima lettura
+    struct AttributeSnapshot
+    {
+        QByteArray etag;
+        QStringList values;
+        QElapsedTimer fetched;
+    };
+    QHash<QString, AttributeSnapshot> m_attributeSnapshots;
+    QByteArray m_nullEtag; // ETag di un nodo inesistente: if-match per creare una chiave solo se assente
+    QSet<QString> m_keyedNodes; // vocabolari gia' verificati (o migrati) nel formato a chiavi
+
+    // Letture identiche in volo unite in una sola richiesta (chiave: percorso e query)
+    SingleFlight<bool, QJsonDocument> m_jsonReads;
+    SingleFlight<QStringList> m_attributeReads;
+    SingleFlight<QByteArray> m_pictureReads;
+    QElapsedTimer m_lastRequest; // ultima richiesta inviata, per il keep-warm
+    bool m_warmUpEnabled;
+
+    using ResultCallback = std::function<void(bool success)>;
+    using ReplyCallback = std::function<void(bool success, const QByteArray& response)>;
+    using JsonCallback = std::function<void(bool success, const QJsonDocument& doc)>;
+    using StringListCallback = std::function<void(const QStringList& values)>;
+    using ObjectsCallback = std::function<void(bool success, const QList<HomeObject>& objects)>;
+    using ChunkCallback = std::function<void(const QByteArray& chunk)>;
+
+    struct HttpResponse
+    {
+        int status = 0;
+        QByteArray body;
+        QByteArray etag; // solo se richiesto con X-Firebase-ETag
+    };
+    using ResponseCallback = std::function<void(bool success, const HttpResponse& response)>;
+
+    // Request pipeline: ogni richiesta e' asincrona e ne possono essere in volo molte
+    QString buildUrl(const QString& path, const FirebaseQuery& query = FirebaseQuery()) const;
+    QNetworkRequest makeRequest(const QUrl& url, const QByteArray& contentType) const;
+    struct PendingRequest;
+    void dispatch(QNetworkReply* reply, qint64 requestBytes, int timeoutMs, std::function<void(QNetworkReply*)> onFinished);
+    void sendRequest(const QByteArray& verb, const QString& path, const FirebaseQuery& query, const QByteArray& payload,
+                     ReplyCallback callback, ChunkCallback onChunk = ChunkCallback());
+    void sendRequest(const QByteArray& verb, const QString& path, const FirebaseQuery& query, const QByteArray& payload,
+                     const RequestOptions& options, ReplyCallback callback, ChunkCallback onChunk = ChunkCallback());
+    void sendConditionalRequest(const QByteArray& verb, const QString& path, const QByteArray& payload,
+                                const QByteArray& ifMatch, ResponseCallback callback); // con ETag; if-match se non vuoto
+    void executeRequest(const std::shared_ptr<PendingRequest>& request); // un tentativo; i retry lo richiamano
+    void getJson(const QString& path, JsonCallback callback);
+    void getJson(const QString& path, const FirebaseQuery& query, JsonCallback callback);
+    void writeJson(const QByteArray& verb, const QString& path, const QJsonValue& data, ResultCallback callback);
+    void expireAuthentication();
+
+    // Operation helpers
+    void syncObjects(std::function<void()> done);
+    void reconcileObjects(); // sincronizza in background una cache ripartita dallo snapshot
+    void reloadAllObjects(ResultCallback callback, std::function<void(const HomeObject&)> onObject = nullptr);
+    using DeltaCallback = std::function<void(bool success, bool indexMissing)>;
+    void deltaSyncObjects(DeltaCallback callback);
+    void queryObjects(const FirebaseQuery& query, ObjectsCallback callback);
+    void putObject(const HomeObject& object, ResultCallback callback);
+    void removeObject(const QString& objectName, ResultCallback callback);
+    void storePicture(const QByteArray& picture, std::function<void(bool success, const QString& pictureRef)> callback);
+    void fetchStringList(const QString& node, StringListCallback callback);
+    void addAttribute(const QString& node, const QString& value, const QString& duplicateError, ResultCallback callback);
+    void createAttributeKey(const QString& node, const QString& value, const QString& duplicateError,
+                            ResultCallback callback, bool retryOnStaleEtag);
+    void removeAttribute(const QString& node, const QString& value, ResultCallback callback);
+    void ensureKeyedNode(const QString& node, ResultCallback callback, bool retryOnConflict = true); // migra prima di scrivere
+    void migrateAttributeNode(const QString& node, const QJsonArray& legacy, const QByteArray& etag, ResultCallback callback);
+    static QString attributeKey(const QString& value);
+    static QString attributePath(const QString& node, const QString& value);
 
-    // Helper methods
-    QString buildUrl(const QString& path) const;
-    QJsonDocument performGetRequest(const QString& path, int retryCount = 0);
-    bool performPutRequest(const QString& path, const QJsonValue& data, int retryCount = 0);
-    bool performPostRequest(const QString& path, const QJsonValue& data, int retryCount = 0);
-    bool performDeleteRequest(const QString& path, int retryCount = 0);
-    bool performPatchRequest(const QString& path, const QJsonValue& data, int retryCount = 0);
+    // Realtime helpers
+    void openEventStream(const QString& node);
+    void scheduleStreamReconnect(const QString& node);
+    void applyObjectEvent(const QString& event, const QString& path, const QJsonValue& data);
+    void applyObjectValue(const QString& name, const QJsonValue& value);
+    void applyAttributeEvent(const QString& node, const QString& event, const QString& path, const QJsonValue& data);
+    QStringList attributeValues(const QString& node) const;
 
     // Auth helper methods
-    bool signInWithEmailPassword(const QString& email, const QString& password);
-    bool refreshAccessToken();
+    void signInWithEmailPassword(const QString& email, const QString& password, ResultCallback callback);
+    void refreshAccessToken(ResultCallback callback); // condiviso: un solo refresh in volo
+    void setTokenLifetime(int expiresIn);
+    void scheduleTokenRefresh();
+    bool isTokenExpired() const;
     bool verifyIdToken();
 
-    QJsonObject objectToJson(const HomeObject& object) const;
-    HomeObject jsonToObject(const QString& key, const QJsonObject& json) const;
+    static QString pictureRefFor(const QByteArray& picture);
 
     void setLastError(const QString& error);
+    void writeMetricsDump();
 };
 
 #endif // FIREBASEDATABASEMANAGER_H
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "FirebaseEventStream.h"
+#include <QNetworkRequest>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+const int WatchdogTimeoutMs = 75000;
+}
+
+FirebaseEventStream::FirebaseEventStream(QNetworkAccessManager* networkManager, QObject* parent)
+    : QObject(parent)
+    , m_networkManager(networkManager)
+    , m_reply(nullptr)
+{
+    m_watchdog.setSingleShot(true);
+    QObject::connect(&m_watchdog, &QTimer::timeout, this, [this]() {
+        if (m_reply) {
+            m_reply->abort();
+        }
+    });
+}
+
+FirebaseEventStream::~FirebaseEventStream()
+{
+    close();
+}
+
+void FirebaseEventStream::open(const QUrl& url)
+{
+    close();
+
+    QNetworkRequest request(url);
+    request.setRawHeader("Accept", "text/event-stream");
+    // Firebase puo' reindirizzare lo stream verso un altro host del database
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+
+    m_buffer.clear();
+    m_eventName.clear();
+    m_eventData.clear();
+
+    m_reply = m_networkManager->get(request);
+    QNetworkReply* reply = m_reply;
+
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() {
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status == 200) {
+            emit opened();
+        }
+    });
+    QObject::connect(reply, &QNetworkReply::readyRead, this, [this]() {
+        readAvailable();
+    });
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        if (reply != m_reply) {
+            return; // stream gia' chiuso o sostituito
+        }
+
+        const bool authError = reply->error() == QNetworkReply::AuthenticationRequiredError;
+        m_reply = nullptr;
+        m_watchdog.stop();
+
+        if (authError) {
+            emit authRevoked();
+            return;
+        }
+        emit closed();
+    });
+
+    m_watchdog.start(WatchdogTimeoutMs);
+}
+
+void FirebaseEventStream::close()
+{
+    m_watchdog.stop();
+
+    if (!m_reply) {
+        return;
+    }
+
+    QNetworkReply* reply = m_reply;
+    m_reply = nullptr; // il segnale finished emesso da abort() viene ignorato
+    reply->abort();
+    reply->deleteLater();
+}
+
+void FirebaseEventStream::readAvailable()
+{
+    if (!m_reply) {
+        return;
+    }
+
+    const int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status != 200) {
+        return; // corpo di un errore: gestito in finished
+    }
+
+    m_watchdog.start(WatchdogTimeoutMs);
+    m_buffer.append(m_reply->readAll());
+
+    qsizetype lineStart = 0;
+    qsizetype newline;
+    while ((newline = m_buffer.indexOf('\n', lineStart)) != -1) {
+        QByteArray line = m_buffer.mid(lineStart, newline - lineStart);
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        lineStart = newline + 1;
+        processLine(line);
+
+        if (!m_reply) {
+            return; // stream chiuso durante la gestione di un evento
+        }
+    }
+    m_buffer.remove(0, lineStart);
+}
+
+void FirebaseEventStream::processLine(const QByteArray& line)
+{
+    // Riga vuota = fine dell'evento corrente
+    if (line.isEmpty()) {
+        dispatchEvent();
+        return;
+    }
+
+    if (line.startsWith(':')) {
+        return; // commento
+    }
+
+    const qsizetype colon = line.indexOf(':');
+    const QByteArray field = colon == -1 ? line : line.left(colon);
+    QByteArray value = colon == -1 ? QByteArray() : line.mid(colon + 1);
+    if (value.startsWith(' ')) {
+        value.remove(0, 1);
+    }
+
+    if (field == "event") {
+        m_eventName = QString::fromUtf8(value);
+    }
+    else if (field == "data") {
+        if (!m_eventData.isEmpty()) {
+            m_eventData.append('\n');
+        }
+        m_eventData.append(value);
+    }
+}
+
+void FirebaseEventStream::dispatchEvent()
+{
+    const QString event = m_eventName;
+    const QByteArray data = m_eventData;
+    m_eventName.clear();
+    m_eventData.clear();
+
+    if (event.isEmpty()) {
+        return;
+    }
+
+    if (event == "keep-alive") {
+        emit keepAlive();
+    }
+    else if (event == "put" || event == "patch") {
+        // data: {"path": "/figlio", "data": <nuovo valore>}
+        const QJsonObject payload = QJsonDocument::fromJson(data).object();
+        emit eventReceived(event, payload["path"].toString(), payload["data"]);
+    }
+    else if (event == "auth_revoked") {
+        close();
+        emit authRevoked();
+    }
+    else if (event == "cancel") {
+        close();
+        emit canceled(QString::fromUtf8(data));
+    }
+}
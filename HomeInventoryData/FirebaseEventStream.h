@@ -0,0 +1,50 @@
+#pragma once
+#ifndef FIREBASEEVENTSTREAM_H
+#define FIREBASEEVENTSTREAM_H
+
+#include "homeinventorydata_global.h"
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QJsonValue>
+#include <QTimer>
+#include <QUrl>
+
+/**
+ * @brief Stream di eventi REST di Firebase (Server-Sent Events, Accept: text/event-stream)
+ * Notifica gli eventi put/patch di un nodo man mano che avvengono, senza rileggere il nodo
+ */
+class HOMEINVENTORYDATA_EXPORT FirebaseEventStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FirebaseEventStream(QNetworkAccessManager* networkManager, QObject* parent = nullptr);
+    ~FirebaseEventStream() override;
+
+    void open(const QUrl& url);
+    void close();
+    bool isOpen() const { return m_reply != nullptr; }
+
+signals:
+    void opened();
+    void eventReceived(const QString& event, const QString& path, const QJsonValue& data);
+    void keepAlive();
+    void authRevoked();
+    void canceled(const QString& reason);
+    void closed(); // connessione chiusa dal server o per inattivita'
+
+private:
+    QNetworkAccessManager* m_networkManager;
+    QNetworkReply* m_reply;
+    QByteArray m_buffer;
+    QString m_eventName;
+    QByteArray m_eventData;
+    QTimer m_watchdog; // Firebase invia keep-alive ogni 30 s: oltre questo tempo la connessione e' morta
+
+    void readAvailable();
+    void processLine(const QByteArray& line);
+    void dispatchEvent();
+};
+
+#endif // FIREBASEEVENTSTREAM_H
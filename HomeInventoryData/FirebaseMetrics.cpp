@@ -0,0 +1,272 @@
+#include "FirebaseMetrics.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+
+QByteArray seconds(qint64 us)
+{
+    return QByteArray::number(us / 1e6, 'g', 9);
+}
+
+// Le label Prometheus sono stringhe tra virgolette: escape di \, " e a capo
+QByteArray labelValue(const QString& value)
+{
+    QByteArray escaped = value.toUtf8();
+    escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return escaped;
+}
+
+void writeHistogram(QByteArray& out, const QByteArray& name, const QByteArray& labels, const LatencyHistogram& histogram)
+{
+    const QByteArray prefix = labels.isEmpty() ? QByteArray("{") : "{" + labels + ",";
+    qint64 cumulative = 0;
+    for (size_t i = 0; i < histogram.buckets.size(); ++i) {
+        cumulative += histogram.buckets[i];
+        const QByteArray bound = i < LatencyHistogram::BucketBoundsUs.size()
+            ? seconds(LatencyHistogram::BucketBoundsUs[i])
+            : QByteArray("+Inf");
+        out += name + "_bucket" + prefix + "le=\"" + bound + "\"} " + QByteArray::number(cumulative) + "\n";
+    }
+    const QByteArray suffix = labels.isEmpty() ? QByteArray() : "{" + labels + "}";
+    out += name + "_sum" + suffix + " " + seconds(histogram.sumUs) + "\n";
+    out += name + "_count" + suffix + " " + QByteArray::number(histogram.count) + "\n";
+}
+
+void writeCounter(QByteArray& out, const QByteArray& name, const QByteArray& help, qint64 value)
+{
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " counter\n";
+    out += name + " " + QByteArray::number(value) + "\n";
+}
+
+void writeGroup(QByteArray& out, const QByteArray& name, const QByteArray& label, const QByteArray& help,
+                const QMap<QString, OperationMetrics>& group)
+{
+    out += "# HELP " + name + "_calls_total " + help + " calls\n";
+    out += "# TYPE " + name + "_calls_total counter\n";
+    for (auto it = group.begin(); it != group.end(); ++it) {
+        out += name + "_calls_total{" + label + "=\"" + labelValue(it.key()) + "\"} " + QByteArray::number(it->calls) + "\n";
+    }
+
+    out += "# HELP " + name + "_failures_total " + help + " failures\n";
+    out += "# TYPE " + name + "_failures_total counter\n";
+    for (auto it = group.begin(); it != group.end(); ++it) {
+        out += name + "_failures_total{" + label + "=\"" + labelValue(it.key()) + "\"} " + QByteArray::number(it->failures) + "\n";
+    }
+
+    out += "# HELP " + name + "_duration_seconds " + help + " latency\n";
+    out += "# TYPE " + name + "_duration_seconds histogram\n";
+    for (auto it = group.begin(); it != group.end(); ++it) {
+        writeHistogram(out, name + "_duration_seconds", label + "=\"" + labelValue(it.key()) + "\"", it->latency);
+    }
+}
+
+QJsonObject histogramToJson(const LatencyHistogram& histogram)
+{
+    QJsonArray buckets;
+    for (size_t i = 0; i < histogram.buckets.size(); ++i) {
+        buckets.append(QJsonObject{
+            { "leUs", i < LatencyHistogram::BucketBoundsUs.size() ? QJsonValue(double(LatencyHistogram::BucketBoundsUs[i])) : QJsonValue("+Inf") },
+            { "count", double(histogram.buckets[i]) }
+        });
+    }
+
+    return QJsonObject{
+        { "count", double(histogram.count) },
+        { "sumUs", double(histogram.sumUs) },
+        { "maxUs", double(histogram.maxUs) },
+        { "p50Us", double(histogram.percentileUs(50)) },
+        { "p90Us", double(histogram.percentileUs(90)) },
+        { "p99Us", double(histogram.percentileUs(99)) },
+        { "buckets", buckets }
+    };
+}
+
+QJsonObject groupToJson(const QMap<QString, OperationMetrics>& group)
+{
+    QJsonObject json;
+    for (auto it = group.begin(); it != group.end(); ++it) {
+        QJsonObject entry = histogramToJson(it->latency);
+        entry["calls"] = double(it->calls);
+        entry["failures"] = double(it->failures);
+        json[it.key()] = entry;
+    }
+    return json;
+}
+
+} // namespace
+
+// ==================== LatencyHistogram ====================
+
+void LatencyHistogram::record(qint64 us)
+{
+    size_t bucket = 0;
+    while (bucket < BucketBoundsUs.size() && us > BucketBoundsUs[bucket]) {
+        ++bucket;
+    }
+    ++buckets[bucket];
+    ++count;
+    sumUs += us;
+    maxUs = qMax(maxUs, us);
+}
+
+qint64 LatencyHistogram::percentileUs(double percentile) const
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    const qint64 rank = qMax<qint64>(1, qint64(percentile / 100.0 * count + 0.5));
+    qint64 cumulative = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        cumulative += buckets[i];
+        if (cumulative >= rank) {
+            return i < BucketBoundsUs.size() ? qMin(BucketBoundsUs[i], maxUs) : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+// ==================== FirebaseMetricsSnapshot ====================
+
+QByteArray FirebaseMetricsSnapshot::toPrometheus() const
+{
+    QByteArray out;
+    writeGroup(out, "homeinventory_operation", "operation", "Data layer operation", operations);
+    writeGroup(out, "homeinventory_http_request", "verb", "Firebase HTTP request", verbs);
+
+    out += "# HELP homeinventory_json_parse_duration_seconds Time spent converting JSON responses\n";
+    out += "# TYPE homeinventory_json_parse_duration_seconds histogram\n";
+    writeHistogram(out, "homeinventory_json_parse_duration_seconds", QByteArray(), jsonParse);
+
+    writeCounter(out, "homeinventory_http_received_bytes_total", "Response bytes received", bytesIn);
+    writeCounter(out, "homeinventory_http_sent_bytes_total", "Request bytes sent", bytesOut);
+    writeCounter(out, "homeinventory_http_timeouts_total", "Requests aborted by the inactivity timeout", timeouts);
+    writeCounter(out, "homeinventory_http_auth_retries_total", "Requests replayed after a 401", authRetries);
+    writeCounter(out, "homeinventory_http_retries_total", "Attempts retried after a network error or 5xx", retries);
+    writeCounter(out, "homeinventory_token_refreshes_total", "ID token refresh attempts", tokenRefreshes);
+    writeCounter(out, "homeinventory_token_refresh_failures_total", "Failed ID token refreshes", tokenRefreshFailures);
+    writeCounter(out, "homeinventory_cache_hits_total", "Reads served by the object cache", cacheHits);
+    writeCounter(out, "homeinventory_cache_misses_total", "Reads that needed a synchronization", cacheMisses);
+    writeCounter(out, "homeinventory_coalesced_reads_total", "Reads joined to an identical request already in flight", coalescedReads);
+
+    out += "# HELP homeinventory_uptime_seconds Time since the metrics were reset\n";
+    out += "# TYPE homeinventory_uptime_seconds gauge\n";
+    out += "homeinventory_uptime_seconds " + seconds(uptimeMs * 1000) + "\n";
+    return out;
+}
+
+QByteArray FirebaseMetricsSnapshot::toJson() const
+{
+    const QJsonObject json{
+        { "operations", groupToJson(operations) },
+        { "verbs", groupToJson(verbs) },
+        { "jsonParse", histogramToJson(jsonParse) },
+        { "bytesIn", double(bytesIn) },
+        { "bytesOut", double(bytesOut) },
+        { "timeouts", double(timeouts) },
+        { "authRetries", double(authRetries) },
+        { "retries", double(retries) },
+        { "tokenRefreshes", double(tokenRefreshes) },
+        { "tokenRefreshFailures", double(tokenRefreshFailures) },
+        { "cacheHits", double(cacheHits) },
+        { "cacheMisses", double(cacheMisses) },
+        { "coalescedReads", double(coalescedReads) },
+        { "uptimeMs", double(uptimeMs) }
+    };
+    return QJsonDocument(json).toJson(QJsonDocument::Indented);
+}
+
+// ==================== FirebaseMetrics ====================
+
+FirebaseMetrics::FirebaseMetrics()
+    : m_startedMs(QDateTime::currentMSecsSinceEpoch())
+{
+}
+
+void FirebaseMetrics::recordOperation(const QString& operation, qint64 elapsedUs, bool success)
+{
+    QMutexLocker locker(&m_mutex);
+    OperationMetrics& metrics = m_data.operations[operation];
+    ++metrics.calls;
+    if (!success) {
+        ++metrics.failures;
+    }
+    metrics.latency.record(elapsedUs);
+}
+
+void FirebaseMetrics::recordRequest(const QByteArray& verb, qint64 elapsedUs, bool success, qint64 bytesOut, qint64 bytesIn)
+{
+    QMutexLocker locker(&m_mutex);
+    OperationMetrics& metrics = m_data.verbs[QString::fromLatin1(verb)];
+    ++metrics.calls;
+    if (!success) {
+        ++metrics.failures;
+    }
+    metrics.latency.record(elapsedUs);
+    m_data.bytesOut += bytesOut;
+    m_data.bytesIn += bytesIn;
+}
+
+void FirebaseMetrics::recordParse(qint64 elapsedUs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_data.jsonParse.record(elapsedUs);
+}
+
+void FirebaseMetrics::recordTimeout()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_data.timeouts;
+}
+
+void FirebaseMetrics::recordAuthRetry()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_data.authRetries;
+}
+
+void FirebaseMetrics::recordRetry()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_data.retries;
+}
+
+void FirebaseMetrics::recordCoalescedRead()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_data.coalescedReads;
+}
+
+void FirebaseMetrics::recordTokenRefresh(bool success)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_data.tokenRefreshes;
+    if (!success) {
+        ++m_data.tokenRefreshFailures;
+    }
+}
+
+void FirebaseMetrics::recordCacheLookup(bool hit)
+{
+    QMutexLocker locker(&m_mutex);
+    ++(hit ? m_data.cacheHits : m_data.cacheMisses);
+}
+
+FirebaseMetricsSnapshot FirebaseMetrics::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    FirebaseMetricsSnapshot copy = m_data;
+    copy.uptimeMs = QDateTime::currentMSecsSinceEpoch() - m_startedMs;
+    return copy;
+}
+
+void FirebaseMetrics::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_data = FirebaseMetricsSnapshot();
+    m_startedMs = QDateTime::currentMSecsSinceEpoch();
+}
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef FIREBASEMETRICS_H
+#define FIREBASEMETRICS_H
+
+#include "homeinventorydata_global.h"
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <array>
+
+/**
+ * @brief Istogramma a bucket fissi (limiti in microsecondi, cumulativi come in Prometheus)
+ */
+struct HOMEINVENTORYDATA_EXPORT LatencyHistogram
+{
+    static constexpr std::array<qint64, 17> BucketBoundsUs = {
+        50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+        100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+    };
+
+    std::array<qint64, BucketBoundsUs.size() + 1> buckets{}; // l'ultimo e' +Inf
+    qint64 count = 0;
+    qint64 sumUs = 0;
+    qint64 maxUs = 0;
+
+    void record(qint64 us);
+    qint64 percentileUs(double percentile) const; // limite superiore del bucket che contiene il percentile
+};
+
+/**
+ * @brief Contatori di una singola operazione o di un singolo verbo HTTP
+ */
+struct HOMEINVENTORYDATA_EXPORT OperationMetrics
+{
+    qint64 calls = 0;
+    qint64 failures = 0;
+    LatencyHistogram latency;
+};
+
+/**
+ * @brief Fotografia coerente di tutte le metriche in un istante
+ */
+struct HOMEINVENTORYDATA_EXPORT FirebaseMetricsSnapshot
+{
+    QMap<QString, OperationMetrics> operations; // API pubbliche: getAllObjects, createObject, ...
+    QMap<QString, OperationMetrics> verbs;      // richieste HTTP: GET, PUT, PATCH, DELETE, POST
+    LatencyHistogram jsonParse;                 // tempo speso a convertire JSON in HomeObject/DOM
+
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+    qint64 timeouts = 0;
+    qint64 authRetries = 0;       // richieste ripetute dopo un 401
+    qint64 retries = 0;           // tentativi ripetuti dopo un errore di rete o 5xx
+    qint64 tokenRefreshes = 0;
+    qint64 tokenRefreshFailures = 0;
+    qint64 cacheHits = 0;         // letture servite dalla cache senza rete
+    qint64 cacheMisses = 0;
+    qint64 coalescedReads = 0;    // letture unite a una richiesta identica gia' in volo
+    qint64 uptimeMs = 0;
+
+    QByteArray toPrometheus() const; // formato testo di Prometheus (exposition format 0.0.4)
+    QByteArray toJson() const;
+};
+
+/**
+ * @brief Raccolta delle metriche di FirebaseDatabaseManager
+ * Thread-safe: registrazione dal thread del manager, snapshot da qualunque thread
+ */
+class HOMEINVENTORYDATA_EXPORT FirebaseMetrics
+{
+public:
+    FirebaseMetrics();
+
+    void recordOperation(const QString& operation, qint64 elapsedUs, bool success);
+    void recordRequest(const QByteArray& verb, qint64 elapsedUs, bool success, qint64 bytesOut, qint64 bytesIn);
+    void recordParse(qint64 elapsedUs);
+    void recordTimeout();
+    void recordAuthRetry();
+    void recordRetry();
+    void recordCoalescedRead();
+    void recordTokenRefresh(bool success);
+    void recordCacheLookup(bool hit);
+
+    FirebaseMetricsSnapshot snapshot() const;
+    void reset();
+
+private:
+    mutable QMutex m_mutex;
+    FirebaseMetricsSnapshot m_data;
+    qint64 m_startedMs;
+};
+
+#endif // FIREBASEMETRICS_H
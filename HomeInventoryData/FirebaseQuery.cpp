@@ -0,0 +1,54 @@
+#include "FirebaseQuery.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QUrl>
+
+FirebaseQuery FirebaseQuery::orderBy(const QString& child)
+{
+    FirebaseQuery query;
+    query.m_query.addQueryItem("orderBy", encodeValue(child));
+    return query;
+}
+
+FirebaseQuery FirebaseQuery::shallowKeys()
+{
+    FirebaseQuery query;
+    query.m_query.addQueryItem("shallow", "true");
+    return query;
+}
+
+FirebaseQuery& FirebaseQuery::equalTo(const QJsonValue& value)
+{
+    m_query.addQueryItem("equalTo", encodeValue(value));
+    return *this;
+}
+
+FirebaseQuery& FirebaseQuery::startAt(const QJsonValue& value)
+{
+    m_query.addQueryItem("startAt", encodeValue(value));
+    return *this;
+}
+
+FirebaseQuery& FirebaseQuery::endAt(const QJsonValue& value)
+{
+    m_query.addQueryItem("endAt", encodeValue(value));
+    return *this;
+}
+
+FirebaseQuery& FirebaseQuery::limitToFirst(int count)
+{
+    m_query.addQueryItem("limitToFirst", QString::number(count));
+    return *this;
+}
+
+QString FirebaseQuery::toString() const
+{
+    return m_query.toString(QUrl::FullyEncoded);
+}
+
+QString FirebaseQuery::encodeValue(const QJsonValue& value)
+{
+    // Serializza il valore dentro un array e togli le parentesi: "Rosso" -> "\"Rosso\"", 3 -> "3"
+    QByteArray wrapped = QJsonDocument(QJsonArray{ value }).toJson(QJsonDocument::Compact);
+    return QString::fromUtf8(wrapped.mid(1, wrapped.size() - 2));
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef FIREBASEQUERY_H
+#define FIREBASEQUERY_H
+
+#include "homeinventorydata_global.h"
+#include <QString>
+#include <QUrlQuery>
+#include <QJsonValue>
+
+/**
+ * @brief Parametri di query REST di Firebase (orderBy, equalTo, startAt, shallow...)
+ * I valori vengono codificati in JSON come richiesto dall'API, es. orderBy="locationId"
+ */
+class HOMEINVENTORYDATA_EXPORT FirebaseQuery
+{
+public:
+    FirebaseQuery() = default;
+
+    static FirebaseQuery orderBy(const QString& child);
+    static FirebaseQuery shallowKeys();
+
+    FirebaseQuery& equalTo(const QJsonValue& value);
+    FirebaseQuery& startAt(const QJsonValue& value);
+    FirebaseQuery& endAt(const QJsonValue& value);
+    FirebaseQuery& limitToFirst(int count);
+
+    bool isEmpty() const { return m_query.isEmpty(); }
+    QUrlQuery toUrlQuery() const { return m_query; }
+    QString toString() const;
+
+private:
+    QUrlQuery m_query;
+
+    static QString encodeValue(const QJsonValue& value);
+};
+
+#endif // FIREBASEQUERY_H
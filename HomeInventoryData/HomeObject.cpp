@@ -3,6 +3,9 @@
 HomeObject::HomeObject()
     : m_locationId(0)
     , m_sublocationId(0)
+    , m_colorId(AttributeDictionary::EmptyId)
+    , m_materialId(AttributeDictionary::EmptyId)
+    , m_typeId(AttributeDictionary::EmptyId)
 {
 }
 
@@ -10,6 +13,9 @@ HomeObject::HomeObject(const QString& name, int locationId, int sublocationId)
     : m_name(name)
     , m_locationId(locationId)
     , m_sublocationId(sublocationId)
+    , m_colorId(AttributeDictionary::EmptyId)
+    , m_materialId(AttributeDictionary::EmptyId)
+    , m_typeId(AttributeDictionary::EmptyId)
 {
 }
 
@@ -3,6 +3,7 @@
 #define HOMEOBJECT_H
 
 #include "homeinventorydata_global.h"
+#include "AttributeDictionary.h"
 #include <QString>
 #include <QByteArray>
 
@@ -13,22 +14,33 @@ public:
     HomeObject(const QString& name, int locationId, int sublocationId);
 
     // Getters
-    QString name() const { return m_name; }
-    QString color() const { return m_color; }
-    QString material() const { return m_material; }
-    QString type() const { return m_type; }
-    QString notes() const { return m_notes; }
-    QByteArray picture() const { return m_picture; }
+    const QString& name() const { return m_name; }
+    const QString& color() const { return AttributeDictionary::colors().value(m_colorId); }
+    const QString& material() const { return AttributeDictionary::materials().value(m_materialId); }
+    const QString& type() const { return AttributeDictionary::types().value(m_typeId); }
+    const QString& notes() const { return m_notes; }
+    const QByteArray& picture() const { return m_picture; }
+    const QString& pictureRef() const { return m_pictureRef; } // Hash SHA-256 della foto nel picture store
+    bool hasPicture() const { return !m_picture.isEmpty() || !m_pictureRef.isEmpty(); }
     int locationId() const { return m_locationId; }
     int sublocationId() const { return m_sublocationId; }
 
+    // Attributi come ID dei vocabolari condivisi (vedi AttributeDictionary)
+    AttributeDictionary::Id colorId() const { return m_colorId; }
+    AttributeDictionary::Id materialId() const { return m_materialId; }
+    AttributeDictionary::Id typeId() const { return m_typeId; }
+
     // Setters
     void setName(const QString& name) { m_name = name; }
-    void setColor(const QString& color) { m_color = color; }
-    void setMaterial(const QString& material) { m_material = material; }
-    void setType(const QString& type) { m_type = type; }
+    void setColor(const QString& color) { m_colorId = AttributeDictionary::colors().intern(color); }
+    void setMaterial(const QString& material) { m_materialId = AttributeDictionary::materials().intern(material); }
+    void setType(const QString& type) { m_typeId = AttributeDictionary::types().intern(type); }
+    void setColorId(AttributeDictionary::Id id) { m_colorId = id; }
+    void setMaterialId(AttributeDictionary::Id id) { m_materialId = id; }
+    void setTypeId(AttributeDictionary::Id id) { m_typeId = id; }
     void setNotes(const QString& notes) { m_notes = notes; }
     void setPicture(const QByteArray& picture) { m_picture = picture; }
+    void setPictureRef(const QString& pictureRef) { m_pictureRef = pictureRef; }
     void setLocationId(int id) { m_locationId = id; }
     void setSublocationId(int id) { m_sublocationId = id; }
 
@@ -41,13 +53,14 @@ public:
 
 private:
     QString m_name;
-    QString m_color;
-    QString m_material;
-    QString m_type;
     QString m_notes;
-    QByteArray m_picture;
+    QByteArray m_picture; // Caricata solo su richiesta, vedi IDatabaseManager::getPicture
+    QString m_pictureRef;
     int m_locationId;
     int m_sublocationId;
+    AttributeDictionary::Id m_colorId;
+    AttributeDictionary::Id m_materialId;
+    AttributeDictionary::Id m_typeId;
 };
 
 #endif // HOMEOBJECT_H
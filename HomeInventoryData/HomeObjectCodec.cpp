@@ -0,0 +1,629 @@
+#include "HomeObjectCodec.h"
+#include <QJsonValue>
+#include <QString>
+#include <QStringView>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+enum class Field
+{
+    Name,
+    Color,
+    Material,
+    Type,
+    Notes,
+    LocationId,
+    SublocationId,
+    UpdatedAt,
+    PictureRef,
+    Picture
+};
+
+struct FieldSpec
+{
+    Field field;
+    std::string_view key;
+};
+
+// Tabella dei campi, nell'ordine di scrittura; picture (formato precedente) viene solo letta
+constexpr FieldSpec Fields[] = {
+    { Field::Name, "name" },
+    { Field::Color, "color" },
+    { Field::Material, "material" },
+    { Field::Type, "type" },
+    { Field::Notes, "notes" },
+    { Field::LocationId, "locationId" },
+    { Field::SublocationId, "sublocationId" },
+    { Field::UpdatedAt, "updatedAt" },
+    { Field::PictureRef, "pictureRef" },
+    { Field::Picture, "picture" },
+};
+
+// updatedAt viene assegnato dal server: e' il watermark della sincronizzazione delta
+constexpr std::string_view ServerTimestamp = "{\".sv\":\"timestamp\"}";
+
+const int MaxDepth = 64; // annidamento massimo dei valori ignorati
+
+// Le foto nuove vanno nel picture store: nell'oggetto si scrive solo pictureRef, se presente
+bool isWritten(Field field, const HomeObject& object)
+{
+    return field != Field::Picture && (field != Field::PictureRef || !object.pictureRef().isEmpty());
+}
+
+QString keyOf(const FieldSpec& spec)
+{
+    return QString::fromLatin1(spec.key.data(), qsizetype(spec.key.size()));
+}
+
+const FieldSpec* findField(std::string_view key)
+{
+    for (const FieldSpec& spec : Fields) {
+        if (spec.key == key) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+// ==================== SCRITTURA ====================
+
+void appendKey(QByteArray& out, std::string_view key)
+{
+    out += '"';
+    out.append(key.data(), qsizetype(key.size()));
+    out += "\":";
+}
+
+// UTF-16 -> UTF-8 con l'escape JSON, scritto direttamente nel buffer senza QString::toUtf8()
+void appendString(QByteArray& out, QStringView text)
+{
+    static const char Hex[] = "0123456789abcdef";
+
+    const qsizetype start = out.size();
+    out.resize(start + 2 + text.size() * 6); // caso peggiore: \u00XX per ogni carattere
+    char* p = out.data() + start;
+    *p++ = '"';
+
+    const char16_t* s = text.utf16();
+    const char16_t* end = s + text.size();
+    while (s < end) {
+        const char16_t c = *s++;
+
+        if (c < 0x80) {
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                *p++ = char(c);
+                continue;
+            }
+            *p++ = '\\';
+            switch (c) {
+            case '"': *p++ = '"'; break;
+            case '\\': *p++ = '\\'; break;
+            case '\n': *p++ = 'n'; break;
+            case '\r': *p++ = 'r'; break;
+            case '\t': *p++ = 't'; break;
+            case '\b': *p++ = 'b'; break;
+            case '\f': *p++ = 'f'; break;
+            default:
+                *p++ = 'u';
+                *p++ = '0';
+                *p++ = '0';
+                *p++ = Hex[c >> 4];
+                *p++ = Hex[c & 0xF];
+                break;
+            }
+        }
+        else if (c < 0x800) {
+            *p++ = char(0xC0 | (c >> 6));
+            *p++ = char(0x80 | (c & 0x3F));
+        }
+        else if (QChar::isHighSurrogate(c) && s < end && QChar::isLowSurrogate(*s)) {
+            const char32_t u = QChar::surrogateToUcs4(c, *s++);
+            *p++ = char(0xF0 | (u >> 18));
+            *p++ = char(0x80 | ((u >> 12) & 0x3F));
+            *p++ = char(0x80 | ((u >> 6) & 0x3F));
+            *p++ = char(0x80 | (u & 0x3F));
+        }
+        else if (QChar::isSurrogate(c)) {
+            // Surrogato isolato: non ha una forma UTF-8, come QJsonDocument lo si scrive come \uXXXX
+            *p++ = '\\';
+            *p++ = 'u';
+            *p++ = Hex[c >> 12];
+            *p++ = Hex[(c >> 8) & 0xF];
+            *p++ = Hex[(c >> 4) & 0xF];
+            *p++ = Hex[c & 0xF];
+        }
+        else {
+            *p++ = char(0xE0 | (c >> 12));
+            *p++ = char(0x80 | ((c >> 6) & 0x3F));
+            *p++ = char(0x80 | (c & 0x3F));
+        }
+    }
+
+    *p++ = '"';
+    out.resize(p - out.constData());
+}
+
+void appendInteger(QByteArray& out, int value)
+{
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, qsizetype(result.ptr - digits));
+}
+
+// ==================== LETTURA ====================
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Cursore su un documento JSON UTF-8: ogni metodo avanza solo se il valore e' valido
+class Reader
+{
+public:
+    explicit Reader(QByteArrayView json)
+        : m_p(json.data())
+        , m_end(json.data() + json.size())
+    {
+    }
+
+    char peek()
+    {
+        skipWhitespace();
+        return m_p < m_end ? *m_p : '\0';
+    }
+
+    bool consume(char c)
+    {
+        if (peek() != c) {
+            return false;
+        }
+        ++m_p;
+        return true;
+    }
+
+    bool atEnd()
+    {
+        skipWhitespace();
+        return m_p == m_end;
+    }
+
+    bool atNumber()
+    {
+        const char c = peek();
+        return c == '-' || (c >= '0' && c <= '9');
+    }
+
+    // Contenuto tra le virgolette, ancora con gli escape (escaped = true se ce ne sono)
+    bool readString(QByteArrayView& raw, bool& escaped)
+    {
+        if (!consume('"')) {
+            return false;
+        }
+
+        const char* start = m_p;
+        escaped = false;
+        while (m_p < m_end) {
+            const char c = *m_p;
+            if (c == '"') {
+                raw = QByteArrayView(start, m_p - start);
+                ++m_p;
+                return true;
+            }
+            if (c == '\\') {
+                // Solo gli escape ammessi da JSON, come il parser di QJsonDocument
+                const qsizetype length = m_end - m_p >= 2 && m_p[1] == 'u' ? 6 : 2;
+                if (m_end - m_p < length || !isEscape(m_p + 1, length - 1)) {
+                    return false;
+                }
+                escaped = true;
+                m_p += length;
+                continue;
+            }
+            if (uchar(c) < 0x20) {
+                return false;
+            }
+            ++m_p;
+        }
+        return false;
+    }
+
+    // Come QJsonValue::toInteger(): un numero non intero o fuori intervallo vale 0
+    bool readNumber(qint64& value)
+    {
+        skipWhitespace();
+        const char* start = m_p;
+        if (m_p < m_end && *m_p == '-') {
+            ++m_p;
+        }
+        const char* digits = m_p;
+        skipDigits();
+        if (m_p == digits) {
+            return false;
+        }
+
+        bool integral = true;
+        if (m_p < m_end && *m_p == '.') {
+            integral = false;
+            ++m_p;
+            skipDigits();
+        }
+        if (m_p < m_end && (*m_p == 'e' || *m_p == 'E')) {
+            integral = false;
+            ++m_p;
+            if (m_p < m_end && (*m_p == '+' || *m_p == '-')) {
+                ++m_p;
+            }
+            skipDigits();
+        }
+
+        if (integral) {
+            if (std::from_chars(start, m_p, value).ec != std::errc()) {
+                value = 0;
+            }
+            return true;
+        }
+
+        bool ok = false;
+        const double number = QByteArray(start, m_p - start).toDouble(&ok);
+        // Intero esatto rappresentabile in qint64 (-2^63 <= n < 2^63), come QJsonValue::toInteger()
+        const bool exact = ok && std::floor(number) == number
+            && number >= -9223372036854775808.0 && number < 9223372036854775808.0;
+        value = exact ? qint64(number) : 0;
+        return ok;
+    }
+
+    bool skipValue(int depth = 0)
+    {
+        switch (peek()) {
+        case '"': {
+            QByteArrayView raw;
+            bool escaped = false;
+            return readString(raw, escaped);
+        }
+        case '{':
+        case '[': {
+            const char close = *m_p == '{' ? '}' : ']';
+            if (depth >= MaxDepth) {
+                return false;
+            }
+            ++m_p;
+            if (consume(close)) {
+                return true;
+            }
+            do {
+                if (close == '}') {
+                    QByteArrayView key;
+                    bool escaped = false;
+                    if (!readString(key, escaped) || !consume(':')) {
+                        return false;
+                    }
+                }
+                if (!skipValue(depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(close);
+        }
+        case 't':
+            return literal("true");
+        case 'f':
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default: {
+            qint64 ignored = 0;
+            return readNumber(ignored);
+        }
+        }
+    }
+
+private:
+    static bool isEscape(const char* p, qsizetype length)
+    {
+        if (*p != 'u') {
+            return length == 1 && std::string_view("\"\\/bfnrt").find(*p) != std::string_view::npos;
+        }
+        for (qsizetype i = 1; i < length; ++i) {
+            if (hexValue(p[i]) < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void skipWhitespace()
+    {
+        while (m_p < m_end && (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t')) {
+            ++m_p;
+        }
+    }
+
+    void skipDigits()
+    {
+        while (m_p < m_end && *m_p >= '0' && *m_p <= '9') {
+            ++m_p;
+        }
+    }
+
+    bool literal(std::string_view text)
+    {
+        if (m_end - m_p < qsizetype(text.size()) || std::memcmp(m_p, text.data(), text.size()) != 0) {
+            return false;
+        }
+        m_p += text.size();
+        return true;
+    }
+
+    const char* m_p;
+    const char* m_end;
+};
+
+// Senza escape (il caso normale) una sola conversione UTF-8 -> UTF-16
+QString toText(QByteArrayView raw, bool escaped)
+{
+    if (!escaped) {
+        return QString::fromUtf8(raw);
+    }
+
+    QString text;
+    text.reserve(raw.size());
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    while (p < end) {
+        const char* run = p;
+        while (p < end && *p != '\\') {
+            ++p;
+        }
+        if (p > run) {
+            text += QString::fromUtf8(run, p - run);
+        }
+        if (p == end) {
+            break;
+        }
+
+        ++p; // readString garantisce un escape valido dopo ogni backslash
+        const char c = *p++;
+        switch (c) {
+        case 'n': text += QChar(u'\n'); break;
+        case 'r': text += QChar(u'\r'); break;
+        case 't': text += QChar(u'\t'); break;
+        case 'b': text += QChar(u'\b'); break;
+        case 'f': text += QChar(u'\f'); break;
+        case 'u': {
+            int unit = 0;
+            for (int i = 0; i < 4; ++i) {
+                unit = (unit << 4) | hexValue(p[i]); // readString ha gia' verificato le quattro cifre
+            }
+            text += QChar(char16_t(unit)); // le coppie di surrogati si ricompongono da sole in UTF-16
+            p += 4;
+            break;
+        }
+        default:
+            text += QChar(uchar(c)); // \" \\ \/
+            break;
+        }
+    }
+    return text;
+}
+
+bool readField(Reader& reader, Field field, HomeObject& object, qint64& updatedAt)
+{
+    if (field == Field::LocationId || field == Field::SublocationId || field == Field::UpdatedAt) {
+        // Valori non numerici (null, updatedAt non ancora risolto dal server) restano a 0
+        if (!reader.atNumber()) {
+            return reader.skipValue();
+        }
+
+        qint64 value = 0;
+        if (!reader.readNumber(value)) {
+            return false;
+        }
+
+        const bool fitsInt = value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max();
+        if (field == Field::LocationId) {
+            object.setLocationId(fitsInt ? int(value) : 0);
+        }
+        else if (field == Field::SublocationId) {
+            object.setSublocationId(fitsInt ? int(value) : 0);
+        }
+        else {
+            updatedAt = value;
+        }
+        return true;
+    }
+
+    // Come QJsonValue::toString(): un valore che non e' una stringa vale stringa vuota
+    if (reader.peek() != '"') {
+        return reader.skipValue();
+    }
+
+    QByteArrayView raw;
+    bool escaped = false;
+    if (!reader.readString(raw, escaped)) {
+        return false;
+    }
+
+    switch (field) {
+    case Field::Name: object.setName(toText(raw, escaped)); break;
+    case Field::Color: object.setColor(toText(raw, escaped)); break;
+    case Field::Material: object.setMaterial(toText(raw, escaped)); break;
+    case Field::Type: object.setType(toText(raw, escaped)); break;
+    case Field::Notes: object.setNotes(toText(raw, escaped)); break;
+    case Field::PictureRef: object.setPictureRef(toText(raw, escaped)); break;
+    case Field::Picture:
+        // Formato precedente: il base64 si decodifica dai byte della risposta, senza passare da QString
+        object.setPicture(escaped ? QByteArray::fromBase64(toText(raw, true).toLatin1())
+                                  : QByteArray::fromBase64(QByteArray::fromRawData(raw.data(), raw.size())));
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+} // namespace
+
+void HomeObjectCodec::encode(const HomeObject& object, QByteArray& buffer)
+{
+    buffer += '{';
+
+    bool first = true;
+    for (const FieldSpec& spec : Fields) {
+        if (!isWritten(spec.field, object)) {
+            continue;
+        }
+
+        if (!first) {
+            buffer += ',';
+        }
+        first = false;
+        appendKey(buffer, spec.key);
+
+        switch (spec.field) {
+        case Field::Name: appendString(buffer, object.name()); break;
+        case Field::Color: appendString(buffer, object.color()); break;
+        case Field::Material: appendString(buffer, object.material()); break;
+        case Field::Type: appendString(buffer, object.type()); break;
+        case Field::Notes: appendString(buffer, object.notes()); break;
+        case Field::LocationId: appendInteger(buffer, object.locationId()); break;
+        case Field::SublocationId: appendInteger(buffer, object.sublocationId()); break;
+        case Field::UpdatedAt: buffer.append(ServerTimestamp.data(), qsizetype(ServerTimestamp.size())); break;
+        case Field::PictureRef: appendString(buffer, object.pictureRef()); break;
+        case Field::Picture: break;
+        }
+    }
+
+    buffer += '}';
+}
+
+QByteArray HomeObjectCodec::encode(const HomeObject& object)
+{
+    QByteArray buffer;
+    buffer.reserve(256);
+    encode(object, buffer);
+    return buffer;
+}
+
+bool HomeObjectCodec::decode(QByteArrayView json, HomeObject& object, qint64* updatedAt)
+{
+    Reader reader(json);
+    if (!reader.consume('{')) {
+        return false;
+    }
+
+    HomeObject result;
+    qint64 timestamp = 0;
+
+    if (!reader.consume('}')) {
+        do {
+            QByteArrayView key;
+            bool keyEscaped = false;
+            if (!reader.readString(key, keyEscaped) || !reader.consume(':')) {
+                return false;
+            }
+
+            // Il server non usa escape nelle chiavi, ma una chiave con escape va confrontata gia' decodificata
+            QByteArray unescaped;
+            if (keyEscaped) {
+                unescaped = toText(key, true).toUtf8();
+                key = unescaped;
+            }
+            const FieldSpec* spec = findField(std::string_view(key.data(), size_t(key.size())));
+            const bool valid = spec ? readField(reader, spec->field, result, timestamp) : reader.skipValue();
+            if (!valid) {
+                return false;
+            }
+        } while (reader.consume(','));
+
+        if (!reader.consume('}')) {
+            return false;
+        }
+    }
+
+    if (!reader.atEnd()) {
+        return false;
+    }
+
+    object = std::move(result);
+    if (updatedAt) {
+        *updatedAt = timestamp;
+    }
+    return true;
+}
+
+QJsonObject HomeObjectCodec::toJson(const HomeObject& object)
+{
+    QJsonObject json;
+    for (const FieldSpec& spec : Fields) {
+        if (!isWritten(spec.field, object)) {
+            continue;
+        }
+
+        const QString key = keyOf(spec);
+        switch (spec.field) {
+        case Field::Name: json.insert(key, object.name()); break;
+        case Field::Color: json.insert(key, object.color()); break;
+        case Field::Material: json.insert(key, object.material()); break;
+        case Field::Type: json.insert(key, object.type()); break;
+        case Field::Notes: json.insert(key, object.notes()); break;
+        case Field::LocationId: json.insert(key, object.locationId()); break;
+        case Field::SublocationId: json.insert(key, object.sublocationId()); break;
+        case Field::UpdatedAt: json.insert(key, QJsonObject{ { ".sv", "timestamp" } }); break;
+        case Field::PictureRef: json.insert(key, object.pictureRef()); break;
+        case Field::Picture: break;
+        }
+    }
+    return json;
+}
+
+HomeObject HomeObjectCodec::fromJson(const QJsonObject& json, qint64* updatedAt)
+{
+    HomeObject object;
+    qint64 timestamp = 0;
+
+    for (const FieldSpec& spec : Fields) {
+        auto it = json.constFind(keyOf(spec));
+        if (it == json.constEnd()) {
+            continue;
+        }
+
+        const QJsonValue value = *it;
+        switch (spec.field) {
+        case Field::Name: object.setName(value.toString()); break;
+        case Field::Color: object.setColor(value.toString()); break;
+        case Field::Material: object.setMaterial(value.toString()); break;
+        case Field::Type: object.setType(value.toString()); break;
+        case Field::Notes: object.setNotes(value.toString()); break;
+        case Field::LocationId: object.setLocationId(value.toInt()); break;
+        case Field::SublocationId: object.setSublocationId(value.toInt()); break;
+        case Field::UpdatedAt: timestamp = value.toInteger(); break;
+        case Field::PictureRef: object.setPictureRef(value.toString()); break;
+        case Field::Picture: object.setPicture(QByteArray::fromBase64(value.toString().toLatin1())); break;
+        }
+    }
+
+    if (updatedAt) {
+        *updatedAt = timestamp;
+    }
+    return object;
+}
+
+void HomeObjectCodec::encodeString(QStringView text, QByteArray& buffer)
+{
+    appendString(buffer, text);
+}
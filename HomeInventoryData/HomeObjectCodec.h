@@ -0,0 +1,36 @@
+#pragma once
+#ifndef HOMEOBJECTCODEC_H
+#define HOMEOBJECTCODEC_H
+
+#include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+#include <QStringView>
+
+/**
+ * @brief Formato JSON degli oggetti su Firebase: unica definizione, per scritture e letture
+ * I campi sono descritti da un'unica tabella (chiave JSON -> campo): la scrittura accoda
+ * UTF-8 al buffer del chiamante, la lettura e' una sola passata sui byte senza DOM
+ * toJson/fromJson servono a chi ha gia' un QJsonObject (eventi realtime, risposte delle query)
+ */
+class HOMEINVENTORYDATA_EXPORT HomeObjectCodec
+{
+public:
+    // Accoda l'oggetto a buffer: per riusarne la capacita' svuotarlo con truncate(0), non clear()
+    static void encode(const HomeObject& object, QByteArray& buffer);
+    static QByteArray encode(const HomeObject& object);
+
+    // false se json non e' un oggetto JSON valido; i campi assenti o di tipo diverso restano vuoti
+    static bool decode(QByteArrayView json, HomeObject& object, qint64* updatedAt = nullptr);
+
+    // Stessa tabella, sul DOM
+    static QJsonObject toJson(const HomeObject& object);
+    static HomeObject fromJson(const QJsonObject& json, qint64* updatedAt = nullptr);
+
+    // Stringa JSON (virgolette ed escape) accodata a buffer, ad es. per le chiavi di una PATCH
+    static void encodeString(QStringView text, QByteArray& buffer);
+};
+
+#endif // HOMEOBJECTCODEC_H
@@ -3,12 +3,12 @@
 #define IDATABASEMANAGER_H
 
 #include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include "ObjectMutation.h"
 #include <QString>
 #include <QList>
 #include <QVariantMap>
-
-// Forward declaration
-class HomeObject;
+#include <QFuture>
 
 /**
  * @brief Interface astratta per la gestione del database
@@ -31,9 +31,30 @@ public:
     virtual bool updateObject(const QString& oldName, const HomeObject& newObject) = 0;
     virtual bool deleteObject(const QString& objectName) = 0;
 
+    // Batch Operations
+    // L'implementazione di default esegue le mutazioni una alla volta, nell'ordine dato
+    virtual bool applyBatch(const QList<ObjectMutation>& mutations)
+    {
+        for (const ObjectMutation& mutation : mutations) {
+            bool success = false;
+            switch (mutation.type) {
+            case ObjectMutation::Type::Create: success = createObject(mutation.object); break;
+            case ObjectMutation::Type::Update: success = updateObject(mutation.oldName, mutation.object); break;
+            case ObjectMutation::Type::Delete: success = deleteObject(mutation.oldName); break;
+            }
+            if (!success) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     // Search Operations
     virtual QList<HomeObject> searchObjects(const QVariantMap& filters) = 0;
 
+    // Picture Operations (le foto non viaggiano con gli oggetti, si caricano solo se visualizzate)
+    virtual QByteArray getPicture(const QString& pictureRef) = 0;
+
     // Attribute Operations
     virtual QStringList getColors() = 0;
     virtual QStringList getMaterials() = 0;
@@ -47,6 +68,32 @@ public:
     virtual bool removeMaterial(const QString& material) = 0;
     virtual bool removeType(const QString& type) = 0;
 
+    // Async Operations
+    // L'implementazione di default incapsula la chiamata bloccante in un future gia' completato:
+    // i backend di rete le ridefiniscono per non bloccare mai il chiamante.
+    virtual QFuture<bool> createObjectAsync(const HomeObject& object) { return QtFuture::makeReadyValueFuture(createObject(object)); }
+    virtual QFuture<QList<HomeObject>> getObjectsAsync(int locationId, int sublocationId) { return QtFuture::makeReadyValueFuture(getObjects(locationId, sublocationId)); }
+    virtual QFuture<QList<HomeObject>> getAllObjectsAsync() { return QtFuture::makeReadyValueFuture(getAllObjects()); }
+    virtual QFuture<bool> updateObjectAsync(const QString& oldName, const HomeObject& newObject) { return QtFuture::makeReadyValueFuture(updateObject(oldName, newObject)); }
+    virtual QFuture<bool> deleteObjectAsync(const QString& objectName) { return QtFuture::makeReadyValueFuture(deleteObject(objectName)); }
+    virtual QFuture<bool> applyBatchAsync(const QList<ObjectMutation>& mutations) { return QtFuture::makeReadyValueFuture(applyBatch(mutations)); }
+
+    virtual QFuture<QList<HomeObject>> searchObjectsAsync(const QVariantMap& filters) { return QtFuture::makeReadyValueFuture(searchObjects(filters)); }
+
+    virtual QFuture<QByteArray> getPictureAsync(const QString& pictureRef) { return QtFuture::makeReadyValueFuture(getPicture(pictureRef)); }
+
+    virtual QFuture<QStringList> getColorsAsync() { return QtFuture::makeReadyValueFuture(getColors()); }
+    virtual QFuture<QStringList> getMaterialsAsync() { return QtFuture::makeReadyValueFuture(getMaterials()); }
+    virtual QFuture<QStringList> getTypesAsync() { return QtFuture::makeReadyValueFuture(getTypes()); }
+
+    virtual QFuture<bool> addColorAsync(const QString& color) { return QtFuture::makeReadyValueFuture(addColor(color)); }
+    virtual QFuture<bool> addMaterialAsync(const QString& material) { return QtFuture::makeReadyValueFuture(addMaterial(material)); }
+    virtual QFuture<bool> addTypeAsync(const QString& type) { return QtFuture::makeReadyValueFuture(addType(type)); }
+
+    virtual QFuture<bool> removeColorAsync(const QString& color) { return QtFuture::makeReadyValueFuture(removeColor(color)); }
+    virtual QFuture<bool> removeMaterialAsync(const QString& material) { return QtFuture::makeReadyValueFuture(removeMaterial(material)); }
+    virtual QFuture<bool> removeTypeAsync(const QString& type) { return QtFuture::makeReadyValueFuture(removeType(type)); }
+
     // Error handling
     virtual QString lastError() const = 0;
 };
@@ -0,0 +1,243 @@
+#include "JsonStreamParser.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+
+JsonStreamParser::JsonStreamParser(MemberHandler handler)
+    : m_handler(std::move(handler))
+{
+    reset();
+}
+
+void JsonStreamParser::reset()
+{
+    m_state = State::Start;
+    m_key.clear();
+    m_value.clear();
+    m_depth = 0;
+    m_literalPos = 0;
+    m_membersParsed = 0;
+    m_inString = false;
+    m_escape = false;
+    m_keyEscaped = false;
+    m_error.clear();
+}
+
+void JsonStreamParser::feed(const QByteArray& chunk)
+{
+    const char* data = chunk.constData();
+    const qsizetype size = chunk.size();
+
+    for (qsizetype i = 0; i < size && m_state != State::Error; ++i) {
+        const char c = data[i];
+
+        switch (m_state) {
+        case State::Start:
+            if (isWhitespace(c)) {
+                break;
+            }
+            if (c == '{') {
+                m_state = State::ExpectKey;
+            }
+            else if (c == 'n') {
+                m_state = State::NullLiteral;
+                m_literalPos = 1;
+            }
+            else {
+                fail("Expected a JSON object");
+            }
+            break;
+
+        case State::NullLiteral:
+            if (c != "null"[m_literalPos]) {
+                fail("Invalid literal");
+            }
+            else if (++m_literalPos == 4) {
+                m_state = State::Done;
+            }
+            break;
+
+        case State::ExpectKey:
+            if (isWhitespace(c)) {
+                break;
+            }
+            if (c == '"') {
+                m_key.clear();
+                m_keyEscaped = false;
+                m_escape = false;
+                m_state = State::InKey;
+            }
+            else if (c == '}' && m_membersParsed == 0) {
+                m_state = State::Done; // oggetto vuoto
+            }
+            else {
+                fail("Expected a key");
+            }
+            break;
+
+        case State::InKey:
+            if (m_escape) {
+                m_escape = false;
+            }
+            else if (c == '\\') {
+                m_escape = true;
+                m_keyEscaped = true;
+            }
+            else if (c == '"') {
+                m_state = State::ExpectColon;
+                break;
+            }
+            m_key.append(c);
+            break;
+
+        case State::ExpectColon:
+            if (isWhitespace(c)) {
+                break;
+            }
+            if (c == ':') {
+                m_state = State::ExpectValue;
+            }
+            else {
+                fail("Expected ':'");
+            }
+            break;
+
+        case State::ExpectValue:
+            if (isWhitespace(c)) {
+                break;
+            }
+            m_value.clear();
+            m_depth = 0;
+            m_inString = false;
+            m_escape = false;
+            m_state = State::InValue;
+            processValueByte(c);
+            break;
+
+        case State::InValue:
+            processValueByte(c);
+            break;
+
+        case State::AfterValue:
+            if (isWhitespace(c)) {
+                break;
+            }
+            if (c == ',') {
+                m_state = State::ExpectKey;
+            }
+            else if (c == '}') {
+                m_state = State::Done;
+            }
+            else {
+                fail("Expected ',' or '}'");
+            }
+            break;
+
+        case State::Done:
+            if (!isWhitespace(c)) {
+                fail("Unexpected data after the end of the document");
+            }
+            break;
+
+        case State::Error:
+            break;
+        }
+    }
+}
+
+void JsonStreamParser::processValueByte(char c)
+{
+    if (m_inString) {
+        m_value.append(c);
+        if (m_escape) {
+            m_escape = false;
+        }
+        else if (c == '\\') {
+            m_escape = true;
+        }
+        else if (c == '"') {
+            m_inString = false;
+        }
+        return;
+    }
+
+    switch (c) {
+    case '"':
+        m_inString = true;
+        m_value.append(c);
+        return;
+
+    case '{':
+    case '[':
+        ++m_depth;
+        m_value.append(c);
+        return;
+
+    case '}':
+    case ']':
+        if (m_depth == 0) {
+            if (c == ']') {
+                fail("Unbalanced ']'");
+                return;
+            }
+            // Fine dell'oggetto di primo livello dopo un valore scalare
+            emitMember();
+            m_state = State::Done;
+            return;
+        }
+        m_value.append(c);
+        if (--m_depth == 0) {
+            emitMember();
+            m_state = State::AfterValue;
+        }
+        return;
+
+    case ',':
+        if (m_depth == 0) {
+            emitMember();
+            m_state = State::ExpectKey;
+            return;
+        }
+        m_value.append(c);
+        return;
+
+    default:
+        if (m_depth == 0 && isWhitespace(c)) {
+            return; // spazi dopo un valore scalare
+        }
+        m_value.append(c);
+        return;
+    }
+}
+
+void JsonStreamParser::emitMember()
+{
+    QString key;
+    if (m_keyEscaped) {
+        // Chiave con sequenze di escape: lascia la decodifica a QJsonDocument
+        key = QJsonDocument::fromJson("[\"" + m_key + "\"]").array().at(0).toString();
+    }
+    else {
+        key = QString::fromUtf8(m_key);
+    }
+
+    ++m_membersParsed;
+    m_handler(key, m_value);
+    m_value.clear();
+}
+
+bool JsonStreamParser::finish()
+{
+    if (m_state == State::Done) {
+        return true;
+    }
+    if (m_state != State::Error) {
+        fail("Unexpected end of document");
+    }
+    return false;
+}
+
+void JsonStreamParser::fail(const QString& error)
+{
+    m_state = State::Error;
+    m_error = error;
+}
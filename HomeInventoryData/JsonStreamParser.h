@@ -0,0 +1,63 @@
+#pragma once
+#ifndef JSONSTREAMPARSER_H
+#define JSONSTREAMPARSER_H
+
+#include "homeinventorydata_global.h"
+#include <QString>
+#include <QByteArray>
+#include <functional>
+
+/**
+ * @brief Parser incrementale per documenti JSON del tipo { "chiave": valore, ... }
+ * Riceve i dati a blocchi (es. da QNetworkReply::readyRead) e notifica ogni membro
+ * di primo livello appena il suo valore e' completo. In memoria resta solo il membro corrente.
+ */
+class HOMEINVENTORYDATA_EXPORT JsonStreamParser
+{
+public:
+    using MemberHandler = std::function<void(const QString& key, const QByteArray& value)>;
+
+    explicit JsonStreamParser(MemberHandler handler);
+
+    void feed(const QByteArray& chunk);
+    bool finish(); // true se il documento e' completo e valido
+    void reset();
+
+    bool hasError() const { return m_state == State::Error; }
+    QString errorString() const { return m_error; }
+    int membersParsed() const { return m_membersParsed; }
+
+private:
+    enum class State
+    {
+        Start,
+        NullLiteral, // risposta "null" di Firebase: nodo vuoto
+        ExpectKey,
+        InKey,
+        ExpectColon,
+        ExpectValue,
+        InValue,
+        AfterValue,
+        Done,
+        Error
+    };
+
+    MemberHandler m_handler;
+    State m_state;
+    QByteArray m_key;
+    QByteArray m_value;
+    int m_depth;
+    int m_literalPos;
+    int m_membersParsed;
+    bool m_inString;
+    bool m_escape;
+    bool m_keyEscaped;
+    QString m_error;
+
+    void processValueByte(char c);
+    void emitMember();
+    void fail(const QString& error);
+    static bool isWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+};
+
+#endif // JSONSTREAMPARSER_H
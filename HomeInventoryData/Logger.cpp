@@ -0,0 +1,336 @@
+#include "Logger.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const int DrainIntervalMs = 50; // il thread di scrittura si sveglia almeno ogni 50 ms
+
+/**
+ * @brief Coda circolare bounded a piu' produttori e un consumatore (schema di Vyukov)
+ * Ogni slot ha un numero di sequenza che dice se e' libero per il prossimo giro
+ * o pronto per essere letto: i produttori si contendono solo m_enqueuePos
+ */
+class LogRing
+{
+public:
+    static constexpr size_t Capacity = 2048; // potenza di 2
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        const char* category;
+        qint64 timestampMs;
+        int length;
+        char text[LogLine::MaxLength];
+    };
+
+    LogRing()
+    {
+        for (size_t i = 0; i < Capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(LogLevel level, const char* category, const char* text, int length)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;) {
+            slot = &m_slots[pos & (Capacity - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false; // pieno
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->level = level;
+        slot->category = category;
+        slot->timestampMs = QDateTime::currentMSecsSinceEpoch();
+        slot->length = length;
+        std::memcpy(slot->text, text, size_t(length));
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Solo il consumatore (protetto da m_drainMutex nel backend)
+    template <typename Visitor>
+    int drain(Visitor&& visit)
+    {
+        int count = 0;
+        for (;;) {
+            Slot& slot = m_slots[m_dequeuePos & (Capacity - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+                return count;
+            }
+            visit(slot);
+            slot.sequence.store(m_dequeuePos + Capacity, std::memory_order_release);
+            ++m_dequeuePos;
+            ++count;
+        }
+    }
+
+    qint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::array<Slot, Capacity> m_slots;
+    alignas(64) std::atomic<size_t> m_enqueuePos{ 0 };
+    alignas(64) size_t m_dequeuePos = 0;
+    std::atomic<qint64> m_dropped{ 0 };
+};
+
+const char* levelName(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::Trace:   return "TRACE";
+    case LogLevel::Debug:   return "DEBUG";
+    case LogLevel::Info:    return "INFO ";
+    case LogLevel::Warning: return "WARN ";
+    case LogLevel::Error:   return "ERROR";
+    default:                return "     ";
+    }
+}
+
+/**
+ * @brief Ring buffer + thread di scrittura, avviato al primo messaggio
+ */
+class LogBackend
+{
+public:
+    static LogBackend& instance()
+    {
+        static LogBackend backend;
+        return backend;
+    }
+
+    ~LogBackend()
+    {
+        stop();
+    }
+
+    void push(LogLevel level, const char* category, const char* text, int length)
+    {
+        ensureStarted();
+        m_ring.push(level, category, text, length);
+
+        // Avvisi ed errori escono subito, il resto al prossimo giro del thread
+        if (level >= LogLevel::Warning) {
+            m_wakeUp.notify_one();
+        }
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(m_drainMutex);
+        drainLocked();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_running = false;
+        }
+        m_wakeUp.notify_one();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        flush(); // da qui in poi i messaggi restano in coda fino al prossimo flush()
+    }
+
+    qint64 dropped() const { return m_ring.dropped(); }
+
+private:
+    void ensureStarted()
+    {
+        if (m_started.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        if (m_started.load(std::memory_order_relaxed)) {
+            return;
+        }
+        m_running = true;
+        m_thread = std::thread([this]() { run(); });
+        m_started.store(true, std::memory_order_release);
+
+        // Con una QCoreApplication il thread si ferma insieme a lei, prima dello scaricamento della DLL
+        if (QCoreApplication::instance()) {
+            qAddPostRoutine([]() { LogBackend::instance().stop(); });
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        while (m_running) {
+            m_wakeUp.wait_for(lock, std::chrono::milliseconds(DrainIntervalMs));
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    void drainLocked()
+    {
+        // Formattazione di data e livello solo qui, fuori dal percorso di chi logga
+        m_batch.clear();
+        const int count = m_ring.drain([this](const LogRing::Slot& slot) {
+            m_batch += QDateTime::fromMSecsSinceEpoch(slot.timestampMs).toString("HH:mm:ss.zzz").toLatin1();
+            m_batch += ' ';
+            m_batch += levelName(slot.level);
+            m_batch += ' ';
+            m_batch += slot.category;
+            m_batch += ": ";
+            m_batch.append(slot.text, slot.length);
+            m_batch += '\n';
+        });
+
+        const qint64 dropped = m_ring.dropped();
+        if (dropped != m_reportedDropped) {
+            m_batch += "-- " + QByteArray::number(dropped - m_reportedDropped) + " log messages dropped --\n";
+            m_reportedDropped = dropped;
+        }
+
+        if (count > 0 || !m_batch.isEmpty()) {
+            std::fwrite(m_batch.constData(), 1, size_t(m_batch.size()), stdout);
+            std::fflush(stdout);
+        }
+    }
+
+    LogRing m_ring;
+    std::mutex m_drainMutex;  // un solo consumatore alla volta (thread o flush esplicito)
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeUp;
+    std::thread m_thread;
+    std::atomic<bool> m_started{ false };
+    bool m_running = false;
+    QByteArray m_batch;
+    qint64 m_reportedDropped = 0;
+};
+
+} // namespace
+
+// ==================== Logger ====================
+
+std::atomic<int> Logger::s_level{ int(LogLevel::Info) };
+
+void Logger::flush()
+{
+    LogBackend::instance().flush();
+}
+
+qint64 Logger::droppedCount()
+{
+    return LogBackend::instance().dropped();
+}
+
+// ==================== LogLine ====================
+
+LogLine::LogLine(LogLevel level, const char* category)
+    : m_level(level)
+    , m_category(category)
+    , m_length(0)
+{
+}
+
+LogLine::~LogLine()
+{
+    LogBackend::instance().push(m_level, m_category, m_text, m_length);
+}
+
+void LogLine::append(const char* text, int length)
+{
+    const int available = MaxLength - m_length;
+    const int copied = length < available ? length : available;
+    if (copied > 0) {
+        std::memcpy(m_text + m_length, text, size_t(copied));
+        m_length += copied;
+    }
+}
+
+LogLine& LogLine::operator<<(const char* text)
+{
+    if (text) {
+        append(text, int(std::strlen(text)));
+    }
+    return *this;
+}
+
+LogLine& LogLine::operator<<(const std::string& text)
+{
+    append(text.data(), int(text.size()));
+    return *this;
+}
+
+LogLine& LogLine::operator<<(const QString& text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    append(utf8.constData(), int(utf8.size()));
+    return *this;
+}
+
+LogLine& LogLine::operator<<(const QByteArray& text)
+{
+    append(text.constData(), int(text.size()));
+    return *this;
+}
+
+LogLine& LogLine::operator<<(char c)
+{
+    append(&c, 1);
+    return *this;
+}
+
+LogLine& LogLine::operator<<(bool value)
+{
+    return *this << (value ? "true" : "false");
+}
+
+LogLine& LogLine::operator<<(double value)
+{
+    char buffer[32];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    append(buffer, length);
+    return *this;
+}
+
+void LogLine::appendSigned(long long value)
+{
+    if (value < 0) {
+        append("-", 1);
+        appendUnsigned(0ULL - static_cast<unsigned long long>(value));
+        return;
+    }
+    appendUnsigned(static_cast<unsigned long long>(value));
+}
+
+void LogLine::appendUnsigned(unsigned long long value)
+{
+    char buffer[24];
+    int pos = sizeof(buffer);
+    do {
+        buffer[--pos] = char('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    append(buffer + pos, int(sizeof(buffer)) - pos);
+}
@@ -0,0 +1,112 @@
+#pragma once
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "homeinventorydata_global.h"
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+// Livello minimo compilato: i log sotto questa soglia spariscono dal binario
+// (0 = Trace, 1 = Debug, 2 = Info, 3 = Warning, 4 = Error)
+#ifndef HOMEINVENTORY_LOG_MIN_LEVEL
+# ifdef NDEBUG
+#  define HOMEINVENTORY_LOG_MIN_LEVEL 2
+# else
+#  define HOMEINVENTORY_LOG_MIN_LEVEL 0
+# endif
+#endif
+
+enum class LogLevel : int
+{
+    Trace = 0,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+/**
+ * @brief Logger asincrono a livelli
+ * I messaggi vengono formattati solo se il livello e' attivo, copiati in un ring buffer
+ * lock-free e scritti su stdout da un thread in background: chi logga non fa mai I/O
+ * Se il buffer e' pieno il messaggio viene scartato (e contato), mai atteso
+ */
+class HOMEINVENTORYDATA_EXPORT Logger
+{
+public:
+    static LogLevel level() { return LogLevel(s_level.load(std::memory_order_relaxed)); }
+    static void setLevel(LogLevel level) { s_level.store(int(level), std::memory_order_relaxed); }
+    static bool isEnabled(LogLevel level) { return int(level) >= s_level.load(std::memory_order_relaxed); }
+
+    static void flush();          // scrive subito tutto cio' che e' in coda
+    static qint64 droppedCount(); // messaggi persi per buffer pieno
+
+private:
+    static std::atomic<int> s_level;
+};
+
+/**
+ * @brief Una riga di log in costruzione, accodata alla distruzione
+ * Il testo vive in un buffer fisso sullo stack: niente allocazioni per i tipi semplici
+ */
+class HOMEINVENTORYDATA_EXPORT LogLine
+{
+public:
+    static constexpr int MaxLength = 240; // oltre viene troncato
+
+    LogLine(LogLevel level, const char* category);
+    ~LogLine();
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    LogLine& operator<<(const char* text);
+    LogLine& operator<<(const std::string& text);
+    LogLine& operator<<(const QString& text);
+    LogLine& operator<<(const QByteArray& text);
+    LogLine& operator<<(char c);
+    LogLine& operator<<(bool value);
+    LogLine& operator<<(double value);
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    LogLine& operator<<(T value)
+    {
+        if constexpr (std::is_signed_v<T>) {
+            appendSigned(value);
+        }
+        else {
+            appendUnsigned(value);
+        }
+        return *this;
+    }
+
+private:
+    void append(const char* text, int length);
+    void appendSigned(long long value);
+    void appendUnsigned(unsigned long long value);
+
+    LogLevel m_level;
+    const char* m_category;
+    int m_length;
+    char m_text[MaxLength];
+};
+
+// Argomenti valutati solo se il livello e' attivo: LOG_INFO("firebase", "Retrieved " << count << " objects")
+#define HOMEINVENTORY_LOG(level, category, message)                                     \
+    do {                                                                                \
+        if (int(level) >= HOMEINVENTORY_LOG_MIN_LEVEL && Logger::isEnabled(level)) {    \
+            LogLine logLine_(level, category);                                          \
+            logLine_ << message;                                                        \
+        }                                                                               \
+    } while (0)
+
+#define LOG_TRACE(category, message)   HOMEINVENTORY_LOG(LogLevel::Trace, category, message)
+#define LOG_DEBUG(category, message)   HOMEINVENTORY_LOG(LogLevel::Debug, category, message)
+#define LOG_INFO(category, message)    HOMEINVENTORY_LOG(LogLevel::Info, category, message)
+#define LOG_WARNING(category, message) HOMEINVENTORY_LOG(LogLevel::Warning, category, message)
+#define LOG_ERROR(category, message)   HOMEINVENTORY_LOG(LogLevel::Error, category, message)
+
+#endif // LOGGER_H
@@ -0,0 +1,88 @@
+#include "ObjectBitmap.h"
+#include <algorithm>
+
+ObjectBitmap::ObjectBitmap(int size)
+{
+    resize(size);
+}
+
+void ObjectBitmap::resize(int size)
+{
+    m_size = qMax(0, size);
+    m_words.resize((m_size + 63) / 64, 0);
+
+    // Le righe tagliate non devono ricomparire con un resize successivo
+    if (m_size % 64 && !m_words.isEmpty()) {
+        m_words.last() &= (quint64(1) << (m_size % 64)) - 1;
+    }
+}
+
+void ObjectBitmap::clear()
+{
+    m_words.clear();
+    m_size = 0;
+}
+
+void ObjectBitmap::set(int row)
+{
+    if (row >= m_size) {
+        resize(row + 1);
+    }
+    m_words[row / 64] |= quint64(1) << (row % 64);
+}
+
+void ObjectBitmap::reset(int row)
+{
+    if (row < m_size) {
+        m_words[row / 64] &= ~(quint64(1) << (row % 64));
+    }
+}
+
+bool ObjectBitmap::test(int row) const
+{
+    return row >= 0 && row < m_size && (m_words.at(row / 64) >> (row % 64)) & 1;
+}
+
+bool ObjectBitmap::isEmpty() const
+{
+    return std::all_of(m_words.cbegin(), m_words.cend(), [](quint64 word) { return word == 0; });
+}
+
+int ObjectBitmap::count() const
+{
+    int total = 0;
+    for (quint64 word : m_words) {
+        total += qPopulationCount(word);
+    }
+    return total;
+}
+
+ObjectBitmap& ObjectBitmap::operator&=(const ObjectBitmap& other)
+{
+    const int common = qMin(m_words.size(), other.m_words.size());
+    for (int w = 0; w < common; ++w) {
+        m_words[w] &= other.m_words.at(w);
+    }
+    std::fill(m_words.begin() + common, m_words.end(), 0);
+    return *this;
+}
+
+ObjectBitmap& ObjectBitmap::operator|=(const ObjectBitmap& other)
+{
+    if (other.m_size > m_size) {
+        resize(other.m_size);
+    }
+    for (int w = 0; w < other.m_words.size(); ++w) {
+        m_words[w] |= other.m_words.at(w);
+    }
+    return *this;
+}
+
+ObjectBitmap& ObjectBitmap::subtract(const ObjectBitmap& other)
+{
+    const int common = qMin(m_words.size(), other.m_words.size());
+    for (int w = 0; w < common; ++w) {
+        m_words[w] &= ~other.m_words.at(w);
+    }
+    return *this;
+}
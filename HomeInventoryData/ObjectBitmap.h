@@ -0,0 +1,61 @@
+#pragma once
+#ifndef OBJECTBITMAP_H
+#define OBJECTBITMAP_H
+
+#include "homeinventorydata_global.h"
+#include <QList>
+#include <QtGlobal>
+
+/**
+ * @brief Insieme di righe (indici di oggetto) rappresentato come bitmap densa
+ * Usato per le selezioni di ObjectTable e dall'indice dei trigrammi: intersezioni e unioni
+ * lavorano 64 righe alla volta
+ */
+class HOMEINVENTORYDATA_EXPORT ObjectBitmap
+{
+public:
+    ObjectBitmap() = default;
+    explicit ObjectBitmap(int size);
+
+    int size() const { return m_size; } // numero di righe rappresentabili
+    void resize(int size);
+    void clear();
+
+    void set(int row);
+    void reset(int row);
+    bool test(int row) const;
+
+    bool isEmpty() const;
+    int count() const;
+
+    // Operazioni tra insiemi: le righe oltre la dimensione di una bitmap valgono 0
+    ObjectBitmap& operator&=(const ObjectBitmap& other);
+    ObjectBitmap& operator|=(const ObjectBitmap& other);
+    ObjectBitmap& subtract(const ObjectBitmap& other);
+
+    // Accesso a blocchi di 64 righe, per i kernel che producono una selezione (vedi ObjectTable)
+    int wordCount() const { return int(m_words.size()); }
+    quint64 word(int index) const { return m_words.at(index); }
+    void setWord(int index, quint64 word) { m_words[index] = word; }
+    quint64* words() { return m_words.data(); }
+    const quint64* words() const { return m_words.constData(); }
+
+    // Visita le righe presenti in ordine crescente
+    template <typename Visitor>
+    void forEach(Visitor visit) const
+    {
+        for (int w = 0; w < m_words.size(); ++w) {
+            quint64 word = m_words.at(w);
+            while (word) {
+                visit(w * 64 + int(qCountTrailingZeroBits(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    QList<quint64> m_words;
+    int m_size = 0;
+};
+
+#endif // OBJECTBITMAP_H
@@ -0,0 +1,207 @@
+#include "ObjectCache.h"
+#include <QtGlobal>
+#include <QStringList>
+
+ObjectCache::ObjectCache(qint64 maxAgeMs)
+    : m_maxAgeMs(maxAgeMs)
+    , m_watermark(0)
+    , m_revision(0)
+    , m_complete(false)
+{
+}
+
+bool ObjectCache::isComplete() const
+{
+    return m_complete;
+}
+
+bool ObjectCache::isStale() const
+{
+    return !m_complete || !m_lastSync.isValid() || m_lastSync.elapsed() > m_maxAgeMs;
+}
+
+void ObjectCache::replaceAll(const QList<HomeObject>& objects, qint64 watermark)
+{
+    m_rows.clear();
+    m_rowByName.clear();
+    m_freeRows.clear();
+    m_textIndex.clear();
+    m_table.clear();
+    m_rows.reserve(objects.size());
+    m_table.reserve(int(objects.size()));
+    m_rowByName.reserve(objects.size());
+
+    for (const HomeObject& obj : objects) {
+        insert(obj);
+    }
+
+    m_complete = true;
+    m_watermark = 0;
+    ++m_revision;
+    markSynced(watermark);
+}
+
+void ObjectCache::restore(const QList<HomeObject>& objects, qint64 watermark)
+{
+    replaceAll(objects, watermark);
+
+    // Mai sincronizzata in questa sessione: la prima lettura fa solo la sincronizzazione delta
+    m_lastSync.invalidate();
+}
+
+void ObjectCache::markSynced(qint64 watermark)
+{
+    m_watermark = qMax(m_watermark, watermark);
+    m_lastSync.start();
+}
+
+void ObjectCache::retainOnly(const QSet<QString>& names)
+{
+    QStringList removed;
+    for (auto it = m_rowByName.cbegin(); it != m_rowByName.cend(); ++it) {
+        if (!names.contains(it.key())) {
+            removed.append(it.key());
+        }
+    }
+
+    for (const QString& name : removed) {
+        remove(name);
+    }
+}
+
+void ObjectCache::invalidate()
+{
+    m_complete = false;
+    m_lastSync.invalidate();
+}
+
+void ObjectCache::clear()
+{
+    m_rows.clear();
+    m_rowByName.clear();
+    m_freeRows.clear();
+    m_textIndex.clear();
+    m_table.clear();
+    m_watermark = 0;
+    ++m_revision;
+    invalidate();
+}
+
+void ObjectCache::insert(const HomeObject& object)
+{
+    HomeObject stored = object;
+
+    // Le foto con riferimento vivono nel picture store, non nella cache degli oggetti
+    if (!stored.pictureRef().isEmpty() && !stored.picture().isEmpty()) {
+        stored.setPicture(QByteArray());
+    }
+
+    int row = m_rowByName.value(stored.name(), -1);
+    if (row >= 0) {
+        m_textIndex.remove(row);
+        m_rows[row] = stored;
+    }
+    else if (!m_freeRows.isEmpty()) {
+        row = m_freeRows.takeLast();
+        m_rows[row] = stored;
+    }
+    else {
+        row = m_rows.size();
+        m_rows.append(stored);
+    }
+
+    m_rowByName.insert(stored.name(), row);
+    m_textIndex.insert(row, stored);
+    m_table.set(row, stored);
+    ++m_revision;
+}
+
+void ObjectCache::remove(const QString& name)
+{
+    const int row = m_rowByName.value(name, -1);
+    if (row < 0) {
+        return;
+    }
+
+    m_textIndex.remove(row);
+    m_table.erase(row);
+    m_rows[row] = HomeObject();
+    m_rowByName.remove(name);
+    m_freeRows.append(row);
+    ++m_revision;
+}
+
+bool ObjectCache::contains(const QString& name) const
+{
+    return m_rowByName.contains(name);
+}
+
+HomeObject ObjectCache::value(const QString& name) const
+{
+    const int row = m_rowByName.value(name, -1);
+    return row >= 0 ? m_rows.at(row) : HomeObject();
+}
+
+QList<HomeObject> ObjectCache::objectsAt(const ObjectBitmap& rows) const
+{
+    QList<HomeObject> result;
+    result.reserve(rows.count());
+    rows.forEach([this, &result](int row) {
+        result.append(m_rows.at(row));
+    });
+    return result;
+}
+
+QList<HomeObject> ObjectCache::objects() const
+{
+    return objectsAt(m_table.live());
+}
+
+QList<HomeObject> ObjectCache::objects(int locationId, int sublocationId) const
+{
+    return objectsAt(m_table.selectRoom(locationId, sublocationId));
+}
+
+QList<HomeObject> ObjectCache::search(const SearchFilter& filter) const
+{
+    // Posizione e attributi con i kernel sulle colonne, il nome con l'indice dei trigrammi
+    ObjectBitmap rows = m_table.select(filter);
+
+    if (!filter.name().isEmpty() && !rows.isEmpty()) {
+        if (filter.foldedName().isEmpty()) {
+            // Nessun trigramma da cercare: il nome si verifica sui candidati rimasti
+            ObjectBitmap named(rows.size());
+            rows.forEach([this, &filter, &named](int row) {
+                if (filter.matchesName(m_rows.at(row))) {
+                    named.set(row);
+                }
+            });
+            rows = named;
+        }
+        else {
+            rows &= m_textIndex.substring(filter.name());
+        }
+    }
+
+    return objectsAt(rows);
+}
+
+QList<HomeObject> ObjectCache::suggest(const QString& text, int maxDistance, int limit) const
+{
+    QList<HomeObject> result;
+
+    const QList<TrigramIndex::Match> matches = m_textIndex.fuzzy(text, maxDistance, TrigramIndex::AllFields);
+    for (const TrigramIndex::Match& match : matches) {
+        if (result.size() >= limit) {
+            break;
+        }
+        result.append(m_rows.at(match.row));
+    }
+
+    return result;
+}
+
+QList<ObjectTable::RoomCount> ObjectCache::countByRoom() const
+{
+    return m_table.countByRoom();
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef OBJECTCACHE_H
+#define OBJECTCACHE_H
+
+#include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include "SearchFilter.h"
+#include "TrigramIndex.h"
+#include "ObjectTable.h"
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+
+/**
+ * @brief Cache in memoria degli HomeObject, indicizzata per nome
+ * Le operazioni di create/update/delete la aggiornano direttamente (write-through),
+ * il server viene interrogato solo quando la cache e' obsoleta
+ * Ogni oggetto occupa una riga stabile, referenziata dall'indice di ricerca
+ */
+class HOMEINVENTORYDATA_EXPORT ObjectCache
+{
+public:
+    explicit ObjectCache(qint64 maxAgeMs = 60000);
+
+    // State
+    bool isComplete() const; // true dopo il primo caricamento completo
+    bool isStale() const;    // true se incompleta o piu' vecchia di maxAge
+    qint64 maxAge() const { return m_maxAgeMs; }
+    void setMaxAge(qint64 msecs) { m_maxAgeMs = msecs; }
+    qint64 syncWatermark() const { return m_watermark; } // updatedAt piu' recente ricevuto dal server
+    int size() const { return m_rowByName.size(); }
+    quint64 revision() const { return m_revision; } // cambia a ogni modifica del contenuto
+
+    // Synchronization
+    void replaceAll(const QList<HomeObject>& objects, qint64 watermark);
+    void restore(const QList<HomeObject>& objects, qint64 watermark); // da snapshot: completa ma da riconciliare
+    void markSynced(qint64 watermark);
+    void retainOnly(const QSet<QString>& names);
+    void invalidate(); // Forza un ricaricamento completo alla prossima lettura
+    void clear();
+
+    // Write-through
+    void insert(const HomeObject& object);
+    void remove(const QString& name);
+
+    // Reads
+    bool contains(const QString& name) const;
+    HomeObject value(const QString& name) const;
+    QList<HomeObject> objects() const;
+    QList<HomeObject> objects(int locationId, int sublocationId) const;
+    QList<HomeObject> search(const SearchFilter& filter) const;
+    QList<HomeObject> suggest(const QString& text, int maxDistance, int limit) const; // type-ahead, ordinati per distanza
+    QList<ObjectTable::RoomCount> countByRoom() const;
+    const ObjectTable& table() const { return m_table; } // vista colonnare, stesse righe della cache
+
+private:
+    QList<HomeObject> objectsAt(const ObjectBitmap& rows) const;
+
+    QList<HomeObject> m_rows;        // riga -> oggetto (vuoto se la riga e' libera)
+    QHash<QString, int> m_rowByName;
+    QList<int> m_freeRows;
+    TrigramIndex m_textIndex;
+    ObjectTable m_table;
+    QElapsedTimer m_lastSync;
+    qint64 m_maxAgeMs;
+    qint64 m_watermark;
+    quint64 m_revision;
+    bool m_complete;
+};
+
+#endif // OBJECTCACHE_H
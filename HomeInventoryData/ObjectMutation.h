@@ -0,0 +1,51 @@
+#pragma once
+#ifndef OBJECTMUTATION_H
+#define OBJECTMUTATION_H
+
+#include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include <QString>
+
+/**
+ * @brief Singola modifica di un oggetto all'interno di un batch (vedi IDatabaseManager::applyBatch)
+ */
+struct ObjectMutation
+{
+    enum class Type
+    {
+        Create,
+        Update,
+        Delete
+    };
+
+    Type type = Type::Create;
+    QString oldName;  // Update: nome precedente (se cambiato). Delete: oggetto da eliminare
+    HomeObject object;
+
+    static ObjectMutation create(const HomeObject& object)
+    {
+        ObjectMutation mutation;
+        mutation.type = Type::Create;
+        mutation.object = object;
+        return mutation;
+    }
+
+    static ObjectMutation update(const QString& oldName, const HomeObject& newObject)
+    {
+        ObjectMutation mutation;
+        mutation.type = Type::Update;
+        mutation.oldName = oldName;
+        mutation.object = newObject;
+        return mutation;
+    }
+
+    static ObjectMutation remove(const QString& objectName)
+    {
+        ObjectMutation mutation;
+        mutation.type = Type::Delete;
+        mutation.oldName = objectName;
+        return mutation;
+    }
+};
+
+#endif // OBJECTMUTATION_H
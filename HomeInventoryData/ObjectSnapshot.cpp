@@ -0,0 +1,368 @@
+#include "ObjectSnapshot.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char Magic[4] = { 'H', 'I', 'S', 'N' };
+const quint32 ByteOrderMark = 0x01020304; // letto diverso su un host con l'altro ordine dei byte
+
+// Porzione del pool di stringhe (in caratteri UTF-16) o dei blob (in byte)
+struct Span
+{
+    quint32 offset;
+    quint32 length;
+};
+
+quint64 spanKey(const Span& span)
+{
+    return (quint64(span.offset) << 32) | span.length;
+}
+
+} // namespace
+
+struct ObjectSnapshot::Header
+{
+    char magic[4];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 objectCount;
+    qint64 watermark;
+    qint64 savedAtMs;
+    quint32 rowsOffset;    // byte dall'inizio del file
+    quint32 stringsOffset; // byte dall'inizio del file
+    quint32 stringsLength; // caratteri UTF-16
+    quint32 blobsOffset;   // byte dall'inizio del file
+    quint32 blobsLength;   // byte
+    quint32 reserved;
+    Span source;
+};
+
+struct ObjectSnapshot::Row
+{
+    qint32 locationId;
+    qint32 sublocationId;
+    Span name;
+    Span notes;
+    Span pictureRef;
+    Span color;
+    Span material;
+    Span type;
+    Span picture; // nei blob, vuoto se l'oggetto ha un pictureRef
+};
+
+ObjectSnapshot::ObjectSnapshot()
+{
+    static_assert(sizeof(Header) == 64, "snapshot header layout changed: bump FormatVersion");
+    static_assert(sizeof(Row) == 64, "snapshot row layout changed: bump FormatVersion");
+}
+
+ObjectSnapshot::~ObjectSnapshot()
+{
+    close();
+}
+
+bool ObjectSnapshot::write(const QString& filePath, const QString& source, const QList<HomeObject>& objects,
+                           qint64 watermark, QString* error)
+{
+    QString pool;
+    QByteArray blobs;
+    QHash<QString, Span> shared; // attributi e riferimenti ripetuti: una sola copia nel pool
+
+    auto addText = [&pool](const QString& value) {
+        const Span span{ quint32(pool.size()), quint32(value.size()) };
+        pool += value;
+        return span;
+    };
+    auto addShared = [&shared, &addText](const QString& value) {
+        auto it = shared.constFind(value);
+        if (it != shared.constEnd()) {
+            return *it;
+        }
+        const Span span = addText(value);
+        shared.insert(value, span);
+        return span;
+    };
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = FormatVersion;
+    header.byteOrder = ByteOrderMark;
+    header.objectCount = quint32(objects.size());
+    header.watermark = watermark;
+    header.savedAtMs = QDateTime::currentMSecsSinceEpoch();
+    header.source = addText(source);
+
+    QList<Row> rows;
+    rows.reserve(objects.size());
+    for (const HomeObject& obj : objects) {
+        Row row;
+        std::memset(&row, 0, sizeof(row));
+        row.locationId = obj.locationId();
+        row.sublocationId = obj.sublocationId();
+        row.name = addText(obj.name());
+        row.notes = addText(obj.notes());
+        row.pictureRef = addShared(obj.pictureRef());
+        row.color = addShared(obj.color());
+        row.material = addShared(obj.material());
+        row.type = addShared(obj.type());
+
+        // Formato precedente: la foto e' nell'oggetto e non nel picture store
+        if (obj.pictureRef().isEmpty() && !obj.picture().isEmpty()) {
+            row.picture = Span{ quint32(blobs.size()), quint32(obj.picture().size()) };
+            blobs += obj.picture();
+        }
+        rows.append(row);
+    }
+
+    const qint64 rowsOffset = sizeof(Header);
+    const qint64 stringsOffset = rowsOffset + qint64(rows.size()) * qint64(sizeof(Row));
+    const qint64 blobsOffset = stringsOffset + qint64(pool.size()) * qint64(sizeof(char16_t));
+    if (blobsOffset + blobs.size() > std::numeric_limits<quint32>::max()) {
+        if (error) {
+            *error = "Snapshot too large";
+        }
+        return false;
+    }
+    header.rowsOffset = quint32(rowsOffset);
+    header.stringsOffset = quint32(stringsOffset);
+    header.stringsLength = quint32(pool.size());
+    header.blobsOffset = quint32(blobsOffset);
+    header.blobsLength = quint32(blobs.size());
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(rows.constData()), qint64(rows.size()) * qint64(sizeof(Row)));
+    file.write(reinterpret_cast<const char*>(pool.utf16()), qint64(pool.size()) * qint64(sizeof(char16_t)));
+    file.write(blobs);
+
+    if (!file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ObjectSnapshot::open(const QString& filePath)
+{
+    close();
+    m_error.clear();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(m_file.errorString());
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(Header)) || fileSize > std::numeric_limits<quint32>::max()) {
+        return fail("Invalid snapshot size");
+    }
+
+    const uchar* data = m_file.map(0, fileSize);
+    if (!data) {
+        return fail(m_file.errorString());
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header->magic, Magic, sizeof(Magic)) != 0) {
+        return fail("Not an object snapshot");
+    }
+    if (header->byteOrder != ByteOrderMark) {
+        return fail("Snapshot written with a different byte order");
+    }
+    if (header->version != FormatVersion) {
+        return fail(QString("Unsupported snapshot version %1").arg(header->version));
+    }
+
+    // Layout: righe, stringhe e blob in quest'ordine, allineati e dentro il file
+    const qint64 rowsEnd = qint64(header->rowsOffset) + qint64(header->objectCount) * qint64(sizeof(Row));
+    const qint64 stringsEnd = qint64(header->stringsOffset) + qint64(header->stringsLength) * qint64(sizeof(char16_t));
+    const qint64 blobsEnd = qint64(header->blobsOffset) + qint64(header->blobsLength);
+    if (header->rowsOffset < sizeof(Header) || header->rowsOffset % alignof(Row) != 0
+        || rowsEnd > header->stringsOffset || header->stringsOffset % alignof(char16_t) != 0
+        || stringsEnd > header->blobsOffset || blobsEnd > fileSize) {
+        return fail("Corrupted snapshot layout");
+    }
+
+    // Ogni riferimento viene verificato una volta qui: gli accessori non controllano piu' nulla
+    auto inside = [](const Span& span, quint32 limit) {
+        return qint64(span.offset) + qint64(span.length) <= qint64(limit);
+    };
+    const Row* rows = reinterpret_cast<const Row*>(data + header->rowsOffset);
+    bool valid = inside(header->source, header->stringsLength);
+    for (quint32 row = 0; valid && row < header->objectCount; ++row) {
+        const Row& r = rows[row];
+        valid = inside(r.name, header->stringsLength) && inside(r.notes, header->stringsLength)
+            && inside(r.pictureRef, header->stringsLength) && inside(r.color, header->stringsLength)
+            && inside(r.material, header->stringsLength) && inside(r.type, header->stringsLength)
+            && inside(r.picture, header->blobsLength);
+    }
+    if (!valid) {
+        return fail("Corrupted snapshot row");
+    }
+
+    m_header = header;
+    m_rows = rows;
+    m_strings = reinterpret_cast<const char16_t*>(data + header->stringsOffset);
+    m_blobs = reinterpret_cast<const char*>(data + header->blobsOffset);
+    return true;
+}
+
+void ObjectSnapshot::close()
+{
+    m_header = nullptr;
+    m_rows = nullptr;
+    m_strings = nullptr;
+    m_blobs = nullptr;
+
+    // Chiudere il file rimuove anche la mappatura
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool ObjectSnapshot::fail(const QString& error)
+{
+    close();
+    m_error = error;
+    return false;
+}
+
+int ObjectSnapshot::size() const
+{
+    return m_header ? int(m_header->objectCount) : 0;
+}
+
+qint64 ObjectSnapshot::watermark() const
+{
+    return m_header ? m_header->watermark : 0;
+}
+
+QDateTime ObjectSnapshot::savedAt() const
+{
+    return m_header ? QDateTime::fromMSecsSinceEpoch(m_header->savedAtMs) : QDateTime();
+}
+
+QStringView ObjectSnapshot::source() const
+{
+    return m_header ? text(m_header->source.offset, m_header->source.length) : QStringView();
+}
+
+QStringView ObjectSnapshot::name(int row) const
+{
+    return text(m_rows[row].name.offset, m_rows[row].name.length);
+}
+
+QStringView ObjectSnapshot::notes(int row) const
+{
+    return text(m_rows[row].notes.offset, m_rows[row].notes.length);
+}
+
+QStringView ObjectSnapshot::pictureRef(int row) const
+{
+    return text(m_rows[row].pictureRef.offset, m_rows[row].pictureRef.length);
+}
+
+QStringView ObjectSnapshot::color(int row) const
+{
+    return text(m_rows[row].color.offset, m_rows[row].color.length);
+}
+
+QStringView ObjectSnapshot::material(int row) const
+{
+    return text(m_rows[row].material.offset, m_rows[row].material.length);
+}
+
+QStringView ObjectSnapshot::type(int row) const
+{
+    return text(m_rows[row].type.offset, m_rows[row].type.length);
+}
+
+QByteArrayView ObjectSnapshot::picture(int row) const
+{
+    return QByteArrayView(m_blobs + m_rows[row].picture.offset, qsizetype(m_rows[row].picture.length));
+}
+
+int ObjectSnapshot::locationId(int row) const
+{
+    return m_rows[row].locationId;
+}
+
+int ObjectSnapshot::sublocationId(int row) const
+{
+    return m_rows[row].sublocationId;
+}
+
+HomeObject ObjectSnapshot::object(int row) const
+{
+    HomeObject obj(name(row).toString(), locationId(row), sublocationId(row));
+    obj.setColor(color(row).toString());
+    obj.setMaterial(material(row).toString());
+    obj.setType(type(row).toString());
+    obj.setNotes(notes(row).toString());
+    obj.setPictureRef(pictureRef(row).toString());
+    obj.setPicture(picture(row).toByteArray());
+    return obj;
+}
+
+QList<HomeObject> ObjectSnapshot::objects() const
+{
+    QList<HomeObject> result;
+    result.reserve(size());
+
+    // Nel pool un valore ripetuto e' scritto una volta sola: stesso span, stesso ID
+    QHash<quint64, AttributeDictionary::Id> colorIds;
+    QHash<quint64, AttributeDictionary::Id> materialIds;
+    QHash<quint64, AttributeDictionary::Id> typeIds;
+    QHash<quint64, QString> pictureRefs;
+
+    auto internOnce = [this](QHash<quint64, AttributeDictionary::Id>& ids, AttributeDictionary& dictionary, const Span& span) {
+        const quint64 key = spanKey(span);
+        auto it = ids.constFind(key);
+        if (it != ids.constEnd()) {
+            return *it;
+        }
+        const AttributeDictionary::Id id = dictionary.intern(text(span.offset, span.length).toString());
+        ids.insert(key, id);
+        return id;
+    };
+
+    for (int row = 0; row < size(); ++row) {
+        const Row& r = m_rows[row];
+        HomeObject obj(name(row).toString(), r.locationId, r.sublocationId);
+        obj.setColorId(internOnce(colorIds, AttributeDictionary::colors(), r.color));
+        obj.setMaterialId(internOnce(materialIds, AttributeDictionary::materials(), r.material));
+        obj.setTypeId(internOnce(typeIds, AttributeDictionary::types(), r.type));
+        obj.setNotes(notes(row).toString());
+
+        if (r.pictureRef.length > 0) {
+            QString& ref = pictureRefs[spanKey(r.pictureRef)];
+            if (ref.isEmpty()) {
+                ref = pictureRef(row).toString();
+            }
+            obj.setPictureRef(ref); // copie condivise (implicit sharing) tra oggetti con la stessa foto
+        }
+        if (r.picture.length > 0) {
+            obj.setPicture(picture(row).toByteArray());
+        }
+
+        result.append(obj);
+    }
+
+    return result;
+}
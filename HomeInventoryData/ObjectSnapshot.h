@@ -0,0 +1,81 @@
+#pragma once
+#ifndef OBJECTSNAPSHOT_H
+#define OBJECTSNAPSHOT_H
+
+#include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+/**
+ * @brief Snapshot binario degli oggetti su disco, letto tramite memory mapping
+ * Permette di mostrare l'ultimo inventario noto all'avvio, prima di qualunque richiesta di rete
+ * Formato (little-endian, versionato): header, righe a dimensione fissa, pool di stringhe UTF-16
+ * e blob delle foto in formato precedente. Le righe riferiscono stringhe e blob per offset,
+ * quindi le viste restituite puntano direttamente nella mappatura senza copie
+ * Le viste restano valide finche' lo snapshot resta aperto
+ */
+class HOMEINVENTORYDATA_EXPORT ObjectSnapshot
+{
+public:
+    static constexpr quint32 FormatVersion = 1;
+
+    ObjectSnapshot();
+    ~ObjectSnapshot();
+    ObjectSnapshot(const ObjectSnapshot&) = delete;
+    ObjectSnapshot& operator=(const ObjectSnapshot&) = delete;
+
+    // Scrittura atomica (QSaveFile): un lettore non vede mai uno snapshot a meta'
+    // source identifica il database di provenienza, watermark e' l'updatedAt piu' recente
+    static bool write(const QString& filePath, const QString& source, const QList<HomeObject>& objects,
+                      qint64 watermark, QString* error = nullptr);
+
+    bool open(const QString& filePath); // mappa e valida il file; false se assente, corrotto o di un'altra versione
+    void close();
+    bool isOpen() const { return m_rows != nullptr; }
+    QString errorString() const { return m_error; }
+
+    // Header
+    int size() const;
+    qint64 watermark() const;
+    QDateTime savedAt() const;
+    QStringView source() const;
+
+    // Row access (zero-copy)
+    QStringView name(int row) const;
+    QStringView notes(int row) const;
+    QStringView pictureRef(int row) const;
+    QStringView color(int row) const;
+    QStringView material(int row) const;
+    QStringView type(int row) const;
+    QByteArrayView picture(int row) const; // solo oggetti in formato precedente, senza pictureRef
+    int locationId(int row) const;
+    int sublocationId(int row) const;
+
+    // Materializzazione: gli attributi vengono internati una volta per valore distinto
+    HomeObject object(int row) const;
+    QList<HomeObject> objects() const;
+
+private:
+    struct Header;
+    struct Row;
+
+    bool fail(const QString& error);
+    QStringView text(quint32 offset, quint32 length) const
+    {
+        return QStringView(m_strings + offset, qsizetype(length));
+    }
+
+    QFile m_file;
+    const Header* m_header = nullptr;
+    const Row* m_rows = nullptr;
+    const char16_t* m_strings = nullptr;
+    const char* m_blobs = nullptr;
+    QString m_error;
+};
+
+#endif // OBJECTSNAPSHOT_H
@@ -0,0 +1,207 @@
+#include "ObjectTable.h"
+#include "FilterKernels.h"
+#include <QVarLengthArray>
+#include <QHash>
+#include <algorithm>
+
+ObjectTable::ObjectTable(const QList<HomeObject>& objects)
+{
+    reserve(int(objects.size()));
+    for (int row = 0; row < objects.size(); ++row) {
+        set(row, objects.at(row));
+    }
+}
+
+void ObjectTable::reserve(int rows)
+{
+    m_locationIds.reserve(rows);
+    m_sublocationIds.reserve(rows);
+    m_colorIds.reserve(rows);
+    m_materialIds.reserve(rows);
+    m_typeIds.reserve(rows);
+    m_nameOffset.reserve(rows);
+    m_nameLength.reserve(rows);
+    m_notesOffset.reserve(rows);
+    m_notesLength.reserve(rows);
+    m_pictureRefs.reserve(rows);
+}
+
+void ObjectTable::clear()
+{
+    *this = ObjectTable();
+}
+
+void ObjectTable::set(int row, const HomeObject& object)
+{
+    if (row >= rowCount()) {
+        const int rows = row + 1;
+        m_rowCount = rows;
+        m_liveRows.resize(rows);
+        m_locationIds.resize(rows, 0);
+        m_sublocationIds.resize(rows, 0);
+        m_colorIds.resize(rows, AttributeDictionary::EmptyId);
+        m_materialIds.resize(rows, AttributeDictionary::EmptyId);
+        m_typeIds.resize(rows, AttributeDictionary::EmptyId);
+        m_nameOffset.resize(rows, 0);
+        m_nameLength.resize(rows, 0);
+        m_notesOffset.resize(rows, 0);
+        m_notesLength.resize(rows, 0);
+        m_pictureRefs.resize(rows);
+    }
+
+    if (isLive(row)) {
+        erase(row);
+    }
+
+    m_liveRows.set(row);
+    m_locationIds[row] = object.locationId();
+    m_sublocationIds[row] = object.sublocationId();
+    m_colorIds[row] = object.colorId();
+    m_materialIds[row] = object.materialId();
+    m_typeIds[row] = object.typeId();
+    m_pictureRefs[row] = object.pictureRef();
+
+    m_nameOffset[row] = quint32(m_arena.size());
+    m_nameLength[row] = quint32(object.name().size());
+    m_arena += object.name();
+    m_notesOffset[row] = quint32(m_arena.size());
+    m_notesLength[row] = quint32(object.notes().size());
+    m_arena += object.notes();
+
+    ++m_liveCount;
+}
+
+void ObjectTable::erase(int row)
+{
+    if (!isLive(row)) {
+        return;
+    }
+
+    m_liveRows.reset(row);
+    m_garbage += m_nameLength.at(row) + m_notesLength.at(row);
+    m_nameLength[row] = 0;
+    m_notesLength[row] = 0;
+    m_pictureRefs[row].clear();
+    --m_liveCount;
+
+    // Arena per meta' inutilizzata: conviene ricostruirla
+    if (m_garbage > 4096 && m_garbage * 2 > m_arena.size()) {
+        squeeze();
+    }
+}
+
+void ObjectTable::squeeze()
+{
+    QString arena;
+    arena.reserve(m_arena.size() - m_garbage);
+
+    for (int row = 0; row < rowCount(); ++row) {
+        const QStringView rowName = name(row);
+        const QStringView rowNotes = notes(row);
+        m_nameOffset[row] = quint32(arena.size());
+        arena += rowName;
+        m_notesOffset[row] = quint32(arena.size());
+        arena += rowNotes;
+    }
+
+    m_arena = arena;
+    m_garbage = 0;
+}
+
+HomeObject ObjectTable::object(int row) const
+{
+    HomeObject obj(name(row).toString(), locationId(row), sublocationId(row));
+    obj.setColorId(colorId(row));
+    obj.setMaterialId(materialId(row));
+    obj.setTypeId(typeId(row));
+    obj.setNotes(notes(row).toString());
+    obj.setPictureRef(m_pictureRefs.at(row));
+    return obj;
+}
+
+ObjectBitmap ObjectTable::selectLocation(int locationId) const
+{
+    ObjectBitmap selection(rowCount());
+    FilterKernels::equals(m_locationIds.constData(), rowCount(), locationId, selection.words());
+    selection &= m_liveRows;
+    return selection;
+}
+
+ObjectBitmap ObjectTable::selectRoom(int locationId, int sublocationId) const
+{
+    ObjectBitmap selection(rowCount());
+    FilterKernels::equalsBoth(m_locationIds.constData(), locationId,
+                              m_sublocationIds.constData(), sublocationId, rowCount(), selection.words());
+    selection &= m_liveRows;
+    return selection;
+}
+
+ObjectBitmap ObjectTable::memberOf(const QList<AttributeDictionary::Id>& column, const QSet<AttributeDictionary::Id>& ids) const
+{
+    // I valori mai registrati (NoId) non possono comparire nella colonna
+    QVarLengthArray<AttributeDictionary::Id, 16> values;
+    for (AttributeDictionary::Id id : ids) {
+        if (id != AttributeDictionary::NoId) {
+            values.append(id);
+        }
+    }
+
+    ObjectBitmap selection(rowCount());
+    FilterKernels::memberOf(column.constData(), rowCount(), values.constData(), int(values.size()), selection.words());
+    return selection;
+}
+
+ObjectBitmap ObjectTable::select(const SearchFilter& filter) const
+{
+    ObjectBitmap selection = m_liveRows;
+
+    if (filter.hasLocation() && filter.hasSublocation()) {
+        selection = selectRoom(filter.locationId(), filter.sublocationId());
+    }
+    else if (filter.hasLocation()) {
+        selection = selectLocation(filter.locationId());
+    }
+    else if (filter.hasSublocation()) {
+        ObjectBitmap sublocation(rowCount());
+        FilterKernels::equals(m_sublocationIds.constData(), rowCount(), filter.sublocationId(), sublocation.words());
+        selection &= sublocation;
+    }
+
+    if (!filter.colors().isEmpty() && !selection.isEmpty()) {
+        selection &= memberOf(m_colorIds, filter.colors());
+    }
+    if (!filter.materials().isEmpty() && !selection.isEmpty()) {
+        selection &= memberOf(m_materialIds, filter.materials());
+    }
+    if (!filter.types().isEmpty() && !selection.isEmpty()) {
+        selection &= memberOf(m_typeIds, filter.types());
+    }
+
+    return selection;
+}
+
+QList<ObjectTable::RoomCount> ObjectTable::countByRoom() const
+{
+    return countByRoom(live());
+}
+
+QList<ObjectTable::RoomCount> ObjectTable::countByRoom(const ObjectBitmap& selection) const
+{
+    QHash<qint64, int> counts;
+    selection.forEach([this, &counts](int row) {
+        if (row < rowCount()) {
+            ++counts[qint64((quint64(quint32(m_locationIds.at(row))) << 32) | quint32(m_sublocationIds.at(row)))];
+        }
+    });
+
+    QList<RoomCount> result;
+    result.reserve(counts.size());
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        result.append({ int(it.key() >> 32), int(quint32(it.key())), it.value() });
+    }
+
+    std::sort(result.begin(), result.end(), [](const RoomCount& a, const RoomCount& b) {
+        return a.locationId != b.locationId ? a.locationId < b.locationId : a.sublocationId < b.sublocationId;
+    });
+    return result;
+}
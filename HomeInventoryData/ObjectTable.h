@@ -0,0 +1,98 @@
+#pragma once
+#ifndef OBJECTTABLE_H
+#define OBJECTTABLE_H
+
+#include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include "ObjectBitmap.h"
+#include "SearchFilter.h"
+#include "AttributeDictionary.h"
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+/**
+ * @brief Tabella colonnare (structure-of-arrays) degli oggetti
+ * Posizioni e attributi stanno in colonne contigue di interi, nomi e note in un'unica
+ * arena di caratteri: una scansione su un campo legge solo quella colonna
+ * Le righe sono assegnate dal chiamante (stessi indici di ObjectCache); una riga
+ * cancellata resta come buco finche' non viene riassegnata
+ */
+class HOMEINVENTORYDATA_EXPORT ObjectTable
+{
+public:
+    struct RoomCount
+    {
+        int locationId;
+        int sublocationId;
+        int count;
+    };
+
+    ObjectTable() = default;
+    explicit ObjectTable(const QList<HomeObject>& objects); // righe 0..n-1
+
+    int rowCount() const { return m_rowCount; } // righe allocate, compresi i buchi
+    int size() const { return m_liveCount; }
+    void reserve(int rows);
+    void clear();
+
+    // Maintenance
+    void set(int row, const HomeObject& object);
+    void erase(int row);
+    void squeeze(); // compatta l'arena delle stringhe
+
+    // Row access
+    bool isLive(int row) const { return m_liveRows.test(row); }
+    QStringView name(int row) const { return text(m_nameOffset.at(row), m_nameLength.at(row)); }
+    QStringView notes(int row) const { return text(m_notesOffset.at(row), m_notesLength.at(row)); }
+    int locationId(int row) const { return m_locationIds.at(row); }
+    int sublocationId(int row) const { return m_sublocationIds.at(row); }
+    AttributeDictionary::Id colorId(int row) const { return m_colorIds.at(row); }
+    AttributeDictionary::Id materialId(int row) const { return m_materialIds.at(row); }
+    AttributeDictionary::Id typeId(int row) const { return m_typeIds.at(row); }
+    HomeObject object(int row) const; // senza la foto, solo il riferimento
+
+    // Columns (rowCount() elementi)
+    const qint32* locationIds() const { return m_locationIds.constData(); }
+    const qint32* sublocationIds() const { return m_sublocationIds.constData(); }
+    const AttributeDictionary::Id* colorIds() const { return m_colorIds.constData(); }
+    const AttributeDictionary::Id* materialIds() const { return m_materialIds.constData(); }
+    const AttributeDictionary::Id* typeIds() const { return m_typeIds.constData(); }
+
+    // Scan kernels (vedi FilterKernels): producono la selezione come bitmap, 64 righe per parola
+    const ObjectBitmap& live() const { return m_liveRows; }
+    ObjectBitmap selectLocation(int locationId) const;
+    ObjectBitmap selectRoom(int locationId, int sublocationId) const;
+    ObjectBitmap select(const SearchFilter& filter) const; // criteri su colonne, il nome va verificato a parte
+
+    // Aggregation
+    QList<RoomCount> countByRoom() const;
+    QList<RoomCount> countByRoom(const ObjectBitmap& selection) const;
+
+private:
+    QStringView text(quint32 offset, quint32 length) const
+    {
+        return QStringView(m_arena).mid(offset, length);
+    }
+
+    ObjectBitmap memberOf(const QList<AttributeDictionary::Id>& column, const QSet<AttributeDictionary::Id>& ids) const;
+
+    ObjectBitmap m_liveRows;
+    int m_rowCount = 0;
+    QList<qint32> m_locationIds;
+    QList<qint32> m_sublocationIds;
+    QList<AttributeDictionary::Id> m_colorIds;
+    QList<AttributeDictionary::Id> m_materialIds;
+    QList<AttributeDictionary::Id> m_typeIds;
+    QList<quint32> m_nameOffset;
+    QList<quint32> m_nameLength;
+    QList<quint32> m_notesOffset;
+    QList<quint32> m_notesLength;
+    QList<QString> m_pictureRefs;
+
+    QString m_arena;       // nomi e note concatenati
+    qsizetype m_garbage = 0; // caratteri dell'arena non piu' referenziati
+    int m_liveCount = 0;
+};
+
+#endif // OBJECTTABLE_H
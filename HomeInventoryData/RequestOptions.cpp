@@ -0,0 +1,94 @@
+#include "RequestOptions.h"
+#include <QRandomGenerator>
+
+// ==================== CancellationToken ====================
+
+CancellationToken::CancellationToken()
+    : m_state(std::make_shared<State>())
+{
+}
+
+void CancellationToken::cancel()
+{
+    if (m_state->cancelled) {
+        return;
+    }
+    m_state->cancelled = true;
+
+    // Le azioni possono rimuovere altre azioni (es. una reply abortita che termina): si lavora su una copia
+    const QHash<int, std::function<void()>> actions = std::move(m_state->actions);
+    m_state->actions.clear();
+    for (const auto& action : actions) {
+        action();
+    }
+}
+
+bool CancellationToken::isCancelled() const
+{
+    return m_state->cancelled;
+}
+
+int CancellationToken::onCancel(std::function<void()> action)
+{
+    if (m_state->cancelled) {
+        action();
+        return -1;
+    }
+
+    const int id = m_state->nextId++;
+    m_state->actions.insert(id, std::move(action));
+    return id;
+}
+
+void CancellationToken::removeOnCancel(int id)
+{
+    m_state->actions.remove(id);
+}
+
+// ==================== RequestOptions ====================
+
+int RequestOptions::backoffDelayMs(int attempt) const
+{
+    // 200, 400, 800 ms... fino a maxBackoffMs, poi "equal jitter": meta' fissa e meta' casuale,
+    // cosi' i client che hanno fallito insieme non ritentano insieme
+    qint64 delay = initialBackoffMs;
+    for (int i = 1; i < attempt && delay < maxBackoffMs; ++i) {
+        delay *= 2;
+    }
+    delay = qMin<qint64>(delay, maxBackoffMs);
+
+    const qint64 half = delay / 2;
+    return int(half + QRandomGenerator::global()->bounded(half + 1));
+}
+
+bool RequestOptions::isIdempotent(const QByteArray& verb)
+{
+    // Su Firebase PUT e PATCH scrivono valori assoluti; POST genera ogni volta una nuova chiave
+    return verb == "GET" || verb == "HEAD" || verb == "PUT" || verb == "PATCH" || verb == "DELETE";
+}
+
+bool RequestOptions::isRetryable(QNetworkReply::NetworkError error, int httpStatus)
+{
+    if (httpStatus == 429 || httpStatus == 500 || httpStatus == 502 || httpStatus == 503 || httpStatus == 504) {
+        return true;
+    }
+
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::OperationCanceledError: // timeout di inattivita' del tentativo
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::InternalServerError:
+    case QNetworkReply::ServiceUnavailableError:
+    case QNetworkReply::UnknownServerError:
+        return true;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef REQUESTOPTIONS_H
+#define REQUESTOPTIONS_H
+
+#include "homeinventorydata_global.h"
+#include <QByteArray>
+#include <QHash>
+#include <QNetworkReply>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Annullamento cooperativo di una o piu' richieste
+ * Le copie condividono lo stesso stato: annullarne una le annulla tutte
+ * Da usare nel thread del manager, come il resto della pipeline di richieste
+ */
+class HOMEINVENTORYDATA_EXPORT CancellationToken
+{
+public:
+    CancellationToken();
+
+    void cancel();
+    bool isCancelled() const;
+
+    // Azione eseguita all'annullamento (subito, se gia' annullato); l'id serve a rimuoverla
+    int onCancel(std::function<void()> action);
+    void removeOnCancel(int id);
+
+private:
+    struct State
+    {
+        bool cancelled = false;
+        int nextId = 0;
+        QHash<int, std::function<void()>> actions;
+    };
+    std::shared_ptr<State> m_state;
+};
+
+/**
+ * @brief Politica di esecuzione di una richiesta: scadenza, retry con backoff e annullamento
+ * Solo i verbi idempotenti vengono ripetuti, e solo per errori di rete o 5xx/429:
+ * una richiesta non viene mai ripetuta con un verbo diverso da quello originale
+ */
+struct HOMEINVENTORYDATA_EXPORT RequestOptions
+{
+    int deadlineMs = 30000;       // tempo totale, tentativi e attese compresi (0 = nessuna scadenza)
+    int attemptTimeoutMs = 10000; // inattivita' massima di un singolo tentativo
+    int maxAttempts = 4;          // 1 = nessun retry
+    int initialBackoffMs = 200;
+    int maxBackoffMs = 5000;
+    CancellationToken cancellation;
+
+    // Attesa prima del tentativo successivo a 'attempt' (1, 2, ...): esponenziale con jitter
+    int backoffDelayMs(int attempt) const;
+
+    static bool isIdempotent(const QByteArray& verb);
+    static bool isRetryable(QNetworkReply::NetworkError error, int httpStatus);
+};
+
+#endif // REQUESTOPTIONS_H
@@ -0,0 +1,77 @@
+#include "SearchFilter.h"
+#include "TrigramIndex.h"
+#include <QStringList>
+
+SearchFilter SearchFilter::compile(const QVariantMap& filters)
+{
+    SearchFilter filter;
+
+    filter.m_name = filters.value("name").toString();
+    filter.m_foldedName = TrigramIndex::fold(filter.m_name);
+
+    // Un valore mai visto diventa NoId: il criterio resta attivo ma non corrisponde a nulla
+    auto toIds = [&filters](const char* key, const AttributeDictionary& dictionary) {
+        QSet<AttributeDictionary::Id> ids;
+        const QStringList values = filters.value(key).toStringList();
+        for (const QString& value : values) {
+            ids.insert(dictionary.find(value));
+        }
+        return ids;
+    };
+    filter.m_colors = toIds("colors", AttributeDictionary::colors());
+    filter.m_materials = toIds("materials", AttributeDictionary::materials());
+    filter.m_types = toIds("types", AttributeDictionary::types());
+
+    if (filters.contains("locationId")) {
+        filter.m_hasLocation = true;
+        filter.m_locationId = filters.value("locationId").toInt();
+    }
+    if (filters.contains("sublocationId")) {
+        filter.m_hasSublocation = true;
+        filter.m_sublocationId = filters.value("sublocationId").toInt();
+    }
+
+    return filter;
+}
+
+bool SearchFilter::isEmpty() const
+{
+    return m_name.isEmpty() && m_colors.isEmpty() && m_materials.isEmpty() && m_types.isEmpty()
+        && !m_hasLocation && !m_hasSublocation;
+}
+
+bool SearchFilter::matchesName(const HomeObject& object) const
+{
+    if (m_name.isEmpty()) {
+        return true;
+    }
+
+    // Un nome fatto solo di punteggiatura o segni ("-", "#") si annulla nella normalizzazione:
+    // va cercato cosi' com'e', non trattato come assenza del criterio
+    if (m_foldedName.isEmpty()) {
+        return object.name().contains(m_name, Qt::CaseInsensitive);
+    }
+
+    // Stessa normalizzazione dell'indice: maiuscole e accenti non contano
+    return TrigramIndex::fold(object.name()).contains(m_foldedName);
+}
+
+bool SearchFilter::matches(const HomeObject& object) const
+{
+    if (m_hasLocation && object.locationId() != m_locationId) {
+        return false;
+    }
+    if (m_hasSublocation && object.sublocationId() != m_sublocationId) {
+        return false;
+    }
+    if (!m_colors.isEmpty() && !m_colors.contains(object.colorId())) {
+        return false;
+    }
+    if (!m_materials.isEmpty() && !m_materials.contains(object.materialId())) {
+        return false;
+    }
+    if (!m_types.isEmpty() && !m_types.contains(object.typeId())) {
+        return false;
+    }
+    return matchesName(object);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef SEARCHFILTER_H
+#define SEARCHFILTER_H
+
+#include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include <QString>
+#include <QSet>
+#include <QVariantMap>
+
+/**
+ * @brief Filtro di ricerca precompilato a partire dalla QVariantMap di searchObjects
+ * I filtri vengono letti e normalizzati una sola volta, non per ogni oggetto
+ * Chiavi riconosciute: name, colors, materials, types, locationId, sublocationId
+ * Gli attributi diventano ID dei vocabolari: va compilato dopo che gli oggetti da filtrare
+ * sono stati caricati, altrimenti un valore non ancora internato non corrisponde a nulla
+ */
+class HOMEINVENTORYDATA_EXPORT SearchFilter
+{
+public:
+    SearchFilter() = default;
+    static SearchFilter compile(const QVariantMap& filters);
+
+    bool isEmpty() const;
+    bool matches(const HomeObject& object) const;
+    bool matchesName(const HomeObject& object) const;
+
+    // Criteri compilati come ID dei vocabolari (insiemi vuoti = nessun vincolo)
+    const QString& name() const { return m_name; }
+    const QString& foldedName() const { return m_foldedName; } // vuoto se il nome e' solo punteggiatura o segni
+    const QSet<AttributeDictionary::Id>& colors() const { return m_colors; }
+    const QSet<AttributeDictionary::Id>& materials() const { return m_materials; }
+    const QSet<AttributeDictionary::Id>& types() const { return m_types; }
+    bool hasLocation() const { return m_hasLocation; }
+    int locationId() const { return m_locationId; }
+    bool hasSublocation() const { return m_hasSublocation; }
+    int sublocationId() const { return m_sublocationId; }
+
+private:
+    QString m_name;
+    QString m_foldedName; // vedi TrigramIndex::fold
+    QSet<AttributeDictionary::Id> m_colors;
+    QSet<AttributeDictionary::Id> m_materials;
+    QSet<AttributeDictionary::Id> m_types;
+    bool m_hasLocation = false;
+    int m_locationId = 0;
+    bool m_hasSublocation = false;
+    int m_sublocationId = 0;
+};
+
+#endif // SEARCHFILTER_H
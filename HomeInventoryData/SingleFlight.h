@@ -0,0 +1,46 @@
+#pragma once
+#ifndef SINGLEFLIGHT_H
+#define SINGLEFLIGHT_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Unisce le letture identiche in volo: una sola richiesta per chiave, risultato a tutti
+ * Il primo chiamante per una chiave avvia la richiesta, i successivi si accodano finche'
+ * complete() non consegna lo stesso risultato a tutti. Da usare nel thread del manager
+ */
+template <typename... Result>
+class SingleFlight
+{
+public:
+    using Callback = std::function<void(Result...)>;
+
+    // true se il chiamante e' il primo per la chiave e deve avviare la richiesta
+    bool join(const QString& key, Callback callback)
+    {
+        QList<Callback>& waiters = m_waiters[key];
+        waiters.append(std::move(callback));
+        return waiters.size() == 1;
+    }
+
+    // Consegna il risultato a tutti i chiamanti in attesa; la chiave si libera prima delle
+    // callback, cosi' una lettura avviata da una callback parte con una nuova richiesta
+    void complete(const QString& key, const Result&... result)
+    {
+        const QList<Callback> waiters = m_waiters.take(key);
+        for (const Callback& waiter : waiters) {
+            waiter(result...);
+        }
+    }
+
+    bool isInFlight(const QString& key) const { return m_waiters.contains(key); }
+    int size() const { return m_waiters.size(); }
+
+private:
+    QHash<QString, QList<Callback>> m_waiters;
+};
+
+#endif // SINGLEFLIGHT_H
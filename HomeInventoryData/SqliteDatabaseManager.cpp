@@ -0,0 +1,804 @@
+﻿#include "SqliteDatabaseManager.h"
+#include "HomeObject.h"
+#include <QSqlError>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QNetworkInformation>
+#include <QSet>
+#include "Logger.h"
+
+namespace {
+
+const char* const LogCategory = "sqlite";
+const int SchemaVersion = 1;
+
+const char* const ObjectColumns =
+    "name, color, material, type, notes, location_id, sublocation_id, picture_ref";
+
+// Nomi logici usati dall'outbox e dalla tabella attributes
+const char* const ColorAttribute = "color";
+const char* const MaterialAttribute = "material";
+const char* const TypeAttribute = "type";
+
+QString placeholders(int count)
+{
+    QStringList marks;
+    for (int i = 0; i < count; ++i) {
+        marks.append("?");
+    }
+    return marks.join(", ");
+}
+
+} // namespace
+
+SqliteDatabaseManager::SqliteDatabaseManager(QObject* parent)
+    : QObject(parent)
+    , m_connectionName(QString("HomeInventory-%1").arg(quintptr(this), 0, 16))
+    , m_remote(nullptr)
+    , m_isSyncing(false)
+{
+    QObject::connect(&m_syncTimer, &QTimer::timeout, this, [this]() {
+        if (pendingChanges() > 0) {
+            synchronize();
+        }
+    });
+
+    // Appena la rete torna disponibile si svuota l'outbox
+    if (QNetworkInformation::loadDefaultBackend()) {
+        QObject::connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged, this,
+            [this](QNetworkInformation::Reachability reachability) {
+                if (reachability == QNetworkInformation::Reachability::Online
+                    && m_remote && isConnected() && pendingChanges() > 0) {
+                    synchronize();
+                }
+            });
+    }
+}
+
+SqliteDatabaseManager::~SqliteDatabaseManager()
+{
+    disconnect();
+}
+
+// ==================== CONNECTION ====================
+
+bool SqliteDatabaseManager::connect(const QString& databasePath)
+{
+    if (isConnected()) {
+        disconnect();
+    }
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        db.setDatabaseName(databasePath);
+
+        if (!db.open()) {
+            setLastError("Cannot open local database: " + db.lastError().text());
+        }
+        else if (createSchema()) {
+            setLastError(QString());
+            LOG_INFO(LogCategory, u8"✅ Local database opened: " << databasePath);
+            return true;
+        }
+        db.close();
+    }
+
+    QSqlDatabase::removeDatabase(m_connectionName);
+    return false;
+}
+
+void SqliteDatabaseManager::disconnect()
+{
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+
+    m_syncTimer.stop();
+    {
+        QSqlDatabase db = database();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+bool SqliteDatabaseManager::isConnected() const
+{
+    return QSqlDatabase::contains(m_connectionName) && database().isOpen();
+}
+
+QSqlDatabase SqliteDatabaseManager::database() const
+{
+    return QSqlDatabase::database(m_connectionName, false);
+}
+
+bool SqliteDatabaseManager::exec(QSqlQuery& query)
+{
+    if (!query.exec()) {
+        setLastError("SQL error: " + query.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+bool SqliteDatabaseManager::createSchema()
+{
+    QSqlQuery query(database());
+
+    // WAL: letture e scritture non si bloccano a vicenda, commit piu' rapidi
+    query.exec("PRAGMA journal_mode = WAL");
+    query.exec("PRAGMA synchronous = NORMAL");
+
+    query.exec("PRAGMA user_version");
+    const int version = query.next() ? query.value(0).toInt() : 0;
+    if (version >= SchemaVersion) {
+        return true;
+    }
+
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS objects ("
+        " name TEXT PRIMARY KEY NOT NULL,"
+        " color TEXT NOT NULL DEFAULT '',"
+        " material TEXT NOT NULL DEFAULT '',"
+        " type TEXT NOT NULL DEFAULT '',"
+        " notes TEXT NOT NULL DEFAULT '',"
+        " location_id INTEGER NOT NULL,"
+        " sublocation_id INTEGER NOT NULL,"
+        " picture_ref TEXT NOT NULL DEFAULT '')",
+        "CREATE INDEX IF NOT EXISTS idx_objects_location ON objects (location_id, sublocation_id)",
+        "CREATE INDEX IF NOT EXISTS idx_objects_color ON objects (color)",
+        "CREATE INDEX IF NOT EXISTS idx_objects_material ON objects (material)",
+        "CREATE INDEX IF NOT EXISTS idx_objects_type ON objects (type)",
+
+        // Foto indirizzate per contenuto (sha256), come nel picture store di Firebase
+        "CREATE TABLE IF NOT EXISTS pictures ("
+        " ref TEXT PRIMARY KEY NOT NULL,"
+        " data BLOB NOT NULL)",
+
+        "CREATE TABLE IF NOT EXISTS attributes ("
+        " attribute TEXT NOT NULL,"
+        " value TEXT NOT NULL,"
+        " PRIMARY KEY (attribute, value))",
+
+        // Modifiche locali non ancora inviate al database remoto, in ordine di id
+        "CREATE TABLE IF NOT EXISTS outbox ("
+        " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        " operation TEXT NOT NULL,"
+        " object_name TEXT NOT NULL DEFAULT '',"
+        " old_name TEXT NOT NULL DEFAULT '',"
+        " attribute TEXT NOT NULL DEFAULT '',"
+        " value TEXT NOT NULL DEFAULT '',"
+        " created_at INTEGER NOT NULL)",
+
+        QString("PRAGMA user_version = %1").arg(SchemaVersion)
+    };
+
+    QSqlDatabase db = database();
+    db.transaction();
+    for (const QString& statement : statements) {
+        if (!query.exec(statement)) {
+            setLastError("Cannot create local schema: " + query.lastError().text());
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+// ==================== OBJECT OPERATIONS ====================
+
+bool SqliteDatabaseManager::writeObject(const HomeObject& object)
+{
+    QString pictureRef = object.pictureRef();
+
+    if (!object.picture().isEmpty()) {
+        pictureRef = QString::fromLatin1(
+            QCryptographicHash::hash(object.picture(), QCryptographicHash::Sha256).toHex());
+
+        QSqlQuery picture(database());
+        picture.prepare("INSERT OR IGNORE INTO pictures (ref, data) VALUES (?, ?)");
+        picture.addBindValue(pictureRef);
+        picture.addBindValue(object.picture());
+        if (!exec(picture)) {
+            return false;
+        }
+    }
+
+    QSqlQuery query(database());
+    query.prepare(QString("INSERT OR REPLACE INTO objects (%1) VALUES (%2)")
+        .arg(ObjectColumns, placeholders(8)));
+    query.addBindValue(object.name());
+    query.addBindValue(object.color());
+    query.addBindValue(object.material());
+    query.addBindValue(object.type());
+    query.addBindValue(object.notes());
+    query.addBindValue(object.locationId());
+    query.addBindValue(object.sublocationId());
+    query.addBindValue(pictureRef);
+    return exec(query);
+}
+
+bool SqliteDatabaseManager::removeObjectRow(const QString& objectName)
+{
+    QSqlQuery query(database());
+    query.prepare("DELETE FROM objects WHERE name = ?");
+    query.addBindValue(objectName);
+    return exec(query);
+}
+
+bool SqliteDatabaseManager::enqueue(const QString& operation, const QString& objectName, const QString& oldName,
+                                    const QString& attribute, const QString& value)
+{
+    QSqlQuery query(database());
+    query.prepare("INSERT INTO outbox (operation, object_name, old_name, attribute, value, created_at)"
+                  " VALUES (?, ?, ?, ?, ?, ?)");
+    query.addBindValue(operation);
+    query.addBindValue(objectName);
+    query.addBindValue(oldName);
+    query.addBindValue(attribute);
+    query.addBindValue(value);
+    query.addBindValue(QDateTime::currentMSecsSinceEpoch());
+    return exec(query);
+}
+
+bool SqliteDatabaseManager::createObject(const HomeObject& object)
+{
+    if (!object.isValid()) {
+        setLastError("Invalid object - name is required");
+        return false;
+    }
+
+    // Come la PUT di Firebase: un oggetto con lo stesso nome viene sovrascritto
+    return applyBatch({ ObjectMutation::create(object) });
+}
+
+bool SqliteDatabaseManager::updateObject(const QString& oldName, const HomeObject& newObject)
+{
+    return applyBatch({ ObjectMutation::update(oldName, newObject) });
+}
+
+bool SqliteDatabaseManager::deleteObject(const QString& objectName)
+{
+    return applyBatch({ ObjectMutation::remove(objectName) });
+}
+
+bool SqliteDatabaseManager::applyBatch(const QList<ObjectMutation>& mutations)
+{
+    if (!isConnected()) {
+        setLastError("Not connected to local database");
+        return false;
+    }
+
+    // Dati e outbox nella stessa transazione: una modifica salvata e' sempre anche in coda
+    QSqlDatabase db = database();
+    db.transaction();
+
+    for (const ObjectMutation& mutation : mutations) {
+        bool ok = false;
+
+        switch (mutation.type) {
+        case ObjectMutation::Type::Delete:
+            ok = removeObjectRow(mutation.oldName)
+                && enqueue("delete", mutation.oldName, QString());
+            break;
+        case ObjectMutation::Type::Create:
+        case ObjectMutation::Type::Update: {
+            if (!mutation.object.isValid()) {
+                setLastError("Invalid object - name is required");
+                break;
+            }
+            const bool renamed = !mutation.oldName.isEmpty() && mutation.oldName != mutation.object.name();
+            ok = (!renamed || removeObjectRow(mutation.oldName))
+                && writeObject(mutation.object)
+                && enqueue("upsert", mutation.object.name(), renamed ? mutation.oldName : QString());
+            break;
+        }
+        }
+
+        if (!ok) {
+            db.rollback();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        setLastError("Cannot commit local changes: " + db.lastError().text());
+        return false;
+    }
+
+    setLastError(QString());
+    return true;
+}
+
+HomeObject SqliteDatabaseManager::rowToObject(const QSqlQuery& query)
+{
+    HomeObject object(query.value(0).toString(), query.value(5).toInt(), query.value(6).toInt());
+    object.setColor(query.value(1).toString());
+    object.setMaterial(query.value(2).toString());
+    object.setType(query.value(3).toString());
+    object.setNotes(query.value(4).toString());
+    object.setPictureRef(query.value(7).toString());
+    return object;
+}
+
+HomeObject SqliteDatabaseManager::loadObject(const QString& objectName, bool withPicture, bool* found) const
+{
+    QSqlQuery query(database());
+    query.prepare(QString("SELECT %1 FROM objects WHERE name = ?").arg(ObjectColumns));
+    query.addBindValue(objectName);
+
+    const bool exists = query.exec() && query.next();
+    if (found) {
+        *found = exists;
+    }
+    if (!exists) {
+        return HomeObject();
+    }
+
+    HomeObject object = rowToObject(query);
+    if (withPicture && object.hasPicture()) {
+        QSqlQuery picture(database());
+        picture.prepare("SELECT data FROM pictures WHERE ref = ?");
+        picture.addBindValue(object.pictureRef());
+        if (picture.exec() && picture.next()) {
+            object.setPicture(picture.value(0).toByteArray());
+        }
+    }
+    return object;
+}
+
+QList<HomeObject> SqliteDatabaseManager::selectObjects(const QString& whereClause, const QVariantList& bindings) const
+{
+    QList<HomeObject> objects;
+
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT %1 FROM objects%2 ORDER BY name")
+        .arg(ObjectColumns, whereClause.isEmpty() ? QString() : " WHERE " + whereClause));
+    for (const QVariant& binding : bindings) {
+        query.addBindValue(binding);
+    }
+
+    if (!query.exec()) {
+        LOG_ERROR(LogCategory, "Local query failed: " << query.lastError().text());
+        return objects;
+    }
+
+    while (query.next()) {
+        objects.append(rowToObject(query));
+    }
+    return objects;
+}
+
+QList<HomeObject> SqliteDatabaseManager::getObjects(int locationId, int sublocationId)
+{
+    return selectObjects("location_id = ? AND sublocation_id = ?", { locationId, sublocationId });
+}
+
+QList<HomeObject> SqliteDatabaseManager::getAllObjects()
+{
+    return selectObjects(QString(), {});
+}
+
+QList<HomeObject> SqliteDatabaseManager::searchObjects(const QVariantMap& filters)
+{
+    QStringList conditions;
+    QVariantList bindings;
+
+    if (filters.contains("locationId")) {
+        conditions.append("location_id = ?");
+        bindings.append(filters["locationId"].toInt());
+    }
+    if (filters.contains("sublocationId")) {
+        conditions.append("sublocation_id = ?");
+        bindings.append(filters["sublocationId"].toInt());
+    }
+
+    // Filtri multi-valore: ognuno usa il proprio indice
+    const QList<QPair<QString, QString>> listFilters = {
+        { "colors", "color" }, { "materials", "material" }, { "types", "type" }
+    };
+    for (const auto& filter : listFilters) {
+        const QStringList values = filters.value(filter.first).toStringList();
+        if (values.isEmpty()) {
+            continue;
+        }
+        conditions.append(QString("%1 IN (%2)").arg(filter.second, placeholders(values.size())));
+        for (const QString& value : values) {
+            bindings.append(value);
+        }
+    }
+
+    QList<HomeObject> objects = selectObjects(conditions.join(" AND "), bindings);
+
+    // LIKE di SQLite ignora le maiuscole solo per l'ASCII: il nome si confronta qui, come negli altri backend
+    const QString name = filters.value("name").toString();
+    if (!name.isEmpty()) {
+        objects.removeIf([&name](const HomeObject& object) {
+            return !object.name().contains(name, Qt::CaseInsensitive);
+        });
+    }
+    return objects;
+}
+
+QByteArray SqliteDatabaseManager::getPicture(const QString& pictureRef)
+{
+    if (pictureRef.isEmpty() || !isConnected()) {
+        return QByteArray();
+    }
+
+    QSqlQuery query(database());
+    query.prepare("SELECT data FROM pictures WHERE ref = ?");
+    query.addBindValue(pictureRef);
+    if (query.exec() && query.next()) {
+        return query.value(0).toByteArray();
+    }
+
+    // Foto arrivata con una sincronizzazione ma mai scaricata: la si prende dal remoto una volta sola
+    if (!m_remote) {
+        return QByteArray();
+    }
+
+    const QByteArray picture = m_remote->getPicture(pictureRef);
+    if (!picture.isEmpty()) {
+        QSqlQuery insert(database());
+        insert.prepare("INSERT OR IGNORE INTO pictures (ref, data) VALUES (?, ?)");
+        insert.addBindValue(pictureRef);
+        insert.addBindValue(picture);
+        exec(insert);
+    }
+    return picture;
+}
+
+// ==================== ATTRIBUTE OPERATIONS ====================
+
+QStringList SqliteDatabaseManager::getAttributes(const QString& attribute)
+{
+    QStringList values;
+
+    QSqlQuery query(database());
+    query.prepare("SELECT value FROM attributes WHERE attribute = ? ORDER BY value");
+    query.addBindValue(attribute);
+    if (!exec(query)) {
+        return values;
+    }
+
+    while (query.next()) {
+        values.append(query.value(0).toString());
+    }
+    return values;
+}
+
+bool SqliteDatabaseManager::addAttribute(const QString& attribute, const QString& value, const QString& duplicateError)
+{
+    if (!isConnected()) {
+        setLastError("Not connected to local database");
+        return false;
+    }
+
+    QSqlDatabase db = database();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR IGNORE INTO attributes (attribute, value) VALUES (?, ?)");
+    query.addBindValue(attribute);
+    query.addBindValue(value);
+    if (!exec(query)) {
+        db.rollback();
+        return false;
+    }
+
+    if (query.numRowsAffected() == 0) {
+        db.rollback();
+        setLastError(duplicateError);
+        return false;
+    }
+
+    if (!enqueue("attribute_add", QString(), QString(), attribute, value) || !db.commit()) {
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+bool SqliteDatabaseManager::removeAttribute(const QString& attribute, const QString& value)
+{
+    if (!isConnected()) {
+        setLastError("Not connected to local database");
+        return false;
+    }
+
+    QSqlDatabase db = database();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM attributes WHERE attribute = ? AND value = ?");
+    query.addBindValue(attribute);
+    query.addBindValue(value);
+
+    if (!exec(query) || !enqueue("attribute_remove", QString(), QString(), attribute, value) || !db.commit()) {
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+QStringList SqliteDatabaseManager::getColors()
+{
+    return getAttributes(ColorAttribute);
+}
+
+QStringList SqliteDatabaseManager::getMaterials()
+{
+    return getAttributes(MaterialAttribute);
+}
+
+QStringList SqliteDatabaseManager::getTypes()
+{
+    return getAttributes(TypeAttribute);
+}
+
+bool SqliteDatabaseManager::addColor(const QString& color)
+{
+    return addAttribute(ColorAttribute, color, "Color already exists");
+}
+
+bool SqliteDatabaseManager::addMaterial(const QString& material)
+{
+    return addAttribute(MaterialAttribute, material, "Material already exists");
+}
+
+bool SqliteDatabaseManager::addType(const QString& type)
+{
+    return addAttribute(TypeAttribute, type, "Type already exists");
+}
+
+bool SqliteDatabaseManager::removeColor(const QString& color)
+{
+    return removeAttribute(ColorAttribute, color);
+}
+
+bool SqliteDatabaseManager::removeMaterial(const QString& material)
+{
+    return removeAttribute(MaterialAttribute, material);
+}
+
+bool SqliteDatabaseManager::removeType(const QString& type)
+{
+    return removeAttribute(TypeAttribute, type);
+}
+
+// ==================== SYNCHRONIZATION ====================
+
+void SqliteDatabaseManager::setRemote(IDatabaseManager* remote)
+{
+    m_remote = remote;
+}
+
+void SqliteDatabaseManager::setAutoSyncInterval(int msecs)
+{
+    if (msecs > 0) {
+        m_syncTimer.start(msecs);
+    }
+    else {
+        m_syncTimer.stop();
+    }
+}
+
+int SqliteDatabaseManager::pendingChanges() const
+{
+    QSqlQuery query(database());
+    if (query.exec("SELECT COUNT(*) FROM outbox") && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+bool SqliteDatabaseManager::synchronize()
+{
+    if (!isConnected()) {
+        setLastError("Not connected to local database");
+        return false;
+    }
+    if (!m_remote || !m_remote->isConnected()) {
+        setLastError("Remote database not available");
+        return false;
+    }
+    if (m_isSyncing) {
+        return false;
+    }
+
+    m_isSyncing = true;
+    const bool success = pushPending() && pullRemote();
+    m_isSyncing = false;
+
+    if (success) {
+        LOG_INFO(LogCategory, u8"🔄 Local database synchronized");
+    }
+    emit synchronized(success);
+    return success;
+}
+
+bool SqliteDatabaseManager::replayAttribute(const QString& operation, const QString& attribute, const QString& value)
+{
+    QStringList current;
+    if (attribute == ColorAttribute) {
+        current = m_remote->getColors();
+    }
+    else if (attribute == MaterialAttribute) {
+        current = m_remote->getMaterials();
+    }
+    else if (attribute == TypeAttribute) {
+        current = m_remote->getTypes();
+    }
+    else {
+        return true; // attributo sconosciuto: la riga viene scartata
+    }
+
+    // Riproduzione idempotente: si scrive solo se il remoto non e' gia' nello stato voluto
+    if (operation == "attribute_add") {
+        if (current.contains(value)) {
+            return true;
+        }
+        if (attribute == ColorAttribute) return m_remote->addColor(value);
+        if (attribute == MaterialAttribute) return m_remote->addMaterial(value);
+        return m_remote->addType(value);
+    }
+
+    if (!current.contains(value)) {
+        return true;
+    }
+    if (attribute == ColorAttribute) return m_remote->removeColor(value);
+    if (attribute == MaterialAttribute) return m_remote->removeMaterial(value);
+    return m_remote->removeType(value);
+}
+
+bool SqliteDatabaseManager::pushPending()
+{
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, operation, object_name, old_name, attribute, value FROM outbox ORDER BY id")) {
+        setLastError("SQL error: " + query.lastError().text());
+        return false;
+    }
+
+    // Gli oggetti vengono letti dallo stato attuale: piu' modifiche allo stesso oggetto
+    // diventano una sola scrittura, e un oggetto poi eliminato non viene ricreato
+    QList<ObjectMutation> mutations;
+    qint64 lastId = -1;
+
+    while (query.next()) {
+        lastId = query.value(0).toLongLong();
+        const QString operation = query.value(1).toString();
+
+        if (operation == "delete") {
+            mutations.append(ObjectMutation::remove(query.value(2).toString()));
+        }
+        else if (operation == "upsert") {
+            bool found = false;
+            const HomeObject object = loadObject(query.value(2).toString(), true, &found);
+            const QString oldName = query.value(3).toString();
+            if (found) {
+                mutations.append(ObjectMutation::update(oldName, object));
+            }
+            else if (!oldName.isEmpty()) {
+                mutations.append(ObjectMutation::remove(oldName));
+            }
+        }
+        else if (!replayAttribute(operation, query.value(4).toString(), query.value(5).toString())) {
+            setLastError("Sync failed: " + m_remote->lastError());
+            return false;
+        }
+    }
+
+    if (lastId < 0) {
+        return true;
+    }
+
+    if (!mutations.isEmpty() && !m_remote->applyBatch(mutations)) {
+        setLastError("Sync failed: " + m_remote->lastError());
+        return false;
+    }
+
+    // Solo le righe inviate: modifiche arrivate durante l'invio restano in coda
+    QSqlQuery done(database());
+    done.prepare("DELETE FROM outbox WHERE id <= ?");
+    done.addBindValue(lastId);
+    if (!exec(done)) {
+        return false;
+    }
+
+    LOG_INFO(LogCategory, u8"📤 Sent " << mutations.size() << " local changes to remote");
+    return true;
+}
+
+bool SqliteDatabaseManager::pullRemote()
+{
+    // Anche un elenco non vuoto puo' essere parziale (cache del remoto non aggiornata):
+    // con un errore non si sostituisce nulla, altrimenti le righe mancanti verrebbero cancellate
+    const QList<HomeObject> remoteObjects = m_remote->getAllObjects();
+    if (!m_remote->lastError().isEmpty()) {
+        setLastError("Sync failed: " + m_remote->lastError());
+        return false;
+    }
+
+    // Un vocabolario non letto (timeout, 401) resta quello locale: l'elenco vuoto o vecchio
+    // restituito dal remoto in caso di errore lo cancellerebbe
+    QList<QPair<QString, QStringList>> vocabularies;
+    auto addVocabulary = [this, &vocabularies](const QString& attribute, const QStringList& values) {
+        if (!m_remote->lastError().isEmpty()) {
+            LOG_WARNING(LogCategory, u8"⚠️ Keeping local " << attribute << " values: " << m_remote->lastError());
+            return;
+        }
+        vocabularies.append({ attribute, values });
+    };
+    addVocabulary(ColorAttribute, m_remote->getColors());
+    addVocabulary(MaterialAttribute, m_remote->getMaterials());
+    addVocabulary(TypeAttribute, m_remote->getTypes());
+
+    // Gli oggetti con modifiche locali ancora in coda non vengono sovrascritti
+    QSet<QString> pending;
+    QSqlQuery outbox(database());
+    outbox.exec("SELECT object_name, old_name FROM outbox");
+    while (outbox.next()) {
+        pending.insert(outbox.value(0).toString());
+        pending.insert(outbox.value(1).toString());
+    }
+
+    QSqlDatabase db = database();
+    db.transaction();
+
+    QSqlQuery clear(db);
+    bool ok = clear.exec("DELETE FROM objects WHERE name NOT IN (SELECT object_name FROM outbox"
+                         " UNION SELECT old_name FROM outbox)");
+
+    for (const HomeObject& object : remoteObjects) {
+        if (!ok) {
+            break;
+        }
+        if (!pending.contains(object.name())) {
+            ok = writeObject(object);
+        }
+    }
+
+    for (const auto& vocabulary : std::as_const(vocabularies)) {
+        if (!ok) {
+            break;
+        }
+        QSqlQuery reset(db);
+        reset.prepare("DELETE FROM attributes WHERE attribute = ?");
+        reset.addBindValue(vocabulary.first);
+        ok = exec(reset);
+
+        for (const QString& value : vocabulary.second) {
+            if (!ok) {
+                break;
+            }
+            QSqlQuery insert(db);
+            insert.prepare("INSERT OR IGNORE INTO attributes (attribute, value) VALUES (?, ?)");
+            insert.addBindValue(vocabulary.first);
+            insert.addBindValue(value);
+            ok = exec(insert);
+        }
+    }
+
+    if (!ok || !db.commit()) {
+        db.rollback();
+        return false;
+    }
+
+    setLastError(QString());
+    return true;
+}
+
+QString SqliteDatabaseManager::lastError() const
+{
+    return m_lastError;
+}
+
+void SqliteDatabaseManager::setLastError(const QString& error)
+{
+    m_lastError = error;
+    if (!error.isEmpty()) {
+        LOG_ERROR(LogCategory, u8"❌ Local database error: " << error);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef SQLITEDATABASEMANAGER_H
+#define SQLITEDATABASEMANAGER_H
+
+#include "IDatabaseManager.h"
+#include "homeinventorydata_global.h"
+#include <QObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTimer>
+
+/**
+ * @brief Database locale SQLite: ogni lettura e scrittura viene servita dal disco
+ * Le modifiche finiscono in una coda persistente (outbox) che viene reinviata
+ * al database remoto (es. FirebaseDatabaseManager) quando e' raggiungibile
+ */
+class HOMEINVENTORYDATA_EXPORT SqliteDatabaseManager : public QObject, public IDatabaseManager
+{
+    Q_OBJECT
+
+public:
+    explicit SqliteDatabaseManager(QObject* parent = nullptr);
+    ~SqliteDatabaseManager() override;
+
+    // IDatabaseManager interface (connectionString = percorso del file .sqlite)
+    bool connect(const QString& databasePath) override;
+    void disconnect() override;
+    bool isConnected() const override;
+
+    bool createObject(const HomeObject& object) override;
+    QList<HomeObject> getObjects(int locationId, int sublocationId) override;
+    QList<HomeObject> getAllObjects() override;
+    bool updateObject(const QString& oldName, const HomeObject& newObject) override;
+    bool deleteObject(const QString& objectName) override;
+    bool applyBatch(const QList<ObjectMutation>& mutations) override;
+
+    QList<HomeObject> searchObjects(const QVariantMap& filters) override;
+
+    QByteArray getPicture(const QString& pictureRef) override;
+
+    QStringList getColors() override;
+    QStringList getMaterials() override;
+    QStringList getTypes() override;
+
+    bool addColor(const QString& color) override;
+    bool addMaterial(const QString& material) override;
+    bool addType(const QString& type) override;
+
+    bool removeColor(const QString& color) override;
+    bool removeMaterial(const QString& material) override;
+    bool removeType(const QString& type) override;
+
+    QString lastError() const override;
+
+    // Synchronization with the remote database
+    void setRemote(IDatabaseManager* remote);
+    void setAutoSyncInterval(int msecs); // 0 = disattivata
+    int pendingChanges() const;
+    bool synchronize(); // invia l'outbox e poi riallinea i dati locali con il remoto
+
+signals:
+    void synchronized(bool success);
+
+private:
+    QString m_connectionName;
+    QString m_lastError;
+    IDatabaseManager* m_remote;
+    QTimer m_syncTimer;
+    bool m_isSyncing;
+
+    QSqlDatabase database() const;
+    bool createSchema();
+    bool exec(QSqlQuery& query);
+
+    bool writeObject(const HomeObject& object);
+    bool removeObjectRow(const QString& objectName);
+    bool enqueue(const QString& operation, const QString& objectName, const QString& oldName,
+                 const QString& attribute = QString(), const QString& value = QString());
+    HomeObject loadObject(const QString& objectName, bool withPicture, bool* found = nullptr) const;
+    QList<HomeObject> selectObjects(const QString& whereClause, const QVariantList& bindings) const;
+    static HomeObject rowToObject(const QSqlQuery& query);
+
+    QStringList getAttributes(const QString& attribute);
+    bool addAttribute(const QString& attribute, const QString& value, const QString& duplicateError);
+    bool removeAttribute(const QString& attribute, const QString& value);
+
+    bool pushPending();
+    bool pullRemote();
+    bool replayAttribute(const QString& operation, const QString& attribute, const QString& value);
+
+    void setLastError(const QString& error);
+};
+
+#endif // SQLITEDATABASEMANAGER_H
@@ -0,0 +1,298 @@
+#include "TrigramIndex.h"
+#include <QSet>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <iterator>
+
+QString TrigramIndex::fold(const QString& text)
+{
+    // Decomposizione: "è" diventa "e" + accento combinante, che viene scartato
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+
+    QString folded;
+    folded.reserve(decomposed.size());
+
+    bool pendingSpace = false;
+    for (const QChar c : decomposed) {
+        if (c.category() == QChar::Mark_NonSpacing) {
+            continue;
+        }
+        if (!c.isLetterOrNumber()) {
+            pendingSpace = !folded.isEmpty();
+            continue;
+        }
+        if (pendingSpace) {
+            folded += ' ';
+            pendingSpace = false;
+        }
+        folded += c.toCaseFolded();
+    }
+
+    return folded;
+}
+
+QString TrigramIndex::indexedText(const QString& text)
+{
+    // Gli spazi ai bordi rendono l'inizio e la fine delle parole parte dei trigrammi
+    return ' ' + fold(text) + ' ';
+}
+
+quint64 TrigramIndex::trigramAt(const QString& text, int pos)
+{
+    return (quint64(text.at(pos).unicode()) << 32)
+        | (quint64(text.at(pos + 1).unicode()) << 16)
+        | quint64(text.at(pos + 2).unicode());
+}
+
+void TrigramIndex::index(int row, const QString& text, int field, bool add)
+{
+    Postings& postings = field == Name ? m_names : m_notes;
+
+    for (int i = 0; i + 3 <= text.size(); ++i) {
+        const quint64 trigram = trigramAt(text, i);
+        if (add) {
+            // Caricamento completo: righe crescenti, l'inserimento e' in coda
+            QList<int>& rows = postings[trigram];
+            auto pos = std::lower_bound(rows.begin(), rows.end(), row);
+            if (pos == rows.end() || *pos != row) {
+                rows.insert(pos, row);
+            }
+        }
+        else {
+            auto it = postings.find(trigram);
+            if (it == postings.end()) {
+                continue;
+            }
+            auto pos = std::lower_bound(it->begin(), it->end(), row);
+            if (pos != it->end() && *pos == row) {
+                it->erase(pos);
+            }
+            if (it->isEmpty()) {
+                postings.erase(it);
+            }
+        }
+    }
+}
+
+void TrigramIndex::insert(int row, const HomeObject& object)
+{
+    if (row >= m_texts.size()) {
+        m_texts.resize(row + 1);
+    }
+
+    Text& text = m_texts[row];
+    text.name = indexedText(object.name());
+    text.notes = indexedText(object.notes());
+
+    index(row, text.name, Name, true);
+    index(row, text.notes, Notes, true);
+    m_live.set(row);
+}
+
+void TrigramIndex::remove(int row)
+{
+    if (row >= m_texts.size() || !m_live.test(row)) {
+        return;
+    }
+
+    // Si usano i testi indicizzati, non quelli dell'oggetto: devono coincidere con l'inserimento
+    Text& text = m_texts[row];
+    index(row, text.name, Name, false);
+    index(row, text.notes, Notes, false);
+    text = Text();
+    m_live.reset(row);
+}
+
+void TrigramIndex::clear()
+{
+    m_texts.clear();
+    m_names.clear();
+    m_notes.clear();
+    m_live.clear();
+}
+
+ObjectBitmap TrigramIndex::find(const QString& folded, int fields) const
+{
+    if (folded.isEmpty() || folded == " ") {
+        return m_live;
+    }
+
+    ObjectBitmap result;
+
+    // I trigrammi sono condizione necessaria ma non sufficiente: si verifica il testo
+    auto verify = [this, &folded, &result](const QList<int>& rows, QString Text::* field) {
+        for (int row : rows) {
+            if ((m_texts.at(row).*field).contains(folded)) {
+                result.set(row);
+            }
+        }
+    };
+
+    if (fields & Name) {
+        verify(candidates(folded, m_names), &Text::name);
+    }
+    if (fields & Notes) {
+        verify(candidates(folded, m_notes), &Text::notes);
+    }
+
+    return result;
+}
+
+QList<int> TrigramIndex::candidates(const QString& folded, const Postings& postings) const
+{
+    QList<int> rows;
+
+    // Query corte: nessun trigramma completo, si verificano tutte le righe
+    if (folded.size() < 3) {
+        rows.reserve(m_live.count());
+        m_live.forEach([&rows](int row) {
+            rows.append(row);
+        });
+        return rows;
+    }
+
+    QSet<quint64> trigrams;
+    for (int i = 0; i + 3 <= folded.size(); ++i) {
+        trigrams.insert(trigramAt(folded, i));
+    }
+
+    QVarLengthArray<const QList<int>*, 32> lists;
+    for (quint64 trigram : std::as_const(trigrams)) {
+        auto it = postings.constFind(trigram);
+        if (it == postings.cend()) {
+            return rows;
+        }
+        lists.append(&*it);
+    }
+
+    // Dalla lista piu' corta: le intersezioni successive possono solo ridurla
+    std::sort(lists.begin(), lists.end(), [](const QList<int>* a, const QList<int>* b) {
+        return a->size() < b->size();
+    });
+    rows = *lists.first();
+    for (int i = 1; i < lists.size() && !rows.isEmpty(); ++i) {
+        QList<int> common;
+        common.reserve(rows.size());
+        std::set_intersection(rows.cbegin(), rows.cend(), lists.at(i)->cbegin(), lists.at(i)->cend(),
+                              std::back_inserter(common));
+        rows = std::move(common);
+    }
+    return rows;
+}
+
+ObjectBitmap TrigramIndex::substring(const QString& query, int fields) const
+{
+    return find(fold(query), fields);
+}
+
+ObjectBitmap TrigramIndex::prefix(const QString& query, int fields) const
+{
+    return find(' ' + fold(query), fields);
+}
+
+int TrigramIndex::editDistance(const QString& a, const QString& b, int limit)
+{
+    if (qAbs(a.size() - b.size()) > limit) {
+        return limit + 1;
+    }
+
+    QVarLengthArray<int, 64> rows(2 * (b.size() + 1));
+    int* previous = rows.data();
+    int* current = previous + b.size() + 1;
+    for (int j = 0; j <= b.size(); ++j) {
+        previous[j] = j;
+    }
+
+    for (int i = 1; i <= a.size(); ++i) {
+        current[0] = i;
+        int rowMin = current[0];
+        for (int j = 1; j <= b.size(); ++j) {
+            const int cost = a.at(i - 1) == b.at(j - 1) ? 0 : 1;
+            current[j] = std::min({ previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost });
+            rowMin = std::min(rowMin, current[j]);
+        }
+        // Nessuna cella sotto il limite: la distanza finale non puo' rientrarvi
+        if (rowMin > limit) {
+            return limit + 1;
+        }
+        std::swap(previous, current);
+    }
+
+    return previous[b.size()];
+}
+
+QList<TrigramIndex::Match> TrigramIndex::fuzzy(const QString& query, int maxDistance, int fields) const
+{
+    const QString folded = fold(query);
+    QList<Match> matches;
+
+    if (folded.isEmpty()) {
+        return matches;
+    }
+
+    // Le sottostringhe esatte hanno distanza 0
+    const ObjectBitmap exact = substring(query, fields);
+    exact.forEach([&matches](int row) {
+        matches.append({ row, 0 });
+    });
+
+    // Ogni modifica altera al massimo 3 trigrammi: un candidato deve condividerne almeno
+    // (trigrammi della query - 3 * maxDistance)
+    const QString padded = ' ' + folded + ' ';
+    QSet<quint64> trigrams;
+    for (int i = 0; i + 3 <= padded.size(); ++i) {
+        trigrams.insert(trigramAt(padded, i));
+    }
+    const int required = qMax(1, int(trigrams.size()) - 3 * maxDistance);
+
+    QHash<int, int> shared;
+    for (quint64 trigram : std::as_const(trigrams)) {
+        auto count = [&shared, &exact](const QList<int>& rows) {
+            for (int row : rows) {
+                if (!exact.test(row)) {
+                    ++shared[row];
+                }
+            }
+        };
+        if (fields & Name) {
+            count(m_names.value(trigram));
+        }
+        if (fields & Notes) {
+            count(m_notes.value(trigram));
+        }
+    }
+
+    // Distanza dalla parola (o dal testo intero) piu' vicina
+    auto bestDistance = [&folded, maxDistance](const QString& text) {
+        int best = editDistance(folded, text.trimmed(), maxDistance);
+        const QStringList words = text.split(' ', Qt::SkipEmptyParts);
+        for (const QString& word : words) {
+            best = qMin(best, editDistance(folded, word, maxDistance));
+        }
+        return best;
+    };
+
+    for (auto it = shared.cbegin(); it != shared.cend(); ++it) {
+        if (it.value() < required) {
+            continue;
+        }
+
+        const Text& text = m_texts.at(it.key());
+        int distance = maxDistance + 1;
+        if (fields & Name) {
+            distance = qMin(distance, bestDistance(text.name));
+        }
+        if (fields & Notes) {
+            distance = qMin(distance, bestDistance(text.notes));
+        }
+        if (distance <= maxDistance) {
+            matches.append({ it.key(), distance });
+        }
+    }
+
+    std::stable_sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.row < b.row;
+    });
+    return matches;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include "homeinventorydata_global.h"
+#include "HomeObject.h"
+#include "ObjectBitmap.h"
+#include <QHash>
+#include <QList>
+#include <QString>
+
+/**
+ * @brief Indice a trigrammi su nome e note degli oggetti
+ * Il testo viene normalizzato (minuscole, senza accenti, punteggiatura come spazio)
+ * e scomposto in trigrammi; ogni trigramma ha l'elenco ordinato delle righe che lo contengono
+ * (4 byte per occorrenza: una bitmap per trigramma costerebbe righe / 8 byte anche se quasi vuota)
+ * Supporta ricerca per sottostringa, per prefisso di parola e approssimata (distanza di edit)
+ */
+class HOMEINVENTORYDATA_EXPORT TrigramIndex
+{
+public:
+    enum Field
+    {
+        Name = 0x1,
+        Notes = 0x2,
+        AllFields = Name | Notes
+    };
+
+    struct Match
+    {
+        int row;
+        int distance; // 0 = corrispondenza esatta della sottostringa
+    };
+
+    // Normalizzazione usata sia per l'indice sia per le query
+    static QString fold(const QString& text);
+
+    // Maintenance (incrementale, chiamata dal contenitore per ogni create/update/delete)
+    void insert(int row, const HomeObject& object);
+    void remove(int row);
+    void clear();
+
+    // Lookups
+    ObjectBitmap substring(const QString& query, int fields = Name) const;
+    ObjectBitmap prefix(const QString& query, int fields = Name) const; // inizio di una parola
+    QList<Match> fuzzy(const QString& query, int maxDistance = 2, int fields = Name) const;
+
+private:
+    struct Text
+    {
+        QString name;  // " testo normalizzato "
+        QString notes;
+    };
+
+    using Postings = QHash<quint64, QList<int>>; // trigramma -> righe in ordine crescente
+
+    ObjectBitmap find(const QString& folded, int fields) const;
+    QList<int> candidates(const QString& folded, const Postings& postings) const;
+    void index(int row, const QString& text, int field, bool add);
+    static QString indexedText(const QString& text);
+    static quint64 trigramAt(const QString& text, int pos);
+    static int editDistance(const QString& a, const QString& b, int limit);
+
+    QList<Text> m_texts;                   // riga -> testi normalizzati
+    Postings m_names; // nome
+    Postings m_notes; // note
+    ObjectBitmap m_live;
+};
+
+#endif // TRIGRAMINDEX_H